@@ -2,10 +2,26 @@
 
 #extension GL_EXT_multiview : enable
 #extension GL_EXT_debug_printf : enable
+#extension GL_GOOGLE_include_directive : enable
 
-layout(binding = 0) uniform IndividualUbo {
+#include "assets/shaders/vertex_format.h"
+
+struct ObjectData {
     mat4 modelMat;
-} individualUbo;
+    vec4 positionScale;
+    vec4 positionBias;
+    vec4 materialColor;
+    vec4 materialProperties;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// Index of the object data of every instance, instances of one draw are consecutive
+layout(std430, binding = 3) readonly buffer InstanceObjects {
+    uint instanceObjects[];
+};
 
 layout(binding = 1) uniform CommonUbo {
     vec3 camPos;
@@ -13,17 +29,25 @@ layout(binding = 1) uniform CommonUbo {
     mat4 projMats[2];
 } commonUbo;
 
-layout(push_constant) uniform PushConst {
-    vec3 objPos;
-} pushConst;
-
+#if PACKED_VERTICES
+layout(location = 0) in vec4 inPackedPos;
+layout(location = 1) in vec2 inPackedNormal;
+#else
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
+#endif // PACKED_VERTICES
 
 layout(location = 0) out vec3 outColor;
 
 void main()
 {
+    ObjectData object = objects[instanceObjects[gl_InstanceIndex]];
+
+#if PACKED_VERTICES
+    vec3 inPos = inPackedPos.xyz * object.positionScale.xyz + object.positionBias.xyz;
+    vec3 inNormal = decodeOctahedral(inPackedNormal);
+#endif // PACKED_VERTICES
+
     mat4 cameraMat = mat4(1.0);
     cameraMat[3] = vec4(commonUbo.camPos, 1.0);
 
@@ -31,8 +55,8 @@ void main()
         commonUbo.projMats[gl_ViewIndex] *
         commonUbo.viewMats[gl_ViewIndex] *
         cameraMat *
-        individualUbo.modelMat *
-        vec4(pushConst.objPos + inPos, 1.0);
+        object.modelMat *
+        vec4(inPos, 1.0);
 
-    outColor = mat3(individualUbo.modelMat) * normalize(inNormal);
+    outColor = mat3(object.modelMat) * normalize(inNormal);
 }
\ No newline at end of file
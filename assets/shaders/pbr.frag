@@ -9,6 +9,7 @@
 
 layout (location = 0) in vec3 inWorldPos;
 layout (location = 1) in vec3 inNormal;
+layout (location = 2) flat in uint inObjectIndex;
 layout (location = 0) out vec4 outColor;
 
 layout (binding = 1) uniform CommonUbo {
@@ -21,17 +22,21 @@ layout (binding = 2) uniform LightsUbo {
     vec3 positions[LIGHTS_N];
 } lightsUbo;
 
-layout(push_constant) uniform Material {
-    layout(offset = 16) float r;
-    layout(offset = 20) float g;
-    layout(offset = 24) float b;
-    layout(offset = 32) float roughness;
-    layout(offset = 36) float metallic;
-} material;
+struct ObjectData {
+    mat4 modelMat;
+    vec4 positionScale;
+    vec4 positionBias;
+    vec4 materialColor;
+    vec4 materialProperties;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
 
 vec3 materialcolor()
 {
-    return vec3(material.r, material.g, material.b);
+    return objects[inObjectIndex].materialColor.rgb;
 }
 
 float D_GGX(float dotNH, float roughness)
@@ -104,7 +109,7 @@ void main()
     for (int i = 0; i < lightsUbo.positions.length(); i++)
     {
         vec3 L = normalize(lightsUbo.positions[i] - inWorldPos);
-        Lo += BRDF(L, V, N, material.metallic, material.roughness);
+        Lo += BRDF(L, V, N, objects[inObjectIndex].materialProperties.y, objects[inObjectIndex].materialProperties.x);
     };
 
     vec3 color = materialcolor() * 0.02;
@@ -2,10 +2,26 @@
 
 #extension GL_EXT_multiview : enable
 #extension GL_EXT_debug_printf : enable
+#extension GL_GOOGLE_include_directive : enable
 
-layout(binding = 0) uniform IndividualUbo {
+#include "assets/shaders/vertex_format.h"
+
+struct ObjectData {
     mat4 modelMat;
-} individualUbo;
+    vec4 positionScale;
+    vec4 positionBias;
+    vec4 materialColor;
+    vec4 materialProperties;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// Index of the object data of every instance, instances of one draw are consecutive
+layout(std430, binding = 3) readonly buffer InstanceObjects {
+    uint instanceObjects[];
+};
 
 layout (binding = 1) uniform CommonUbo {
     vec3 camPos;
@@ -13,31 +29,40 @@ layout (binding = 1) uniform CommonUbo {
     mat4 projMats[2];
 } commonUbo;
 
+#if PACKED_VERTICES
+layout (location = 0) in vec4 inPackedPos;
+layout (location = 1) in vec2 inPackedNormal;
+#else
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec3 inColor;
+#endif // PACKED_VERTICES
 
 layout (location = 0) out vec3 outWorldPos;
 layout (location = 1) out vec3 outNormal;
-
-layout(push_constant) uniform PushConst {
-    vec3 objPos;
-} pushConst;
+layout (location = 2) flat out uint outObjectIndex;
 
 void main()
 {
+    outObjectIndex = instanceObjects[gl_InstanceIndex];
+    ObjectData object = objects[outObjectIndex];
+
+#if PACKED_VERTICES
+    vec3 inPos = inPackedPos.xyz * object.positionScale.xyz + object.positionBias.xyz;
+    vec3 inNormal = decodeOctahedral(inPackedNormal);
+#endif // PACKED_VERTICES
+
     mat4 cameraMat = mat4(1.0);
     cameraMat[3] = vec4(commonUbo.camPos, 1.0);
 
-    vec3 worldPos = inPos + pushConst.objPos;
+    vec3 worldPos = vec3(object.modelMat * vec4(inPos, 1.0));
     outWorldPos = worldPos;
-    outNormal = mat3(individualUbo.modelMat) * inNormal;
+    outNormal = mat3(object.modelMat) * inNormal;
 
     gl_Position =
         commonUbo.projMats[gl_ViewIndex] *
         commonUbo.viewMats[gl_ViewIndex] *
         cameraMat *
-        individualUbo.modelMat *
         vec4(worldPos, 1.0);
 
 }
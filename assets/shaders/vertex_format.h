@@ -0,0 +1,17 @@
+#pragma once
+
+// Packed vertices store snorm16 positions, dequantized with the per-mesh scale and bias,
+// and octahedral snorm16 normals, instead of the float vectors
+#define PACKED_VERTICES 1
+
+#ifndef __cplusplus
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-normal.z, 0.0);
+    normal.x += (normal.x >= 0.0) ? -t : t;
+    normal.y += (normal.y >= 0.0) ? -t : t;
+
+    return normalize(normal);
+}
+#endif // __cplusplus
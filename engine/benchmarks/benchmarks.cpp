@@ -0,0 +1,675 @@
+#include "tsengine/ecs/ecs.h"
+#include "tsengine/ecs/components/transform_component.hpp"
+#include "tsengine/ecs/components/parent_component.hpp"
+#include "ecs/systems/transform_system.hpp"
+#include "tsengine/ecs/components/mesh_component.hpp"
+#include "core/frustum_culling.h"
+#include "core/aabb_tree.h"
+#include "core/mesh_processing.h"
+#include "core/draw_commands.h"
+#include "tsengine/job_system.h"
+#include "tsengine/event_bus.hpp"
+#include "tsengine/math_batch.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <numeric>
+#include <random>
+
+namespace
+{
+constexpr std::array entitiesNumbers{1'000u, 10'000u, 100'000u};
+constexpr std::array spatialIndexProxiesNumbers{10'000u, 100'000u, 1'000'000u};
+
+template<typename TFunc>
+double measure(TFunc&& func, const size_t iterations = 10)
+{
+    std::chrono::duration<double, std::milli> total{};
+    for (size_t i{}; i < iterations; ++i)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        func();
+        total += std::chrono::high_resolution_clock::now() - start;
+    }
+
+    return total.count() / static_cast<double>(iterations);
+}
+
+// Keeps results of the measured code alive, so the compiler can't optimize it away
+volatile float gSink;
+
+void report(const std::string_view name, const size_t entitiesNumber, const double milliseconds)
+{
+    std::cout << std::format("{:<40}{:>10}{:>14.4f} ms\n", name, entitiesNumber, milliseconds);
+}
+
+// Pool implementation from before the sparse set, kept only as a baseline
+template <typename T>
+class HashMapPool
+{
+    std::unordered_map<ts::Id, ts::Id> entityIdToIndex;
+    std::unordered_map<ts::Id, ts::Id> indexToEntityId;
+    std::vector<T> data;
+    size_t size{};
+
+public:
+    HashMapPool(size_t capacity = 100) : data(capacity, T{}) {}
+
+    void set(const ts::Id entityId, const T object)
+    {
+        if (entityIdToIndex.find(entityId) != entityIdToIndex.end())
+        {
+            data.at(entityIdToIndex[entityId]) = object;
+        }
+        else
+        {
+            const auto index = static_cast<ts::Id>(size);
+            entityIdToIndex.emplace(entityId, index);
+            indexToEntityId.emplace(index, entityId);
+            if (index >= data.capacity())
+            {
+                data.resize(size * 2);
+            }
+            data.at(index) = object;
+            size++;
+        }
+    }
+
+    void remove(const ts::Id entityId)
+    {
+        const auto indexOfRemoved = entityIdToIndex[entityId];
+        const auto indexOfLast = static_cast<ts::Id>(size - 1);
+        data.at(indexOfRemoved) = data[indexOfLast];
+
+        const auto entityIdOfLastElement = indexToEntityId[indexOfLast];
+        entityIdToIndex.at(entityIdOfLastElement) = indexOfRemoved;
+        indexToEntityId.at(indexOfRemoved) = entityIdOfLastElement;
+
+        entityIdToIndex.erase(entityId);
+        indexToEntityId.erase(indexOfLast);
+
+        size--;
+    }
+
+    T& get(const ts::Id entityId)
+    {
+        return data[entityIdToIndex[entityId]];
+    }
+};
+
+template<typename TPool>
+void poolBenchmark(const std::string_view poolName)
+{
+    for (const auto entitiesNumber : entitiesNumbers)
+    {
+        std::vector<ts::Id> entityIds(entitiesNumber);
+        std::iota(entityIds.begin(), entityIds.end(), ts::Id{});
+        std::ranges::shuffle(entityIds, std::mt19937{entitiesNumber});
+
+        TPool pool;
+        const auto setTime = measure([&] {
+            for (const auto entityId : entityIds)
+            {
+                pool.set(entityId, ts::TransformComponent{ts::math::Vec3{static_cast<float>(entityId)}});
+            }
+        });
+
+        const auto getTime = measure([&] {
+            float checksum{};
+            for (const auto entityId : entityIds)
+            {
+                checksum += pool.get(entityId).getPosition().x;
+            }
+            gSink = checksum;
+        });
+
+        const auto removeTime = measure([&] {
+            TPool removedPool;
+            for (const auto entityId : entityIds)
+            {
+                removedPool.set(entityId, {});
+            }
+
+            for (const auto entityId : entityIds)
+            {
+                removedPool.remove(entityId);
+            }
+        }, 1);
+
+        report(std::format("{} set", poolName), entitiesNumber, setTime);
+        report(std::format("{} get", poolName), entitiesNumber, getTime);
+        report(std::format("{} set + remove", poolName), entitiesNumber, removeTime);
+    }
+}
+
+void jobSystemBenchmark()
+{
+    static constexpr size_t itemsNumber{1'000'000};
+    std::vector<float> values(itemsNumber);
+
+    const size_t maxThreadsNumber = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threadsNumber{1};; threadsNumber = std::min(threadsNumber * 2, maxThreadsNumber))
+    {
+        ts::JobSystem jobSystem{threadsNumber};
+        const auto time = measure([&] {
+            jobSystem.parallelFor(0, itemsNumber, [&](const size_t i) {
+                auto value = static_cast<float>(i);
+                for (size_t step{}; step < 32; ++step)
+                {
+                    value = std::sqrt(value + std::sin(value));
+                }
+                values[i] = value;
+            });
+            gSink = values.back();
+        });
+
+        report(std::format("Job system parallelFor ({} threads)", threadsNumber), itemsNumber, time);
+
+        if (threadsNumber == maxThreadsNumber)
+        {
+            break;
+        }
+    }
+}
+
+template<typename TMultiply, typename TInverse>
+void mat4Benchmark(const std::string_view backendName, TMultiply&& multiply, TInverse&& inverse)
+{
+    std::mt19937 generator{};
+    std::uniform_real_distribution<float> distribution{-10.f, 10.f};
+
+    for (const auto entitiesNumber : entitiesNumbers)
+    {
+        std::vector<ts::math::Mat4> matrices(entitiesNumber);
+        for (auto& matrix : matrices)
+        {
+            for (auto& column : matrix.data)
+            {
+                column = {distribution(generator), distribution(generator), distribution(generator), distribution(generator)};
+            }
+        }
+        std::vector<ts::math::Mat4> results(entitiesNumber);
+
+        // The view projection and model matrix product is done per entity and eye
+        const auto viewProjection = matrices.front();
+        const auto multiplyTime = measure([&] {
+            for (size_t i{}; i < entitiesNumber; ++i)
+            {
+                results[i] = multiply(viewProjection, matrices[i]);
+            }
+            gSink = results.back().data[3].w;
+        });
+
+        const auto inverseTime = measure([&] {
+            for (size_t i{}; i < entitiesNumber; ++i)
+            {
+                results[i] = inverse(matrices[i]);
+            }
+            gSink = results.back().data[3].w;
+        });
+
+        report(std::format("Mat4 {} multiply", backendName), entitiesNumber, multiplyTime);
+        report(std::format("Mat4 {} inverse", backendName), entitiesNumber, inverseTime);
+    }
+}
+
+void mathBatchBenchmark()
+{
+    std::mt19937 generator{};
+    std::uniform_real_distribution<float> distribution{-10.f, 10.f};
+
+    for (const auto entitiesNumber : entitiesNumbers)
+    {
+        std::vector<ts::math::Vec3> points(entitiesNumber);
+        std::vector<ts::math::Mat4> lhsMatrices(entitiesNumber), rhsMatrices(entitiesNumber);
+        ts::math::Vec3Array pointsArray;
+        ts::math::Mat4Array lhsMatricesArray, rhsMatricesArray;
+        pointsArray.resize(entitiesNumber);
+        lhsMatricesArray.resize(entitiesNumber);
+        rhsMatricesArray.resize(entitiesNumber);
+        for (size_t i{}; i < entitiesNumber; ++i)
+        {
+            points[i] = {distribution(generator), distribution(generator), distribution(generator)};
+            for (auto* const matrix : {&lhsMatrices[i], &rhsMatrices[i]})
+            {
+                for (auto& column : matrix->data)
+                {
+                    column = {distribution(generator), distribution(generator), distribution(generator), distribution(generator)};
+                }
+            }
+            pointsArray.set(i, points[i]);
+            lhsMatricesArray.set(i, lhsMatrices[i]);
+            rhsMatricesArray.set(i, rhsMatrices[i]);
+        }
+
+        const auto& transformMatrix = lhsMatrices.front();
+        std::vector<ts::math::Vec3> transformedPoints(entitiesNumber);
+        const auto loopTransformTime = measure([&] {
+            for (size_t i{}; i < entitiesNumber; ++i)
+            {
+                transformedPoints[i] = transformMatrix * ts::math::Vec4{points[i].x, points[i].y, points[i].z, 1.f};
+            }
+            gSink = transformedPoints.back().x;
+        });
+
+        ts::math::Vec3Array transformedPointsArray;
+        const auto batchTransformTime = measure([&] {
+            ts::math::transformPoints(transformMatrix, pointsArray, transformedPointsArray);
+            gSink = transformedPointsArray.x.back();
+        });
+
+        std::vector<ts::math::Mat4> multipliedMatrices(entitiesNumber);
+        const auto loopMultiplyTime = measure([&] {
+            for (size_t i{}; i < entitiesNumber; ++i)
+            {
+                multipliedMatrices[i] = lhsMatrices[i] * rhsMatrices[i];
+            }
+            gSink = multipliedMatrices.back().data[3].w;
+        });
+
+        ts::math::Mat4Array multipliedMatricesArray;
+        const auto batchMultiplyTime = measure([&] {
+            ts::math::multiply(lhsMatricesArray, rhsMatricesArray, multipliedMatricesArray);
+            gSink = multipliedMatricesArray.get(entitiesNumber - 1).data[3].w;
+        });
+
+        const auto loopNormalizeTime = measure([&] {
+            for (auto& point : points)
+            {
+                point = ts::math::normalize(point);
+            }
+            gSink = points.back().x;
+        });
+
+        const auto batchNormalizeTime = measure([&] {
+            ts::math::normalize(pointsArray);
+            gSink = pointsArray.x.back();
+        });
+
+        report("Transform points loop", entitiesNumber, loopTransformTime);
+        report("Transform points batch", entitiesNumber, batchTransformTime);
+        report("Mat4 pairwise multiply loop", entitiesNumber, loopMultiplyTime);
+        report("Mat4 pairwise multiply batch", entitiesNumber, batchMultiplyTime);
+        report("Normalize loop", entitiesNumber, loopNormalizeTime);
+        report("Normalize batch", entitiesNumber, batchNormalizeTime);
+    }
+}
+
+void transformSystemBenchmark()
+{
+    static constexpr size_t nodesNumber{100'000};
+    static constexpr size_t childrenNumber{4};
+
+    for (const auto storageMode : {ts::StorageMode::POOLS, ts::StorageMode::ARCHETYPES})
+    {
+        ts::Registry registry{storageMode};
+        registry.addSystem<ts::TransformSystem>();
+
+        // Every node has a few children, so the tree is about 8 levels deep
+        std::vector<ts::Entity> entities;
+        entities.reserve(nodesNumber);
+        for (size_t i{}; i < nodesNumber; ++i)
+        {
+            auto entity = registry.createEntity();
+            entity.addComponent<ts::TransformComponent>(ts::math::Vec3{1.f});
+            if (i > 0)
+            {
+                entity.addComponent<ts::ParentComponent>(entities[(i - 1) / childrenNumber]);
+            }
+            entities.push_back(entity);
+        }
+        registry.update();
+
+        auto& system = registry.getSystem<ts::TransformSystem>();
+        const auto sortTime = measure([&] { system.update(); }, 1);
+
+        const auto unchangedTime = measure([&] { system.update(); });
+
+        std::mt19937 generator{};
+        std::uniform_int_distribution<size_t> distribution{0, nodesNumber - 1};
+        const auto fewChangedTime = measure([&] {
+            for (size_t i{}; i < 100; ++i)
+            {
+                auto& transform = entities[distribution(generator)].getComponent<ts::TransformComponent>();
+                transform.setPosition(transform.getPosition() + ts::math::Vec3{0.1f});
+            }
+            system.update();
+        });
+
+        const auto allChangedTime = measure([&] {
+            auto& transform = entities.front().getComponent<ts::TransformComponent>();
+            transform.setPosition(transform.getPosition() + ts::math::Vec3{0.1f});
+            system.update();
+        });
+
+        const auto modeName = (storageMode == ts::StorageMode::POOLS) ? "pools" : "archetypes";
+        report(std::format("Transform system sort ({})", modeName), nodesNumber, sortTime);
+        report(std::format("Transform system unchanged ({})", modeName), nodesNumber, unchangedTime);
+        report(std::format("Transform system 100 changed ({})", modeName), nodesNumber, fewChangedTime);
+        report(std::format("Transform system root changed ({})", modeName), nodesNumber, allChangedTime);
+    }
+}
+void cullingBenchmark()
+{
+    // Perspective with the 90 degrees field of view looking down the -z, the clip depth is in [-w, w]
+    constexpr float nearClip{0.1f}, farClip{100.f};
+    const ts::math::Mat4 projection{
+        1.f, 0.f, 0.f, 0.f,
+        0.f, -1.f, 0.f, 0.f,
+        0.f, 0.f, -(farClip + nearClip) / (farClip - nearClip), -1.f,
+        0.f, 0.f, -(farClip * (nearClip + nearClip)) / (farClip - nearClip), 0.f,
+    };
+    const auto frustum = ts::frustum::make(projection);
+
+    for (const auto entitiesNumber : entitiesNumbers)
+    {
+        ts::Registry registry;
+        registry.addSystem<ts::TransformSystem>();
+
+        std::mt19937 generator{};
+        std::uniform_real_distribution<float> distribution{-100.f, 100.f};
+        std::vector<ts::Entity> entities;
+        std::vector<ts::math::Vec3> centers;
+        for (size_t i{}; i < entitiesNumber; ++i)
+        {
+            centers.push_back({distribution(generator), distribution(generator), distribution(generator)});
+
+            auto entity = registry.createEntity();
+            entity.addComponent<ts::TransformComponent>(centers.back());
+            entity.addComponent<ts::MeshComponent>();
+            entity.getComponent<ts::MeshComponent>().boundsMin = ts::math::Vec3{-0.5f};
+            entity.getComponent<ts::MeshComponent>().boundsMax = ts::math::Vec3{0.5f};
+            entities.push_back(entity);
+        }
+        registry.update();
+        registry.getSystem<ts::TransformSystem>().update();
+
+        const auto scalarTime = measure([&] {
+            size_t visible{};
+            for (const auto& center : centers)
+            {
+                visible += ts::frustum::isBoxVisible(frustum, center, ts::math::Vec3{0.5f});
+            }
+            gSink = static_cast<float>(visible);
+        });
+
+        ts::FrustumCuller culler;
+        culler.cull(frustum, entities, 0);
+        const auto packedTime = measure([&] {
+            culler.cull(frustum, entities, 0);
+            gSink = static_cast<float>(culler.getStatistics().visible);
+        });
+
+        report("Frustum culling scalar", entitiesNumber, scalarTime);
+        report("Frustum culling packed", entitiesNumber, packedTime);
+    }
+}
+
+void spatialIndexBenchmark()
+{
+    constexpr float nearClip{0.1f}, farClip{100.f};
+    const ts::math::Mat4 projection{
+        1.f, 0.f, 0.f, 0.f,
+        0.f, -1.f, 0.f, 0.f,
+        0.f, 0.f, -(farClip + nearClip) / (farClip - nearClip), -1.f,
+        0.f, 0.f, -(farClip * (nearClip + nearClip)) / (farClip - nearClip), 0.f,
+    };
+    const auto frustum = ts::frustum::make(projection);
+    constexpr size_t queriesNumber{100};
+
+    for (const auto proxiesNumber : spatialIndexProxiesNumbers)
+    {
+        // Level spread on a ground much wider than its height, with the same density at every size
+        const auto groundSize = 10.f * std::sqrt(static_cast<float>(proxiesNumber));
+        std::mt19937 generator{};
+        std::uniform_real_distribution<float> groundDistribution{-groundSize / 2.f, groundSize / 2.f};
+        std::uniform_real_distribution<float> heightDistribution{-10.f, 10.f};
+        std::uniform_real_distribution<float> sizeDistribution{0.5f, 3.f};
+        std::uniform_real_distribution<float> unitDistribution{-1.f, 1.f};
+
+        std::vector<ts::Aabb> boxes;
+        for (size_t i{}; i < proxiesNumber; ++i)
+        {
+            const ts::math::Vec3 min{groundDistribution(generator), heightDistribution(generator), groundDistribution(generator)};
+            boxes.push_back({min, {min.x + sizeDistribution(generator), min.y + sizeDistribution(generator), min.z + sizeDistribution(generator)}});
+        }
+        std::vector<uint32_t> userData(proxiesNumber);
+        std::iota(userData.begin(), userData.end(), 0);
+
+        ts::AabbTree tree;
+        const auto buildTime = measure([&] { tree.build(boxes, userData); }, 3);
+
+        const auto insertTime = measure([&] {
+            ts::AabbTree insertedTree;
+            for (uint32_t i{}; i < proxiesNumber; ++i)
+            {
+                insertedTree.createProxy(boxes[i], i);
+            }
+            gSink = static_cast<float>(insertedTree.getHeight());
+        }, 3);
+
+        // Every proxy moves a little, which is cheaper to refit than to move one by one
+        auto movedBoxes = boxes;
+        const auto refitTime = measure([&] {
+            for (uint32_t i{}; i < proxiesNumber; ++i)
+            {
+                movedBoxes[i].min.x += 0.01f;
+                movedBoxes[i].max.x += 0.01f;
+                tree.setProxyBounds(i, movedBoxes[i]);
+            }
+            tree.refit();
+        });
+
+        // One percent of the proxies moves far away from their fat boxes
+        tree.build(boxes, userData);
+        const auto moveTime = measure([&] {
+            for (uint32_t i{}; i < proxiesNumber; i += 100)
+            {
+                boxes[i].min.x += 5.f;
+                boxes[i].max.x += 5.f;
+                tree.moveProxy(i, boxes[i]);
+            }
+        });
+
+        const auto linearFrustumTime = measure([&] {
+            size_t visible{};
+            for (const auto& box : boxes)
+            {
+                const ts::math::Vec3 center{(box.min.x + box.max.x) / 2.f, (box.min.y + box.max.y) / 2.f, (box.min.z + box.max.z) / 2.f};
+                const ts::math::Vec3 extent{(box.max.x - box.min.x) / 2.f, (box.max.y - box.min.y) / 2.f, (box.max.z - box.min.z) / 2.f};
+                visible += ts::frustum::isBoxVisible(frustum, center, extent);
+            }
+            gSink = static_cast<float>(visible);
+        });
+
+        const auto frustumTime = measure([&] {
+            size_t visible{};
+            tree.queryFrustum(frustum, [&visible](const uint32_t) { ++visible; });
+            gSink = static_cast<float>(visible);
+        });
+
+        const auto sphereTime = measure([&] {
+            size_t found{};
+            for (size_t i{}; i < queriesNumber; ++i)
+            {
+                const ts::math::Vec3 center{groundDistribution(generator), 0.f, groundDistribution(generator)};
+                tree.querySphere(center, 5.f, [&found](const uint32_t) { ++found; });
+            }
+            gSink = static_cast<float>(found);
+        });
+
+        const auto raycastTime = measure([&] {
+            auto distances = 0.f;
+            for (size_t i{}; i < queriesNumber; ++i)
+            {
+                const ts::Ray ray{
+                    {groundDistribution(generator), 0.f, groundDistribution(generator)},
+                    ts::math::normalize(ts::math::Vec3{unitDistribution(generator), 0.f, unitDistribution(generator)})};
+                tree.raycast(ray, 100.f, [&distances](const uint32_t, const float distance) {
+                    distances += distance;
+                    return distance;
+                });
+            }
+            gSink = distances;
+        });
+
+        report("Spatial index build", proxiesNumber, buildTime);
+        report("Spatial index insert all", proxiesNumber, insertTime);
+        report("Spatial index refit all", proxiesNumber, refitTime);
+        report("Spatial index move 1%", proxiesNumber, moveTime);
+        report("Spatial index frustum linear", proxiesNumber, linearFrustumTime);
+        report("Spatial index frustum query", proxiesNumber, frustumTime);
+        report("Spatial index 100 sphere queries", proxiesNumber, sphereTime);
+        report("Spatial index 100 raycasts", proxiesNumber, raycastTime);
+    }
+}
+void lodBenchmark()
+{
+    // Closed sphere of the given resolution, like the meshes of the imported models
+    const auto makeSphere = [](const uint32_t segments, const uint32_t rings) {
+        std::vector<ts::MeshComponent::Vertex> vertices;
+        for (uint32_t ring{}; ring <= rings; ++ring)
+        {
+            const auto theta = std::numbers::pi_v<float> * static_cast<float>(ring) / static_cast<float>(rings);
+            for (uint32_t segment{}; segment < segments; ++segment)
+            {
+                const auto phi = 2.f * std::numbers::pi_v<float> * static_cast<float>(segment) / static_cast<float>(segments);
+                const ts::math::Vec3 position{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                vertices.push_back({.position = position, .normal = position});
+            }
+        }
+
+        std::vector<uint32_t> indices;
+        for (uint32_t ring{}; ring < rings; ++ring)
+        {
+            for (uint32_t segment{}; segment < segments; ++segment)
+            {
+                const auto corner = ring * segments + segment;
+                const auto next = ring * segments + (segment + 1) % segments;
+                indices.insert(indices.end(), {corner, next, corner + segments});
+                indices.insert(indices.end(), {next, next + segments, corner + segments});
+            }
+        }
+
+        return std::pair{std::move(vertices), std::move(indices)};
+    };
+
+    std::vector<ts::MeshLod> lods;
+    std::pair<std::vector<ts::MeshComponent::Vertex>, std::vector<uint32_t>> sphere;
+    for (const auto segments : {64u, 256u, 512u})
+    {
+        sphere = makeSphere(segments, segments / 2);
+        const auto& [vertices, indices] = sphere;
+        const auto generationTime = measure([&] {
+            lods = ts::generateLods(vertices, indices, ts::MeshComponent::maxLodsCount);
+            gSink = lods.back().error;
+        }, 3);
+
+        report("LOD generation (triangles)", indices.size() / 3, generationTime);
+    }
+
+    // Spheres spread over the ground around the viewer, drawn with the levels of the largest one
+    ts::MeshComponent mesh;
+    mesh.indexCount = sphere.second.size();
+    mesh.boundsMin = ts::math::Vec3{-1.f};
+    mesh.boundsMax = ts::math::Vec3{1.f};
+    for (size_t level{}; level < lods.size(); ++level)
+    {
+        mesh.lods[level] = {.firstIndex = 0, .indexCount = lods[level].indices.size(), .error = lods[level].error};
+    }
+    mesh.lodsCount = lods.size();
+
+    // Eyes of 2000 pixels high with the 90 degrees field of view
+    const std::array eyePositions{ts::math::Vec3{-0.032f, 1.7f, 0.f}, ts::math::Vec3{0.032f, 1.7f, 0.f}};
+    const ts::LodSelection selection{.eyePositions = eyePositions, .pixelsPerUnit = 1000.f};
+
+    for (const auto entitiesNumber : entitiesNumbers)
+    {
+        std::mt19937 generator{};
+        std::uniform_real_distribution<float> distribution{-100.f, 100.f};
+        std::vector<ts::math::Mat4> worldMats;
+        for (size_t i{}; i < entitiesNumber; ++i)
+        {
+            worldMats.push_back(ts::math::translate(ts::math::Mat4{1.f}, ts::math::Vec3{distribution(generator), 0.f, distribution(generator)}));
+        }
+
+        size_t lodTriangles{};
+        const auto selectionTime = measure([&] {
+            lodTriangles = 0;
+            for (const auto& worldMat : worldMats)
+            {
+                lodTriangles += mesh.getLod(ts::lod::select(mesh, worldMat, selection)).indexCount / 3;
+            }
+            gSink = static_cast<float>(lodTriangles);
+        });
+
+        report("LOD selection", entitiesNumber, selectionTime);
+        std::cout << std::format("{:<40}{:>10}{:>14} triangles\n", "LOD drawn without levels", entitiesNumber, entitiesNumber * (mesh.indexCount / 3));
+        std::cout << std::format("{:<40}{:>10}{:>14} triangles\n", "LOD drawn with levels", entitiesNumber, lodTriangles);
+    }
+}
+struct BenchmarkEvent : ts::Event
+{
+    BenchmarkEvent(const float value_) : value{value_} {}
+
+    float value;
+};
+
+struct BenchmarkListener
+{
+    void onEvent(BenchmarkEvent& event) { sum += event.value; }
+
+    float sum{};
+};
+
+void eventBusBenchmark()
+{
+    for (const auto eventsNumber : entitiesNumbers)
+    {
+        ts::EventBus bus{eventsNumber * 64};
+        BenchmarkListener listener;
+        bus.subscribeToEvent(&listener, &BenchmarkListener::onEvent);
+
+        const auto emitTime = measure([&] {
+            for (size_t i{}; i < eventsNumber; ++i)
+            {
+                bus.emitEvent<BenchmarkEvent>(1.f);
+            }
+            gSink = listener.sum;
+        });
+
+        // Queued by all the workers at once and dispatched at the sync point
+        const auto queueTime = measure([&] {
+            ts::getJobSystem().parallelFor(0, eventsNumber, [&bus](const size_t) { bus.queueEvent<BenchmarkEvent>(1.f); });
+            bus.dispatchQueuedEvents();
+            gSink = listener.sum;
+        });
+
+        report("Event bus emit", eventsNumber, emitTime);
+        report("Event bus queue from workers and dispatch", eventsNumber, queueTime);
+    }
+}
+} // namespace
+
+int main()
+{
+    poolBenchmark<HashMapPool<ts::TransformComponent>>("Hash map pool");
+    poolBenchmark<ts::Pool<ts::TransformComponent>>("Sparse set pool");
+    jobSystemBenchmark();
+    eventBusBenchmark();
+    mat4Benchmark("scalar",
+        [](const auto& lhs, const auto& rhs) { return ts::math::scalar::multiply(lhs, rhs); },
+        [](const auto& mat) { return ts::math::scalar::inverse(mat); });
+    mat4Benchmark("dispatched",
+        [](const auto& lhs, const auto& rhs) { return lhs * rhs; },
+        [](const auto& mat) { return ts::math::inverse(mat); });
+    mathBatchBenchmark();
+    transformSystemBenchmark();
+    cullingBenchmark();
+    spatialIndexBenchmark();
+    lodBenchmark();
+
+    return EXIT_SUCCESS;
+}
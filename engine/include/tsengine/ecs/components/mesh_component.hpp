@@ -17,11 +17,41 @@ struct MeshComponent : public AssetComponent
         math::Vec3 color;
     };
 
+    // Position is dequantized with the position scale and bias, normal is octahedral encoded
+    struct PackedVertex final
+    {
+        std::array<int16_t, 4> position;
+        std::array<int16_t, 2> normal;
+    };
+
+    // Simplified index range sharing the vertices of the base one
+    struct Lod final
+    {
+        size_t firstIndex;
+        size_t indexCount;
+        // Distance from the base surface in the local space
+        float error;
+    };
+
+    static constexpr size_t maxLodsCount{4};
+
     size_t firstIndex{};
     size_t indexCount{};
+    size_t vertexOffset{};
+    math::Vec3 positionScale{1.f};
+    math::Vec3 positionBias{};
+    // Local space bounding box of the vertices, used for the culling
+    math::Vec3 boundsMin{};
+    math::Vec3 boundsMax{};
+    // Levels after the base range, in the order of the growing error
+    std::array<Lod, maxLodsCount> lods{};
+    size_t lodsCount{};
 
     MeshComponent(const std::string_view fileName_ = "") : AssetComponent{fileName_}
     {}
+
+    // Level 0 is the base range
+    Lod getLod(const size_t level) const { return (level == 0) ? Lod{firstIndex, indexCount, 0.f} : lods.at(level - 1); }
 };
 } // namespace ver
 } // namespace ts
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "tsengine/ecs/ecs.h"
+
+#include <atomic>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Transform of the entity becomes relative to the transform of the parent
+class ParentComponent : public Component
+{
+public:
+    ParentComponent(const Entity parent) : mParent{parent}
+    {
+        markHierarchyChanged();
+    }
+
+    // Removed component changes the hierarchy as well, the moves inside the storages only cost a spare sort
+    ~ParentComponent() { markHierarchyChanged(); }
+
+    ParentComponent(const ParentComponent&) = default;
+    ParentComponent(ParentComponent&&) = default;
+    ParentComponent& operator=(const ParentComponent&) = default;
+    ParentComponent& operator=(ParentComponent&&) = default;
+
+    Entity getParent() const { return mParent; }
+    void setParent(const Entity parent) { mParent = parent; markHierarchyChanged(); }
+
+    // Changed with every parent change of any entity, so the order of the hierarchy can be cached
+    static uint64_t getHierarchyVersion() { return hierarchyVersion.load(std::memory_order_relaxed); }
+
+private:
+    static void markHierarchyChanged() { hierarchyVersion.fetch_add(1, std::memory_order_relaxed); }
+
+    inline static std::atomic<uint64_t> hierarchyVersion{};
+
+    Entity mParent;
+};
+} // namespace ver
+} // namespace ts
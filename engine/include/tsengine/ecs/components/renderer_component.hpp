@@ -93,6 +93,8 @@ struct RendererComponent<PipelineType::PBR> : public RendererComponentBase
         math::Vec3 color;
         float roughness;
         float metallic;
+
+        bool operator==(const Material&) const = default;
     };
 
     Material material;
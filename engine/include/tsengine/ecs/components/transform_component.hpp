@@ -2,17 +2,95 @@
 
 #include "tsengine/math.hpp"
 
+#include <atomic>
+#include <memory>
+
 namespace ts
 {
 inline namespace TS_VER
 {
-struct TransformComponent : public Component
+class TransformSystem;
+
+// The model matrix is composed from the position, rotation and scale only when it's requested after a change
+class TransformComponent : public Component
 {
-    math::Vec3 pos;
-    math::Mat4 modelMat{1.f};
+    friend TransformSystem;
 
-    TransformComponent(const math::Vec3 pos_ = math::Vec3{0.f}) : pos{pos_}
+public:
+    TransformComponent(
+        const math::Vec3 position = math::Vec3{0.f},
+        const math::Quat rotation = math::Quat{},
+        const math::Vec3 scale = math::Vec3{1.f}) :
+        mPosition{position},
+        mRotation{rotation},
+        mScale{scale}
     {}
+
+    const math::Vec3& getPosition() const { return mPosition; }
+    const math::Quat& getRotation() const { return mRotation; }
+    const math::Vec3& getScale() const { return mScale; }
+
+    void setPosition(const math::Vec3& position) { mPosition = position; markDirty(); }
+    void setRotation(const math::Quat& rotation) { mRotation = rotation; markDirty(); }
+    void setScale(const math::Vec3& scale) { mScale = scale; markDirty(); }
+
+    const math::Mat4& getModelMat() const
+    {
+        if (mIsDirty)
+        {
+            mModelMat = math::trs(mPosition, mRotation, mScale);
+            mIsDirty = false;
+        }
+
+        return mModelMat;
+    }
+
+    // Unique among all the transforms and changed with every modification, so a copy of the model matrix can be
+    // checked for being outdated
+    uint64_t getVersion() const { return mVersion; }
+
+    // Model matrix combined with these of all the parents, it's updated by the TransformSystem
+    const math::Mat4& getWorldMat() const { return mWorldMat; }
+    math::Vec3 getWorldPosition() const { return math::Vec3{mWorldMat.data[3]}; }
+    uint64_t getWorldVersion() const { return mWorldVersion; }
+
+    // Changes with the creation or modification of any transform, so the copies of many of them can be checked at once
+    static uint64_t getLatestVersion() { return nextVersion.load(std::memory_order_relaxed); }
+
+private:
+    void markDirty()
+    {
+        mIsDirty = true;
+        mVersion = nextVersion.fetch_add(1, std::memory_order_relaxed);
+
+        if (const auto changedFlags = mpChangedFlags.lock())
+        {
+            (*changedFlags)[mNodeIndex] = true;
+        }
+    }
+
+    void setWorldMat(const math::Mat4& worldMat)
+    {
+        mWorldMat = worldMat;
+        mWorldVersion = nextVersion.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline static std::atomic<uint64_t> nextVersion{1};
+
+    math::Vec3 mPosition;
+    math::Quat mRotation;
+    math::Vec3 mScale;
+
+    mutable math::Mat4 mModelMat{1.f};
+    mutable bool mIsDirty{true};
+    uint64_t mVersion{nextVersion.fetch_add(1, std::memory_order_relaxed)};
+
+    math::Mat4 mWorldMat{1.f};
+    uint64_t mWorldVersion{nextVersion.fetch_add(1, std::memory_order_relaxed)};
+
+    // Set by the TransformSystem, so it finds the changes without visiting every transform
+    std::weak_ptr<std::vector<uint8_t>> mpChangedFlags;
+    size_t mNodeIndex{};
 };
 } // namespace ver
 } // namespace ts
@@ -2,15 +2,21 @@
 
 #include "tsengine/utils.hpp"
 #include "tsengine/logger.h"
+#include "tsengine/job_system.h"
 
 #include <cstdint>
+#include <array>
 #include <bitset>
+#include <limits>
 #include <string>
 #include <vector>
 #include <set>
 #include <unordered_map>
 #include <deque>
+#include <functional>
 #include <memory>
+#include <new>
+#include <tuple>
 #include <typeindex>
 
 // TODO: common abi
@@ -25,6 +31,20 @@ inline constexpr auto maxComponents = 32;
 
 using Signature = std::bitset<maxComponents>;
 
+enum class StorageMode
+{
+    POOLS,
+    ARCHETYPES
+};
+
+struct ComponentInfo
+{
+    size_t size;
+    size_t alignment;
+    void (*moveConstruct)(void* const destination, void* const source);
+    void (*destroy)(void* const object);
+};
+
 struct IComponent
 {
 protected:
@@ -40,6 +60,20 @@ public:
         static auto id = nextId++;
         return id;
     }
+
+    static constexpr ComponentInfo getInfo()
+    {
+        return {
+            .size = sizeof(T),
+            .alignment = alignof(T),
+            .moveConstruct = [](void* const destination, void* const source) {
+                new (destination) T(std::move(*static_cast<T*>(source)));
+            },
+            .destroy = [](void* const object) {
+                static_cast<T*>(object)->~T();
+            },
+        };
+    }
 };
 
 struct Component
@@ -90,15 +124,30 @@ class System
     friend Registry;
 
     std::vector<Entity> entities;
+    size_t entitiesVersion{};
     Signature componentSignature;
+    Signature readSignature;
+    Signature writeSignature;
+    bool isAccessDeclared{};
+    bool isExclusive{};
 
 public:
-    void addEntityToSystem(const Entity entity) { entities.push_back(entity); }
+    void addEntityToSystem(const Entity entity) { entities.push_back(entity); ++entitiesVersion; }
     void removeEntityFromSystem(const Entity entity);
-    std::vector<Entity> getSystemEntities() const { return entities; }
+    const std::vector<Entity>& getSystemEntities() const { return entities; }
+    // Changed whenever an entity is added or removed, so systems can cache data derived from the entities
+    size_t getEntitiesVersion() const { return entitiesVersion; }
     const Signature& getComponentSignature() const { return componentSignature; }
 
-    template<typename TComponent> void requireComponent();};
+    // Systems which haven't declared their access are never run concurrently with other systems
+    bool conflictsWith(const System& other) const;
+
+    template<typename TComponent> void requireComponent();
+    template<typename TComponent> void readsComponent();
+    template<typename TComponent> void writesComponent();
+    // For the systems touching the registry state outside of the components, like the tags and the groups
+    void runsExclusively() { isExclusive = true; }
+};
 
 class IPool
 {
@@ -106,31 +155,99 @@ public:
     virtual void removeEntityFromPool(const Id entityId) = 0;
 };
 
+// Sparse set, entity ids are translated to indices of the packed data through the paged sparse array,
+// so getting a component is just two array accesses and the data can be iterated without any gaps.
 template <typename T>
 class Pool : public IPool
 {
-    std::unordered_map<Id, Id> entityIdToIndex;
-    std::unordered_map<Id, Id> indexToEntityId;
+    static constexpr size_t pageSize{1024};
+    static constexpr Id invalidIndex{std::numeric_limits<Id>::max()};
+
+    using Page = std::array<Id, pageSize>;
+
+    std::vector<std::unique_ptr<Page>> sparse;
+    std::vector<Id> denseEntityIds;
     std::vector<T> data;
-    size_t size{};
 
 public:
-    Pool(size_t capacity = 100) : data(capacity, T{}) {}
+    Pool(size_t capacity = 100)
+    {
+        denseEntityIds.reserve(capacity);
+        data.reserve(capacity);
+    }
 
-    bool isEmpty() const { return size == 0; }
-    size_t getSize() const { return size; }
+    bool isEmpty() const { return data.empty(); }
+    size_t getSize() const { return data.size(); }
+    bool has(const Id entityId) const;
     void reset();
     void set(const Id entityId, const T object);
     void remove(const Id entityId);
     void removeEntityFromPool(const Id entityId) override;
     T& get(const Id entityId);
+    const std::vector<Id>& getEntityIds() const { return denseEntityIds; }
 
     T& operator [](const Id index) { return data.at(index); }
     const T& operator [](const Id index) const { return data.at(index); }
+
+private:
+    Id& getSparseIndex(const Id entityId);
+};
+
+// Entities sharing the same signature are stored together, every component type in its own
+// contiguous array inside fixed size chunks, so iterating over them doesn't jump around the memory.
+class Archetype
+{
+    TS_NOT_COPYABLE_AND_MOVEABLE(Archetype);
+
+public:
+    static constexpr size_t chunkSize{16 * 1024};
+    static constexpr uint8_t invalidColumn{std::numeric_limits<uint8_t>::max()};
+
+    Archetype(const Signature signature, const std::vector<ComponentInfo>& componentInfos);
+    ~Archetype();
+
+    const Signature& getSignature() const { return signature; }
+    size_t getSize() const { return entityIds.size(); }
+    size_t getChunkCapacity() const { return chunkCapacity; }
+    size_t getChunksCount() const { return chunks.size(); }
+    size_t getChunkSize(const size_t chunkIndex) const;
+    Id getEntityId(const size_t row) const { return entityIds[row]; }
+    bool hasColumn(const Id componentId) const { return columnPerComponent[componentId] != invalidColumn; }
+
+    size_t allocate(const Id entityId);
+    Id remove(const size_t row);
+    void* get(const Id componentId, const size_t row) const;
+    void* getChunkColumn(const Id componentId, const size_t chunkIndex) const;
+
+private:
+    struct alignas(64) Chunk
+    {
+        std::byte memory[chunkSize];
+    };
+
+    struct Column
+    {
+        Id componentId;
+        ComponentInfo info;
+        size_t offset;
+    };
+
+    Signature signature;
+    std::vector<Column> columns;
+    std::array<uint8_t, maxComponents> columnPerComponent;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::vector<Id> entityIds;
+    size_t chunkCapacity{};
 };
 
+template <IsComponent ...TComponents>
+class View;
+
 class Registry
 {
+    template <IsComponent ...TComponents>
+    friend class View;
+
     std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
     std::unordered_map<std::string, Entity> entityPerTag;
     std::unordered_map<Id, std::string> tagPerEntity;
@@ -143,11 +260,36 @@ class Registry
     std::deque<Id> freeIds;
     Id numEntities{};
 
+    struct EntityLocation
+    {
+        Archetype* archetype;
+        size_t row;
+    };
+
+    StorageMode storageMode;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<Signature, Archetype*> archetypePerSignature;
+    std::vector<EntityLocation> entityLocations;
+    std::vector<ComponentInfo> componentInfos;
+
+    struct ScheduledSystem
+    {
+        const System* system;
+        std::function<void()> job;
+    };
+
+    std::vector<ScheduledSystem> scheduledSystems;
+
 public:
-    Registry() = default;
+    Registry(const StorageMode storageMode_ = StorageMode::POOLS) : storageMode{storageMode_} {}
+
+    StorageMode getStorageMode() const { return storageMode; }
 
     void update();
 
+    template<IsComponent ...TComponents, typename TFunc> void each(TFunc&& func);
+    template<IsComponent ...TComponents> View<TComponents...> view();
+
     Entity createEntity();
     void killEntity(const Entity entity) { entitiesToBeKilled.insert(entity); };
 
@@ -167,6 +309,12 @@ public:
     template<typename TSystem> bool hasSystem() const;
     template<typename TSystem> TSystem& getSystem() const;
 
+    // Systems are run by runScheduledSystems in the order of scheduling, except that these
+    // which don't conflict in the declared component access are run concurrently.
+    // Scheduled jobs must not create or kill entities and add or remove components.
+    template<typename TSystem, typename TFunc> void schedule(TFunc&& func);
+    void runScheduledSystems();
+
 private:
     friend Entity; // TODO: reduce access
 
@@ -178,6 +326,56 @@ private:
 
     void addEntityToSystems(const Entity entity);
     void removeEntityFromSystems(const Entity entity);
+
+    Archetype& getArchetype(const Signature signature);
+    void moveEntityToArchetype(const Id entityId, const Signature signature);
+    void removeEntityFromArchetype(const Id entityId);
+};
+
+// Lazy range of tuples with references to the components of every entity having all of them.
+// In the pool mode the smallest pool is iterated and the rest is probed through the entity signature.
+// Adding or removing components while iterating over the view invalidates it.
+template <IsComponent ...TComponents>
+class View
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::tuple<TComponents&...>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+        Iterator(const View* view_, const size_t archetypeIndex_, const size_t row_);
+
+        value_type operator*() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator& other) const { return (archetypeIndex == other.archetypeIndex) && (row == other.row); }
+
+        Entity getEntity() const;
+
+    private:
+        void skipUnmatched();
+
+        const View* view{};
+        size_t archetypeIndex{};
+        size_t row{};
+    };
+
+    View(Registry* const registry);
+
+    Iterator begin() const { return Iterator{this, 0, 0}; }
+    Iterator end() const;
+
+private:
+    Registry* mpRegistry;
+    Signature mSignature;
+    const std::vector<Id>* mpCandidates{};
+    std::vector<const Archetype*> mArchetypes;
 };
 
 Registry& getMainReg();
@@ -239,76 +437,340 @@ template<typename TComponent> TComponent& Entity::getComponent() const
 
 // Pool
 
+template<typename T>
+bool Pool<T>::has(const Id entityId) const
+{
+    const auto page = entityId / pageSize;
+    return (page < sparse.size()) && (sparse[page] != nullptr) && ((*sparse[page])[entityId % pageSize] != invalidIndex);
+}
+
 template<typename T>
 void Pool<T>::reset()
 {
+    sparse.clear();
+    denseEntityIds.clear();
     data.clear();
-    entityIdToIndex.clear();
-    indexToEntityId.clear();
-    size = 0;
 }
 
 template<typename T>
 void Pool<T>::set(const Id entityId, const T object)
 {
-    if (entityIdToIndex.find(entityId) != entityIdToIndex.end())
+    auto& index = getSparseIndex(entityId);
+    if (index != invalidIndex)
     {
-        const auto index = entityIdToIndex[entityId];
-        data.at(index) = object;
+        data[index] = object;
     }
     else
     {
-        const auto index = static_cast<Id>(size);
-        entityIdToIndex.emplace(entityId, index);
-        indexToEntityId.emplace(index, entityId);
-        if (index >= data.capacity())
-        {
-            data.resize(size * 2);
-        }
-        data.at(index) = object;
-        size++;
+        index = static_cast<Id>(data.size());
+        denseEntityIds.push_back(entityId);
+        data.push_back(object);
     }
 }
 
 template<typename T>
 void Pool<T>::remove(const Id entityId)
 {
-    const auto indexOfRemoved = entityIdToIndex[entityId];
-    const auto indexOfLast = static_cast<Id>(size - 1);
-    data.at(indexOfRemoved) = data[indexOfLast];
+    auto& indexOfRemoved = (*sparse[entityId / pageSize])[entityId % pageSize];
+    const auto entityIdOfLastElement = denseEntityIds.back();
 
-    const auto entityIdOfLastElement = indexToEntityId[indexOfLast];
-    entityIdToIndex.at(entityIdOfLastElement) = indexOfRemoved;
-    indexToEntityId.at(indexOfRemoved) = entityIdOfLastElement;
-
-    entityIdToIndex.erase(entityId);
-    indexToEntityId.erase(indexOfLast);
+    if (entityIdOfLastElement != entityId)
+    {
+        data[indexOfRemoved] = std::move(data.back());
+        denseEntityIds[indexOfRemoved] = entityIdOfLastElement;
+        (*sparse[entityIdOfLastElement / pageSize])[entityIdOfLastElement % pageSize] = indexOfRemoved;
+    }
+    indexOfRemoved = invalidIndex;
 
-    size--;
+    data.pop_back();
+    denseEntityIds.pop_back();
 }
 
 template<typename T>
 void Pool<T>::removeEntityFromPool(const Id entityId)
 {
-    if (entityIdToIndex.find(entityId) != entityIdToIndex.cend())
+    if (has(entityId))
     {
         remove(entityId);
     }
 }
+
 template<typename T>
 T& Pool<T>::get(const Id entityId)
 {
-    const auto index = entityIdToIndex[entityId];
-    return static_cast<T&>(data[index]);
+    TS_ASSERT_MSG(has(entityId), "Entity has no component in the pool");
+    return data[(*sparse[entityId / pageSize])[entityId % pageSize]];
+}
+
+template<typename T>
+Id& Pool<T>::getSparseIndex(const Id entityId)
+{
+    const auto page = entityId / pageSize;
+    if (page >= sparse.size())
+    {
+        sparse.resize(page + 1);
+    }
+
+    if (sparse[page] == nullptr)
+    {
+        sparse[page] = std::make_unique<Page>();
+        sparse[page]->fill(invalidIndex);
+    }
+
+    return (*sparse[page])[entityId % pageSize];
+}
+
+// Archetype
+
+inline Archetype::Archetype(const Signature signature_, const std::vector<ComponentInfo>& componentInfos) : signature{signature_}
+{
+    columnPerComponent.fill(invalidColumn);
+
+    size_t bytesPerEntity{};
+    for (Id componentId{}; componentId < maxComponents; ++componentId)
+    {
+        if (signature.test(componentId))
+        {
+            const auto& info = componentInfos.at(componentId);
+            columnPerComponent[componentId] = static_cast<uint8_t>(columns.size());
+            columns.push_back({.componentId = componentId, .info = info});
+            bytesPerEntity += info.size + info.alignment;
+        }
+    }
+
+    chunkCapacity = (bytesPerEntity == 0) ? chunkSize : std::max<size_t>(1, chunkSize / bytesPerEntity);
+
+    size_t offset{};
+    for (auto& column : columns)
+    {
+        TS_ASSERT_MSG(column.info.alignment <= alignof(Chunk), "Component alignment isn't supported by archetype chunks");
+
+        offset = (offset + column.info.alignment - 1) / column.info.alignment * column.info.alignment;
+        column.offset = offset;
+        offset += column.info.size * chunkCapacity;
+    }
+
+    TS_ASSERT_MSG(offset <= chunkSize, "Archetype columns exceed the chunk size");
+}
+
+inline Archetype::~Archetype()
+{
+    for (size_t row{}; row < entityIds.size(); ++row)
+    {
+        for (const auto& column : columns)
+        {
+            column.info.destroy(get(column.componentId, row));
+        }
+    }
+}
+
+inline size_t Archetype::getChunkSize(const size_t chunkIndex) const
+{
+    return std::min(chunkCapacity, entityIds.size() - chunkIndex * chunkCapacity);
+}
+
+inline size_t Archetype::allocate(const Id entityId)
+{
+    const auto row = entityIds.size();
+    if (row == chunks.size() * chunkCapacity)
+    {
+        chunks.emplace_back(std::make_unique<Chunk>());
+    }
+
+    entityIds.push_back(entityId);
+
+    return row;
+}
+
+// Destroys components of the given row and fills the gap with the last row,
+// returns id of the moved entity or the removed one if nothing had to be moved.
+inline Id Archetype::remove(const size_t row)
+{
+    const auto lastRow = entityIds.size() - 1;
+
+    for (const auto& column : columns)
+    {
+        const auto removed = get(column.componentId, row);
+        column.info.destroy(removed);
+
+        if (row != lastRow)
+        {
+            const auto last = get(column.componentId, lastRow);
+            column.info.moveConstruct(removed, last);
+            column.info.destroy(last);
+        }
+    }
+
+    const auto movedEntityId = entityIds[lastRow];
+    entityIds[row] = movedEntityId;
+    entityIds.pop_back();
+
+    if (chunks.size() * chunkCapacity - entityIds.size() >= chunkCapacity)
+    {
+        chunks.pop_back();
+    }
+
+    return movedEntityId;
+}
+
+inline void* Archetype::get(const Id componentId, const size_t row) const
+{
+    const auto& column = columns[columnPerComponent[componentId]];
+    const auto chunk = chunks[row / chunkCapacity].get();
+    return chunk->memory + column.offset + column.info.size * (row % chunkCapacity);
+}
+
+inline void* Archetype::getChunkColumn(const Id componentId, const size_t chunkIndex) const
+{
+    const auto& column = columns[columnPerComponent[componentId]];
+    return chunks[chunkIndex]->memory + column.offset;
+}
+
+// View
+
+template <IsComponent ...TComponents>
+View<TComponents...>::View(Registry* const registry) : mpRegistry{registry}
+{
+    (mSignature.set(ComponentManager<TComponents>::getId()), ...);
+
+    if (mpRegistry->storageMode == StorageMode::ARCHETYPES)
+    {
+        for (const auto& archetype : mpRegistry->archetypes)
+        {
+            if (((archetype->getSignature() & mSignature) == mSignature) && (archetype->getSize() > 0))
+            {
+                mArchetypes.push_back(archetype.get());
+            }
+        }
+
+        return;
+    }
+
+    for (const auto componentId : {ComponentManager<TComponents>::getId()...})
+    {
+        if ((componentId >= mpRegistry->componentPools.size()) || (mpRegistry->componentPools[componentId] == nullptr))
+        {
+            mpCandidates = nullptr;
+            return;
+        }
+    }
+
+    const std::array poolsEntityIds{
+        &static_cast<Pool<TComponents>*>(mpRegistry->componentPools[ComponentManager<TComponents>::getId()].get())->getEntityIds()...};
+
+    mpCandidates = *std::ranges::min_element(poolsEntityIds, std::less{}, [](const auto entityIds) { return entityIds->size(); });
+}
+
+template <IsComponent ...TComponents>
+typename View<TComponents...>::Iterator View<TComponents...>::end() const
+{
+    if (mpRegistry->storageMode == StorageMode::ARCHETYPES)
+    {
+        return Iterator{this, mArchetypes.size(), 0};
+    }
+
+    return Iterator{this, 0, (mpCandidates == nullptr) ? 0 : mpCandidates->size()};
+}
+
+template <IsComponent ...TComponents>
+View<TComponents...>::Iterator::Iterator(const View* view_, const size_t archetypeIndex_, const size_t row_) :
+    view{view_},
+    archetypeIndex{archetypeIndex_},
+    row{row_}
+{
+    skipUnmatched();
+}
+
+template <IsComponent ...TComponents>
+typename View<TComponents...>::Iterator::value_type View<TComponents...>::Iterator::operator*() const
+{
+    if (view->mpRegistry->storageMode == StorageMode::ARCHETYPES)
+    {
+        const auto archetype = view->mArchetypes[archetypeIndex];
+        return {*static_cast<TComponents*>(archetype->get(ComponentManager<TComponents>::getId(), row))...};
+    }
+
+    return {view->mpRegistry->template getComponent<TComponents>(getEntity())...};
+}
+
+template <IsComponent ...TComponents>
+typename View<TComponents...>::Iterator& View<TComponents...>::Iterator::operator++()
+{
+    ++row;
+    skipUnmatched();
+    return *this;
+}
+
+template <IsComponent ...TComponents>
+typename View<TComponents...>::Iterator View<TComponents...>::Iterator::operator++(int)
+{
+    auto previous = *this;
+    ++*this;
+    return previous;
+}
+
+template <IsComponent ...TComponents>
+Entity View<TComponents...>::Iterator::getEntity() const
+{
+    if (view->mpRegistry->storageMode == StorageMode::ARCHETYPES)
+    {
+        return Entity{view->mArchetypes[archetypeIndex]->getEntityId(row), view->mpRegistry};
+    }
+
+    return Entity{(*view->mpCandidates)[row], view->mpRegistry};
+}
+
+template <IsComponent ...TComponents>
+void View<TComponents...>::Iterator::skipUnmatched()
+{
+    if (view->mpRegistry->storageMode == StorageMode::ARCHETYPES)
+    {
+        const auto& archetypes = view->mArchetypes;
+        while ((archetypeIndex < archetypes.size()) && (row >= archetypes[archetypeIndex]->getSize()))
+        {
+            ++archetypeIndex;
+            row = 0;
+        }
+
+        return;
+    }
+
+    if (view->mpCandidates == nullptr)
+    {
+        return;
+    }
+
+    const auto& candidates = *view->mpCandidates;
+    const auto& signatures = view->mpRegistry->entityComponentSignatures;
+    while ((row < candidates.size()) && ((signatures[candidates[row]] & view->mSignature) != view->mSignature))
+    {
+        ++row;
+    }
 }
 
 // System
 
 inline void System::removeEntityFromSystem(const Entity entity)
 {
-    entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](const Entity other) {
+    const auto removed = std::remove_if(entities.begin(), entities.end(), [&entity](const Entity other) {
         return entity == other;
-    }), entities.end());
+    });
+
+    if (removed != entities.end())
+    {
+        entities.erase(removed, entities.end());
+        ++entitiesVersion;
+    }
+}
+
+inline bool System::conflictsWith(const System& other) const
+{
+    if (!isAccessDeclared || !other.isAccessDeclared || isExclusive || other.isExclusive)
+    {
+        return true;
+    }
+
+    return (writeSignature & (other.readSignature | other.writeSignature)).any() || (other.writeSignature & readSignature).any();
 }
 
 template<typename TComponent>
@@ -318,6 +780,20 @@ void System::requireComponent()
     componentSignature.set(componentId);
 }
 
+template<typename TComponent>
+void System::readsComponent()
+{
+    readSignature.set(ComponentManager<TComponent>::getId());
+    isAccessDeclared = true;
+}
+
+template<typename TComponent>
+void System::writesComponent()
+{
+    writeSignature.set(ComponentManager<TComponent>::getId());
+    isAccessDeclared = true;
+}
+
 // Registry
 
 inline void Registry::update()
@@ -333,11 +809,18 @@ inline void Registry::update()
         removeEntityFromSystems(entity);
         entityComponentSignatures[entity.getId()].reset();
 
-        for (const auto pool : componentPools)
+        if (storageMode == StorageMode::ARCHETYPES)
+        {
+            removeEntityFromArchetype(entity.getId());
+        }
+        else
         {
-            if (pool)
+            for (const auto pool : componentPools)
             {
-                pool->removeEntityFromPool(entity.getId());
+                if (pool)
+                {
+                    pool->removeEntityFromPool(entity.getId());
+                }
             }
         }
 
@@ -361,6 +844,7 @@ inline Entity Registry::createEntity()
         if (entityId >= entityComponentSignatures.size())
         {
             entityComponentSignatures.resize(entityId + 1);
+            entityLocations.resize(entityId + 1);
         }
     }
     else
@@ -477,6 +961,54 @@ TSystem& Registry::getSystem() const
     return *(std::static_pointer_cast<TSystem>(system->second));
 }
 
+template<typename TSystem, typename TFunc>
+void Registry::schedule(TFunc&& func)
+{
+    auto& system = getSystem<TSystem>();
+    scheduledSystems.push_back({
+        .system = &system,
+        .job = [&system, func = std::forward<TFunc>(func)]() mutable { func(system); }
+    });
+}
+
+inline void Registry::runScheduledSystems()
+{
+    const auto jobs = std::move(scheduledSystems);
+    scheduledSystems.clear();
+
+    // Every system has to wait for all of the previously scheduled systems it conflicts with,
+    // so they are grouped into the levels which can be run in parallel.
+    std::vector<size_t> levels(jobs.size());
+    size_t levelsNumber{};
+    for (size_t i{}; i < jobs.size(); ++i)
+    {
+        for (size_t j{}; j < i; ++j)
+        {
+            if (jobs[i].system->conflictsWith(*jobs[j].system))
+            {
+                levels[i] = std::max(levels[i], levels[j] + 1);
+            }
+        }
+
+        levelsNumber = std::max(levelsNumber, levels[i] + 1);
+    }
+
+    auto& jobSystem = getJobSystem();
+    for (size_t level{}; level < levelsNumber; ++level)
+    {
+        JobCounter counter;
+        for (size_t i{}; i < jobs.size(); ++i)
+        {
+            if (levels[i] == level)
+            {
+                jobSystem.run(jobs[i].job, &counter);
+            }
+        }
+
+        jobSystem.wait(counter);
+    }
+}
+
 template<IsComponent TComponent, typename ...TArgs>
 void Registry::addComponent(const Entity entity, TArgs&& ...args)
 {
@@ -494,6 +1026,32 @@ void Registry::_addComponent(const Entity entity, TArgs&& ...args)
     const auto componentId = ComponentManager<TComponent>::getId();
     const auto entityId = entity.getId();
 
+    if (storageMode == StorageMode::ARCHETYPES)
+    {
+        if (componentId >= componentInfos.size())
+        {
+            componentInfos.resize(componentId + 1);
+        }
+        componentInfos[componentId] = ComponentManager<TComponent>::getInfo();
+
+        auto& signature = entityComponentSignatures[entityId];
+        if (signature.test(componentId))
+        {
+            getComponent<TComponent>(entity) = TComponent{std::forward<TArgs>(args)...};
+            return;
+        }
+
+        auto newSignature = signature;
+        newSignature.set(componentId);
+        moveEntityToArchetype(entityId, newSignature);
+
+        const auto& location = entityLocations[entityId];
+        new (location.archetype->get(componentId, location.row)) TComponent{std::forward<TArgs>(args)...};
+
+        signature = newSignature;
+        return;
+    }
+
     if (componentId >= componentPools.size())
     {
         componentPools.resize(componentId + 1, nullptr);
@@ -520,8 +1078,17 @@ void Registry::removeComponent(const Entity entity)
     const auto componentId = ComponentManager<TComponent>::getId();
     const auto entityId = entity.getId();
 
-    const auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    componentPool->remove(entityId);
+    if (storageMode == StorageMode::ARCHETYPES)
+    {
+        auto newSignature = entityComponentSignatures.at(entityId);
+        newSignature.set(componentId, false);
+        moveEntityToArchetype(entityId, newSignature);
+    }
+    else
+    {
+        const auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+        componentPool->remove(entityId);
+    }
 
     entityComponentSignatures.at(entityId).set(componentId, false);
 }
@@ -539,11 +1106,61 @@ TComponent& Registry::getComponent(const Entity entity) const
 {
     const auto componentId = ComponentManager<TComponent>::getId();
     const auto entityId = entity.getId();
-    auto var = componentPools[componentId];
-    const auto componentPool = std::static_pointer_cast<Pool<TComponent>>(var);
+
+    if (storageMode == StorageMode::ARCHETYPES)
+    {
+        const auto& location = entityLocations[entityId];
+        return *static_cast<TComponent*>(location.archetype->get(componentId, location.row));
+    }
+
+    const auto componentPool = static_cast<Pool<TComponent>*>(componentPools[componentId].get());
     return componentPool->get(entityId);
 }
 
+template<IsComponent ...TComponents, typename TFunc>
+void Registry::each(TFunc&& func)
+{
+    Signature requiredSignature;
+    (requiredSignature.set(ComponentManager<TComponents>::getId()), ...);
+
+    if (storageMode == StorageMode::ARCHETYPES)
+    {
+        for (const auto& archetype : archetypes)
+        {
+            if ((archetype->getSignature() & requiredSignature) != requiredSignature)
+            {
+                continue;
+            }
+
+            for (size_t chunkIndex{}; chunkIndex < archetype->getChunksCount(); ++chunkIndex)
+            {
+                const auto columns = std::make_tuple(
+                    static_cast<TComponents*>(archetype->getChunkColumn(ComponentManager<TComponents>::getId(), chunkIndex))...);
+                const auto firstRow = chunkIndex * archetype->getChunkCapacity();
+
+                for (size_t i{}; i < archetype->getChunkSize(chunkIndex); ++i)
+                {
+                    func(Entity{archetype->getEntityId(firstRow + i), this}, std::get<TComponents*>(columns)[i]...);
+                }
+            }
+        }
+
+        return;
+    }
+
+    const auto components = view<TComponents...>();
+    for (auto it = components.begin(); it != components.end(); ++it)
+    {
+        std::apply([&](auto&... component) { func(it.getEntity(), component...); }, *it);
+    }
+}
+
+template<IsComponent ...TComponents>
+View<TComponents...> Registry::view()
+{
+    return View<TComponents...>{this};
+}
+
 inline void Registry::addEntityToSystems(const Entity entity)
 {
     const auto entityId = entity.getId();
@@ -570,5 +1187,71 @@ inline void Registry::removeEntityFromSystems(const Entity entity)
         system.second->removeEntityFromSystem(entity);
     }
 }
+
+inline Archetype& Registry::getArchetype(const Signature signature)
+{
+    const auto archetype = archetypePerSignature.find(signature);
+    if (archetype != archetypePerSignature.end())
+    {
+        return *archetype->second;
+    }
+
+    auto& newArchetype = archetypes.emplace_back(std::make_unique<Archetype>(signature, componentInfos));
+    archetypePerSignature.emplace(signature, newArchetype.get());
+
+    return *newArchetype;
+}
+
+// Components which are present in both archetypes are moved, the rest of the old ones are destroyed.
+// Components which are new for the entity are left uninitialized and must be constructed by the caller.
+inline void Registry::moveEntityToArchetype(const Id entityId, const Signature signature)
+{
+    auto& location = entityLocations[entityId];
+    const auto oldArchetype = location.archetype;
+    const auto oldRow = location.row;
+
+    if (signature.none())
+    {
+        removeEntityFromArchetype(entityId);
+        return;
+    }
+
+    auto& newArchetype = getArchetype(signature);
+    const auto newRow = newArchetype.allocate(entityId);
+
+    if (oldArchetype != nullptr)
+    {
+        for (Id componentId{}; componentId < maxComponents; ++componentId)
+        {
+            if (oldArchetype->hasColumn(componentId) && newArchetype.hasColumn(componentId))
+            {
+                componentInfos[componentId].moveConstruct(
+                    newArchetype.get(componentId, newRow),
+                    oldArchetype->get(componentId, oldRow));
+            }
+        }
+
+        removeEntityFromArchetype(entityId);
+    }
+
+    location = {.archetype = &newArchetype, .row = newRow};
+}
+
+inline void Registry::removeEntityFromArchetype(const Id entityId)
+{
+    auto& location = entityLocations[entityId];
+    if (location.archetype == nullptr)
+    {
+        return;
+    }
+
+    const auto movedEntityId = location.archetype->remove(location.row);
+    if (movedEntityId != entityId)
+    {
+        entityLocations[movedEntityId].row = location.row;
+    }
+
+    location = {};
+}
 } // namespace ver
 } // namespace ts
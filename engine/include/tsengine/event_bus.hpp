@@ -1,93 +1,228 @@
 #pragma once
 
+#include "utils.hpp"
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstring>
 #include <functional>
-#include <list>
-#include <map>
 #include <memory>
+#include <new>
+#include <vector>
 
 namespace ts
 {
 inline namespace TS_VER
 {
-class IEventCallback;
+struct Event
+{
+};
 
-using THandlerList = std::list<std::unique_ptr<IEventCallback>>;
+template <typename T>
+concept IsEvent = std::derived_from<T, Event>;
 
-struct Event
+using EventTypeId = uint32_t;
+
+struct IEventType
 {
+protected:
+    inline static std::atomic<EventTypeId> nextId{};
 };
 
-class IEventCallback
+// Dense id of every event type, assigned at its first use, so the handlers are indexed by it
+template <typename TEvent>
+class EventType final : public IEventType
 {
 public:
-    virtual ~IEventCallback() = default;
-
-    void execute(Event& e)
+    static EventTypeId getId()
     {
-        call(e);
+        static const auto id = nextId++;
+        return id;
     }
-
-private:
-    virtual void call(Event& e) = 0;
 };
 
-template <typename TOwner, typename TEvent>
-class EventCallback : public IEventCallback
+// Handlers of every event type are kept in one flat array indexed by its id. Member callbacks are stored inline next to
+// a thunk restoring their types, so there is no allocation per handler and no virtual call.
+// Events are either emitted right away on the calling thread or queued into the arena of the frame, which the sync point
+// dispatches in one batch. Both can be called from the worker threads, the subscriptions have to be made before that.
+class EventBus final
 {
-    using TCallback = void (TOwner::*)(TEvent&);
+    TS_NOT_COPYABLE_AND_MOVEABLE(EventBus);
 
 public:
-    EventCallback(TOwner* pOwner, TCallback callback) : mOwner{ pOwner }, mCallback{ callback }
-    {
-    }
+    static constexpr size_t defaultArenaSize{64 * 1024};
+
+    EventBus(const size_t arenaSize = defaultArenaSize);
+    ~EventBus();
+
+    template <IsEvent TEvent, typename TOwner>
+    void subscribeToEvent(TOwner* const pOwner, void (TOwner::*callback)(TEvent&));
 
-    virtual ~EventCallback() override = default;
+    // Event is constructed once for all the handlers, only when there is any
+    template <IsEvent TEvent, typename... TArgs>
+    void emitEvent(TArgs&&... args) const;
+
+    // Event is constructed in the arena and dispatched by the next sync point. Returns false when the arena
+    // of the frame is full, the event is dropped then.
+    template <IsEvent TEvent, typename... TArgs>
+    bool queueEvent(TArgs&&... args);
+
+    // Sync point called by one thread, the events queued during the dispatch go to the next one
+    void dispatchQueuedEvents();
 
 private:
-    TOwner* mOwner;
-    TCallback mCallback;
+    // Member function pointers are up to three pointers large, with the virtual inheritance on MSVC
+    static constexpr size_t maxCallbackSize{3 * sizeof(void*)};
+    static constexpr size_t queuedAlignment{alignof(std::max_align_t)};
 
-    virtual void call(Event& e) override
+    struct Handler
     {
-        std::invoke(mCallback, mOwner, static_cast<TEvent&>(e));
-    }
+        void* pOwner;
+        void (*invoke)(const Handler& handler, Event& event);
+        alignas(void*) std::array<std::byte, maxCallbackSize> callback;
+    };
+
+    // Header in front of every queued event, the event follows at the queued event offset
+    struct QueuedEvent
+    {
+        // Null when the event constructor threw
+        void (*dispatch)(const EventBus& bus, void* const pEvent);
+        void (*destroy)(void* const pEvent);
+        size_t size;
+    };
+
+    struct Arena
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::atomic<size_t> head{};
+        // Writers between choosing the arena and finishing their event
+        std::atomic<size_t> writers{};
+    };
+
+    static constexpr size_t alignQueued(const size_t size) { return (size + queuedAlignment - 1) & ~(queuedAlignment - 1); }
+    static constexpr size_t queuedEventOffset{(sizeof(QueuedEvent) + queuedAlignment - 1) & ~(queuedAlignment - 1)};
+
+    template <IsEvent TEvent, typename TOwner>
+    static void invokeMember(const Handler& handler, Event& event);
+
+    template <IsEvent TEvent>
+    void dispatch(TEvent& event) const;
+
+    // Destroys the events of the arena, dispatching them before when it should
+    void flush(Arena& arena, const bool shouldDispatch);
+
+    std::vector<std::vector<Handler>> mHandlersPerType;
+    size_t mArenaSize;
+    std::array<Arena, 2> mArenas;
+    std::atomic<size_t> mActiveArena{};
+    std::atomic<size_t> mDroppedEventsNumber{};
 };
 
-class EventBus
+EventBus& getEventBus();
+
+template <IsEvent TEvent, typename TOwner>
+void EventBus::subscribeToEvent(TOwner* const pOwner, void (TOwner::*callback)(TEvent&))
 {
-public:
-    EventBus() : mSubscribers{}
+    static_assert(sizeof(callback) <= maxCallbackSize);
+
+    const auto typeId = EventType<TEvent>::getId();
+    if (typeId >= mHandlersPerType.size())
     {
+        mHandlersPerType.resize(typeId + 1);
     }
 
-    template <typename TEvent, typename TOwner>
-    void subscribeToEvent(TOwner* pOwner, void (TOwner::*callback)(TEvent&))
+    Handler handler{.pOwner = pOwner, .invoke = &invokeMember<TEvent, TOwner>, .callback = {}};
+    std::memcpy(handler.callback.data(), &callback, sizeof(callback));
+    mHandlersPerType[typeId].emplace_back(handler);
+}
+
+template <IsEvent TEvent, typename... TArgs>
+void EventBus::emitEvent(TArgs&&... args) const
+{
+    const auto typeId = EventType<TEvent>::getId();
+    if ((typeId >= mHandlersPerType.size()) || mHandlersPerType[typeId].empty())
     {
-        if (mSubscribers[typeid(TEvent)] == nullptr)
+        return;
+    }
+
+    TEvent event(std::forward<TArgs>(args)...);
+    dispatch(event);
+}
+
+template <IsEvent TEvent, typename... TArgs>
+bool EventBus::queueEvent(TArgs&&... args)
+{
+    static_assert(alignof(TEvent) <= queuedAlignment);
+    static constexpr auto recordSize = alignQueued(queuedEventOffset + sizeof(TEvent));
+
+    // Writer is counted before it checks the arena is still the active one, so the sync point flipping the arenas
+    // either waits for it or it moves to the new arena
+    Arena* pArena{};
+    while (true)
+    {
+        pArena = &mArenas[mActiveArena.load()];
+        pArena->writers.fetch_add(1);
+        if (pArena == &mArenas[mActiveArena.load()])
         {
-            mSubscribers[typeid(TEvent)] = std::make_unique<THandlerList>();
+            break;
         }
-        mSubscribers.at(typeid(TEvent))
-          ->emplace_back(std::make_unique<EventCallback<TOwner, TEvent>>(pOwner, callback));
+        pArena->writers.fetch_sub(1);
     }
 
-    template <typename TEvent, typename... TArgs>
-    void emitEvent(TArgs&&... args)
+    auto offset = pArena->head.load(std::memory_order_relaxed);
+    do
     {
-        auto handlers{ mSubscribers.at(typeid(TEvent)).get() };
-        if (handlers)
+        if (offset + recordSize > mArenaSize)
         {
-            for (auto it{ handlers->begin() }; it != handlers->end(); ++it)
-            {
-                auto handler{ it->get() };
-                TEvent event(std::forward<TArgs>(args)...);
-                handler->execute(event);
-            }
+            pArena->writers.fetch_sub(1);
+            mDroppedEventsNumber.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
+    } while (!pArena->head.compare_exchange_weak(offset, offset + recordSize, std::memory_order_relaxed));
+
+    auto* const pRecord = pArena->data.get() + offset;
+    auto* const pQueuedEvent = new (pRecord) QueuedEvent{
+        .dispatch = [](const EventBus& bus, void* const pEvent) { bus.dispatch(*static_cast<TEvent*>(pEvent)); },
+        .destroy = [](void* const pEvent) { static_cast<TEvent*>(pEvent)->~TEvent(); },
+        .size = recordSize};
+
+    try
+    {
+        new (pRecord + queuedEventOffset) TEvent(std::forward<TArgs>(args)...);
+    }
+    catch (...)
+    {
+        pQueuedEvent->dispatch = nullptr;
+        pArena->writers.fetch_sub(1);
+        throw;
     }
 
-private:
-    std::map<std::type_index, std::unique_ptr<THandlerList>> mSubscribers;
-};
+    pArena->writers.fetch_sub(1);
+    return true;
+}
+
+template <IsEvent TEvent, typename TOwner>
+void EventBus::invokeMember(const Handler& handler, Event& event)
+{
+    void (TOwner::*callback)(TEvent&);
+    std::memcpy(&callback, handler.callback.data(), sizeof(callback));
+    std::invoke(callback, static_cast<TOwner*>(handler.pOwner), static_cast<TEvent&>(event));
+}
+
+template <IsEvent TEvent>
+void EventBus::dispatch(TEvent& event) const
+{
+    const auto typeId = EventType<TEvent>::getId();
+    if (typeId >= mHandlersPerType.size())
+    {
+        return;
+    }
+
+    for (const auto& handler : mHandlersPerType[typeId])
+    {
+        handler.invoke(handler, event);
+    }
+}
 } // namespace ver
 } // namespace ts
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Fence which is signaled once every job assigned to it is finished
+class JobCounter final
+{
+    TS_NOT_COPYABLE_AND_MOVEABLE(JobCounter);
+
+public:
+    JobCounter() = default;
+
+    bool isDone() const { return mPendingJobs.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<size_t> mPendingJobs{};
+    std::exception_ptr mException;
+    std::mutex mExceptionMutex;
+};
+
+// Every thread owns a deque of jobs, it takes the newest jobs from its own deque
+// and when it runs out of them, it steals the oldest ones from the others.
+// Threads which aren't owned by the job system submit to the shared deque.
+class JobSystem final
+{
+    TS_NOT_COPYABLE_AND_MOVEABLE(JobSystem);
+
+public:
+    using Job = std::function<void()>;
+
+    JobSystem(const size_t threadsNumber = std::thread::hardware_concurrency());
+    ~JobSystem();
+
+    void run(Job job, JobCounter* const counter = nullptr);
+
+    // Executes pending jobs while waiting and sleeps when there are none, rethrows the first exception thrown
+    // by the counter jobs
+    void wait(JobCounter& counter);
+
+    // Rethrows the first exception thrown by the jobs without a counter since the last call, nothing else
+    // reports them. The engine calls it once per frame.
+    void rethrowDetachedException();
+
+    template<typename TFunc>
+    void parallelFor(const size_t begin, const size_t end, TFunc&& func, size_t grainSize = 0);
+
+    size_t getThreadsNumber() const { return mQueues.size(); }
+
+private:
+    struct Queue
+    {
+        std::deque<std::pair<Job, JobCounter*>> jobs;
+        std::mutex mutex;
+    };
+
+    void workerLoop(const size_t queueIndex);
+    bool tryExecuteJob(const size_t queueIndex);
+    void execute(std::pair<Job, JobCounter*>& job);
+
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mWorkers;
+    std::atomic<size_t> mQueuedJobs{};
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    bool mIsStopping{};
+    // First exception of the jobs without a counter, nothing waits for them
+    std::exception_ptr mDetachedException;
+    std::mutex mDetachedExceptionMutex;
+};
+
+JobSystem& getJobSystem();
+
+// Calls func(index) for every index in [begin, end), the calling thread participates in the work
+template<typename TFunc>
+void JobSystem::parallelFor(const size_t begin, const size_t end, TFunc&& func, size_t grainSize)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    if (grainSize == 0)
+    {
+        static constexpr size_t chunksPerThread{4};
+        grainSize = std::max<size_t>(1, (end - begin) / (getThreadsNumber() * chunksPerThread));
+    }
+
+    JobCounter counter;
+    for (auto chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+    {
+        const auto chunkEnd = std::min(end, chunkBegin + grainSize);
+        run([&func, chunkBegin, chunkEnd] {
+            for (auto index = chunkBegin; index < chunkEnd; ++index)
+            {
+                func(index);
+            }
+        }, &counter);
+    }
+
+    wait(counter);
+}
+} // namespace ver
+} // namespace ts
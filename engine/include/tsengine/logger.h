@@ -56,6 +56,19 @@ void error(
     int lineNumber,
     bool throwException = true,
     bool debugBreak = true);
+
+// Messages are written by a background thread. When its queue is full, the ones logged meanwhile wait for it
+// by default. Infos can be dropped instead, their number is reported then, warnings and errors always wait.
+enum class OverflowPolicy
+{
+    BLOCK,
+    DROP
+};
+
+void setOverflowPolicy(const OverflowPolicy policy);
+// Waits until every message logged before is written, errors and the debug breaks do it on their own.
+// The engine calls it on the shutdown, the messages logged later may not be written.
+void flush();
 } // namespace logger
 } // namespace ver
 } // namespace ts
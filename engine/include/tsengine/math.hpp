@@ -2,6 +2,19 @@
 
 #include "utils.hpp"
 
+#include <type_traits>
+
+// The SIMD backend is selected at compile time, TS_MATH_NO_SIMD forces the scalar code
+#ifndef TS_MATH_NO_SIMD
+#if defined(_M_X64) || defined(__SSE2__)
+#define TS_MATH_SSE
+#include <xmmintrin.h>
+#elif defined(_M_ARM64) || defined(__ARM_NEON)
+#define TS_MATH_NEON
+#include <arm_neon.h>
+#endif
+#endif // TS_MATH_NO_SIMD
+
 // TODO: column major
 namespace ts::math
 {
@@ -66,8 +79,8 @@ struct Vec4 final
     constexpr Vec4() = default;
     constexpr Vec4(const float v);
     constexpr Vec4(const float x_, const float y_, const float z_, const float w_);
-    [[nodiscard]] constexpr Vec4 operator*(const float scalar) const { return {x * scalar, y * scalar, z * scalar, w * scalar}; }
-    [[nodiscard]] constexpr Vec4 operator+(const Vec4& rhs) const { return {x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w}; }
+    [[nodiscard]] constexpr Vec4 operator*(const float scalar) const;
+    [[nodiscard]] constexpr Vec4 operator+(const Vec4& rhs) const;
     constexpr Vec4& operator+=(const Vec4& rhs);
     constexpr auto operator<=>(const Vec4& other) const = default;
 
@@ -136,19 +149,35 @@ struct Mat4
 
     Vec4& operator[](const size_t index);
     const Vec4& operator[](const size_t index) const;
+    constexpr bool operator==(const Mat4& other) const = default;
 };
 
 inline constexpr Mat4 operator*(const Mat4& lhs, const Mat4& rhs);
+inline constexpr Vec4 operator*(const Mat4& mat, const Vec4& vec);
 inline constexpr Mat4 transpose(const Mat4& mat);
+inline Mat4 inverse(const Mat4& mat);
 inline constexpr Mat4 translate(const Mat4& matrix, const Vec3& translation);
 inline constexpr Mat4 scale(const Mat4& matrix, const Vec3& scaleVec);
 inline std::string to_string(const Mat4 mat);
 
+// Unit quaternions represent rotations, the default one is the identity
 struct Quat
 {
-    float w, x, y, z;
+    float w{1.f}, x{}, y{}, z{};
 };
 
+inline constexpr Quat operator*(const Quat& lhs, const Quat& rhs);
+inline constexpr Quat conjugate(const Quat& quat);
+inline constexpr float dot(const Quat& lhs, const Quat& rhs);
+inline Quat normalize(const Quat& quat);
+inline Quat angleAxis(const float angle, const Vec3& axis);
+inline constexpr Vec3 rotate(const Quat& quat, const Vec3& vec);
+inline Quat nlerp(const Quat& start, const Quat& end, const float t);
+inline Quat slerp(const Quat& start, const Quat& end, const float t);
+
+// Model matrix which scales, rotates and then translates
+inline constexpr Mat4 trs(const Vec3& translation, const Quat& rotation, const Vec3& scaleVec);
+
 inline constexpr Vec2::Vec2(const float v) : x{v}, y{v} {}
 inline constexpr Vec2::Vec2(const Vec3& vec3) : x{vec3.x}, y{vec3.y} {}
 inline constexpr Vec2::Vec2(const Vec4& vec4) : x{vec4.x}, y{vec4.y} {}
@@ -161,6 +190,9 @@ inline auto radians(T degrees)
     return degrees * factor;
 }
 
+// Reference implementations, the constant evaluation always uses them
+namespace scalar
+{
 inline Mat4 inverse(const Mat4& mat)
 {
     const auto det23zw = mat[2].z * mat[3].w - mat[3].z * mat[2].w;
@@ -206,6 +238,223 @@ inline Mat4 inverse(const Mat4& mat)
         tempInverse03 / det, (+(mat[0].x * det23yz - mat[0].y * det23xz + mat[0].z * det23xy)) / det, (-(mat[0].x * det13yz - mat[0].y * det13xz + mat[0].z * det13xy)) / det, (+(mat[0].x * det12yz - mat[0].y * det12xz + mat[0].z * det12xy)) / det,
     };
 }
+} // namespace scalar
+
+#if defined(TS_MATH_SSE) || defined(TS_MATH_NEON)
+#define TS_MATH_SIMD
+
+// Every lane does the same operations in the same order as the scalar code, so the results are bit exact
+namespace simd
+{
+#ifdef TS_MATH_SSE
+#define TS_MATH_SHUFFLE(vec, x, y, z, w) _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(w, z, y, x))
+
+inline __m128 linearCombination(const Mat4& mat, const Vec4& weights)
+{
+    const auto weightsVec = _mm_loadu_ps(&weights.x);
+    auto result = _mm_mul_ps(_mm_loadu_ps(&mat.data[0].x), TS_MATH_SHUFFLE(weightsVec, 0, 0, 0, 0));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&mat.data[1].x), TS_MATH_SHUFFLE(weightsVec, 1, 1, 1, 1)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&mat.data[2].x), TS_MATH_SHUFFLE(weightsVec, 2, 2, 2, 2)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&mat.data[3].x), TS_MATH_SHUFFLE(weightsVec, 3, 3, 3, 3)));
+
+    return result;
+}
+
+inline Mat4 multiply(const Mat4& lhs, const Mat4& rhs)
+{
+    Mat4 result;
+    for (size_t i{}; i < 4; ++i)
+    {
+        _mm_storeu_ps(&result.data[i].x, linearCombination(lhs, rhs.data[i]));
+    }
+
+    return result;
+}
+
+inline Vec4 multiply(const Mat4& mat, const Vec4& vec)
+{
+    Vec4 result;
+    _mm_storeu_ps(&result.x, linearCombination(mat, vec));
+
+    return result;
+}
+
+inline Vec4 multiply(const Vec4& vec, const float scalar)
+{
+    Vec4 result;
+    _mm_storeu_ps(&result.x, _mm_mul_ps(_mm_loadu_ps(&vec.x), _mm_set1_ps(scalar)));
+
+    return result;
+}
+
+inline Vec4 add(const Vec4& lhs, const Vec4& rhs)
+{
+    Vec4 result;
+    _mm_storeu_ps(&result.x, _mm_add_ps(_mm_loadu_ps(&lhs.x), _mm_loadu_ps(&rhs.x)));
+
+    return result;
+}
+
+inline Mat4 transpose(const Mat4& mat)
+{
+    auto column0 = _mm_loadu_ps(&mat.data[0].x);
+    auto column1 = _mm_loadu_ps(&mat.data[1].x);
+    auto column2 = _mm_loadu_ps(&mat.data[2].x);
+    auto column3 = _mm_loadu_ps(&mat.data[3].x);
+    _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+
+    Mat4 result;
+    _mm_storeu_ps(&result.data[0].x, column0);
+    _mm_storeu_ps(&result.data[1].x, column1);
+    _mm_storeu_ps(&result.data[2].x, column2);
+    _mm_storeu_ps(&result.data[3].x, column3);
+
+    return result;
+}
+
+// 2x2 determinants of the columns a and b, in the lanes order used by cofactors()
+struct PairDeterminants
+{
+    __m128 zwZwYwYz;
+    __m128 ywXwXwXz;
+    __m128 yzXzXyXy;
+};
+
+inline PairDeterminants pairDeterminants(const __m128 a, const __m128 b)
+{
+    const auto aZzyy = TS_MATH_SHUFFLE(a, 2, 2, 1, 1);
+    const auto bZzyy = TS_MATH_SHUFFLE(b, 2, 2, 1, 1);
+    const auto aYxxx = TS_MATH_SHUFFLE(a, 1, 0, 0, 0);
+    const auto bYxxx = TS_MATH_SHUFFLE(b, 1, 0, 0, 0);
+    const auto aWwwz = TS_MATH_SHUFFLE(a, 3, 3, 3, 2);
+    const auto bWwwz = TS_MATH_SHUFFLE(b, 3, 3, 3, 2);
+
+    return {
+        .zwZwYwYz = _mm_sub_ps(_mm_mul_ps(aZzyy, bWwwz), _mm_mul_ps(bZzyy, aWwwz)),
+        .ywXwXwXz = _mm_sub_ps(_mm_mul_ps(aYxxx, bWwwz), _mm_mul_ps(bYxxx, aWwwz)),
+        .yzXzXyXy = _mm_sub_ps(_mm_mul_ps(aYxxx, bZzyy), _mm_mul_ps(bYxxx, aZzyy)),
+    };
+}
+
+inline __m128 cofactors(const __m128 column, const PairDeterminants& determinants, const __m128 signs)
+{
+    const auto product0 = _mm_mul_ps(TS_MATH_SHUFFLE(column, 1, 0, 0, 0), determinants.zwZwYwYz);
+    const auto product1 = _mm_mul_ps(TS_MATH_SHUFFLE(column, 2, 2, 1, 1), determinants.ywXwXwXz);
+    const auto product2 = _mm_mul_ps(TS_MATH_SHUFFLE(column, 3, 3, 3, 2), determinants.yzXzXyXy);
+
+    return _mm_mul_ps(_mm_add_ps(_mm_sub_ps(product0, product1), product2), signs);
+}
+
+inline Mat4 inverse(const Mat4& mat)
+{
+    const auto column0 = _mm_loadu_ps(&mat.data[0].x);
+    const auto column1 = _mm_loadu_ps(&mat.data[1].x);
+    const auto column2 = _mm_loadu_ps(&mat.data[2].x);
+    const auto column3 = _mm_loadu_ps(&mat.data[3].x);
+
+    const auto determinants23 = pairDeterminants(column2, column3);
+    const auto determinants13 = pairDeterminants(column1, column3);
+    const auto determinants12 = pairDeterminants(column1, column2);
+
+    const auto evenSigns = _mm_setr_ps(1.f, -1.f, 1.f, -1.f);
+    const auto oddSigns = _mm_setr_ps(-1.f, 1.f, -1.f, 1.f);
+
+    const auto tempInverse0 = cofactors(column1, determinants23, evenSigns);
+
+    Vec4 detProducts;
+    _mm_storeu_ps(&detProducts.x, _mm_mul_ps(column0, tempInverse0));
+    const auto det = detProducts.x + detProducts.y + detProducts.z + detProducts.w;
+
+    if (det == 0)
+    {
+        throw Exception{"Singular matrix, can't find its inversion."};
+    }
+
+    const auto detVec = _mm_set1_ps(det);
+
+    // Cofactors are computed per row of the result
+    Mat4 rows;
+    _mm_storeu_ps(&rows.data[0].x, _mm_div_ps(tempInverse0, detVec));
+    _mm_storeu_ps(&rows.data[1].x, _mm_div_ps(cofactors(column0, determinants23, oddSigns), detVec));
+    _mm_storeu_ps(&rows.data[2].x, _mm_div_ps(cofactors(column0, determinants13, evenSigns), detVec));
+    _mm_storeu_ps(&rows.data[3].x, _mm_div_ps(cofactors(column0, determinants12, oddSigns), detVec));
+
+    return simd::transpose(rows);
+}
+
+#undef TS_MATH_SHUFFLE
+#else
+inline float32x4_t linearCombination(const Mat4& mat, const Vec4& weights)
+{
+    auto result = vmulq_n_f32(vld1q_f32(&mat.data[0].x), weights.x);
+    result = vaddq_f32(result, vmulq_n_f32(vld1q_f32(&mat.data[1].x), weights.y));
+    result = vaddq_f32(result, vmulq_n_f32(vld1q_f32(&mat.data[2].x), weights.z));
+    result = vaddq_f32(result, vmulq_n_f32(vld1q_f32(&mat.data[3].x), weights.w));
+
+    return result;
+}
+
+inline Mat4 multiply(const Mat4& lhs, const Mat4& rhs)
+{
+    Mat4 result;
+    for (size_t i{}; i < 4; ++i)
+    {
+        vst1q_f32(&result.data[i].x, linearCombination(lhs, rhs.data[i]));
+    }
+
+    return result;
+}
+
+inline Vec4 multiply(const Mat4& mat, const Vec4& vec)
+{
+    Vec4 result;
+    vst1q_f32(&result.x, linearCombination(mat, vec));
+
+    return result;
+}
+
+inline Vec4 multiply(const Vec4& vec, const float scalar)
+{
+    Vec4 result;
+    vst1q_f32(&result.x, vmulq_n_f32(vld1q_f32(&vec.x), scalar));
+
+    return result;
+}
+
+inline Vec4 add(const Vec4& lhs, const Vec4& rhs)
+{
+    Vec4 result;
+    vst1q_f32(&result.x, vaddq_f32(vld1q_f32(&lhs.x), vld1q_f32(&rhs.x)));
+
+    return result;
+}
+
+inline Mat4 transpose(const Mat4& mat)
+{
+    // The deinterleaving load puts every fourth float into one register, which gives the rows
+    const auto rows = vld4q_f32(&mat.data[0].x);
+
+    Mat4 result;
+    vst1q_f32(&result.data[0].x, rows.val[0]);
+    vst1q_f32(&result.data[1].x, rows.val[1]);
+    vst1q_f32(&result.data[2].x, rows.val[2]);
+    vst1q_f32(&result.data[3].x, rows.val[3]);
+
+    return result;
+}
+#endif // TS_MATH_SSE
+} // namespace simd
+#endif // TS_MATH_SSE || TS_MATH_NEON
+
+inline Mat4 inverse(const Mat4& mat)
+{
+    // NEON has no inverse of its own, it uses the scalar one
+#ifdef TS_MATH_SSE
+    return simd::inverse(mat);
+#else
+    return scalar::inverse(mat);
+#endif // TS_MATH_SSE
+}
 
 inline constexpr Vec2& Vec2::operator+=(const Vec2& rhs)
 {
@@ -238,13 +487,33 @@ inline Vec3 normalize(const Vec3& vec)
     return {vec.x / mag, vec.y / mag, vec.z / mag};
 }
 
+inline constexpr Vec4 Vec4::operator*(const float scalar) const
+{
+#ifdef TS_MATH_SIMD
+    if (!std::is_constant_evaluated())
+    {
+        return simd::multiply(*this, scalar);
+    }
+#endif // TS_MATH_SIMD
+
+    return {x * scalar, y * scalar, z * scalar, w * scalar};
+}
+
+inline constexpr Vec4 Vec4::operator+(const Vec4& rhs) const
+{
+#ifdef TS_MATH_SIMD
+    if (!std::is_constant_evaluated())
+    {
+        return simd::add(*this, rhs);
+    }
+#endif // TS_MATH_SIMD
+
+    return {x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w};
+}
+
 inline constexpr Vec4& Vec4::operator+=(const Vec4& rhs)
 {
-    x += rhs.x;
-    y += rhs.y;
-    z += rhs.z;
-    w += rhs.w;
-    return *this;
+    return *this = *this + rhs;
 }
 
 inline Vec4 normalize(const Vec4& vec)
@@ -548,7 +817,9 @@ inline const Vec4& Mat4::operator[](const size_t index) const
     return data[index];
 }
 
-inline constexpr Mat4 operator*(const Mat4& lhs, const Mat4& rhs)
+namespace scalar
+{
+inline constexpr Mat4 multiply(const Mat4& lhs, const Mat4& rhs)
 {
     return
     {
@@ -574,6 +845,17 @@ inline constexpr Mat4 operator*(const Mat4& lhs, const Mat4& rhs)
     };
 }
 
+inline constexpr Vec4 multiply(const Mat4& mat, const Vec4& vec)
+{
+    return
+    {
+        vec.x * mat.data[0].x + vec.y * mat.data[1].x + vec.z * mat.data[2].x + vec.w * mat.data[3].x,
+        vec.x * mat.data[0].y + vec.y * mat.data[1].y + vec.z * mat.data[2].y + vec.w * mat.data[3].y,
+        vec.x * mat.data[0].z + vec.y * mat.data[1].z + vec.z * mat.data[2].z + vec.w * mat.data[3].z,
+        vec.x * mat.data[0].w + vec.y * mat.data[1].w + vec.z * mat.data[2].w + vec.w * mat.data[3].w,
+    };
+}
+
 inline constexpr Mat4 transpose(const Mat4& mat)
 {
     return
@@ -584,6 +866,43 @@ inline constexpr Mat4 transpose(const Mat4& mat)
         mat.data[0].w, mat.data[1].w, mat.data[2].w, mat.data[3].w,
     };
 }
+} // namespace scalar
+
+inline constexpr Mat4 operator*(const Mat4& lhs, const Mat4& rhs)
+{
+#ifdef TS_MATH_SIMD
+    if (!std::is_constant_evaluated())
+    {
+        return simd::multiply(lhs, rhs);
+    }
+#endif // TS_MATH_SIMD
+
+    return scalar::multiply(lhs, rhs);
+}
+
+inline constexpr Vec4 operator*(const Mat4& mat, const Vec4& vec)
+{
+#ifdef TS_MATH_SIMD
+    if (!std::is_constant_evaluated())
+    {
+        return simd::multiply(mat, vec);
+    }
+#endif // TS_MATH_SIMD
+
+    return scalar::multiply(mat, vec);
+}
+
+inline constexpr Mat4 transpose(const Mat4& mat)
+{
+#ifdef TS_MATH_SIMD
+    if (!std::is_constant_evaluated())
+    {
+        return simd::transpose(mat);
+    }
+#endif // TS_MATH_SIMD
+
+    return scalar::transpose(mat);
+}
 
 inline constexpr Mat4 translate(const Mat4& matrix, const Vec3& translation)
 {
@@ -685,5 +1004,107 @@ Vec4 lerp(const Vec4 start, const Vec4 end, const float t)
         start.w + t * (end.w - start.w)
     };
 }
+
+inline constexpr Quat operator*(const Quat& lhs, const Quat& rhs)
+{
+    return
+    {
+        lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z,
+        lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+        lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
+        lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w,
+    };
+}
+
+inline constexpr Quat conjugate(const Quat& quat)
+{
+    return {quat.w, -quat.x, -quat.y, -quat.z};
+}
+
+inline constexpr float dot(const Quat& lhs, const Quat& rhs)
+{
+    return lhs.w * rhs.w + lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+}
+
+inline Quat normalize(const Quat& quat)
+{
+    const auto mag = std::sqrt(dot(quat, quat));
+    return {quat.w / mag, quat.x / mag, quat.y / mag, quat.z / mag};
+}
+
+inline Quat angleAxis(const float angle, const Vec3& axis)
+{
+    const auto normalizedAxis = normalize(axis);
+    const auto s = std::sin(angle / 2);
+
+    return {std::cos(angle / 2), normalizedAxis.x * s, normalizedAxis.y * s, normalizedAxis.z * s};
+}
+
+inline constexpr Vec3 rotate(const Quat& quat, const Vec3& vec)
+{
+    // v' = v + 2w(q x v) + 2q x (q x v), where q is the vector part
+    const Vec3 qCrossV{
+        quat.y * vec.z - quat.z * vec.y,
+        quat.z * vec.x - quat.x * vec.z,
+        quat.x * vec.y - quat.y * vec.x,
+    };
+    const Vec3 qCrossQCrossV{
+        quat.y * qCrossV.z - quat.z * qCrossV.y,
+        quat.z * qCrossV.x - quat.x * qCrossV.z,
+        quat.x * qCrossV.y - quat.y * qCrossV.x,
+    };
+
+    return vec + qCrossV * (2 * quat.w) + qCrossQCrossV * 2.f;
+}
+
+inline Quat nlerp(const Quat& start, const Quat& end, const float t)
+{
+    // q and -q are the same rotation, the shorter path is taken
+    const auto sign = (dot(start, end) < 0.f) ? -1.f : 1.f;
+
+    return normalize(Quat{
+        start.w + t * (sign * end.w - start.w),
+        start.x + t * (sign * end.x - start.x),
+        start.y + t * (sign * end.y - start.y),
+        start.z + t * (sign * end.z - start.z),
+    });
+}
+
+inline Quat slerp(const Quat& start, const Quat& end, const float t)
+{
+    auto cosTheta = dot(start, end);
+    const auto sign = (cosTheta < 0.f) ? -1.f : 1.f;
+    cosTheta *= sign;
+
+    // Almost the same rotations, sin(theta) is close to zero
+    if (cosTheta > 0.9995f)
+    {
+        return nlerp(start, end, t);
+    }
+
+    const auto theta = std::acos(cosTheta);
+    const auto sinTheta = std::sin(theta);
+    const auto startWeight = std::sin((1 - t) * theta) / sinTheta;
+    const auto endWeight = sign * std::sin(t * theta) / sinTheta;
+
+    return
+    {
+        startWeight * start.w + endWeight * end.w,
+        startWeight * start.x + endWeight * end.x,
+        startWeight * start.y + endWeight * end.y,
+        startWeight * start.z + endWeight * end.z,
+    };
+}
+
+inline constexpr Mat4 trs(const Vec3& translation, const Quat& rotation, const Vec3& scaleVec)
+{
+    auto result = Mat4{rotation};
+    result.data[0] = result.data[0] * scaleVec.x;
+    result.data[1] = result.data[1] * scaleVec.y;
+    result.data[2] = result.data[2] * scaleVec.z;
+    result.data[3] = {translation.x, translation.y, translation.z, 1.f};
+
+    return result;
+}
 } // namespace ver
 } // namespace ts
\ No newline at end of file
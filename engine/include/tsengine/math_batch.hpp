@@ -0,0 +1,221 @@
+#pragma once
+
+#include "math.hpp"
+
+// Batch versions of the math.hpp operations, the data is kept as a structure of arrays,
+// so every SIMD lane works on a different element and the results are bit exact with the scalar ones
+namespace ts::math
+{
+inline namespace TS_VER
+{
+struct Vec3Array final
+{
+    std::vector<float> x, y, z;
+
+    size_t size() const { return x.size(); }
+    void resize(const size_t size);
+    Vec3 get(const size_t index) const { return {x[index], y[index], z[index]}; }
+    void set(const size_t index, const Vec3& vec);
+};
+
+class Mat4Array final
+{
+public:
+    // Matrices are grouped in blocks, so one SIMD register holds the same element of every matrix in the block
+    static constexpr size_t blockSize{4};
+    static constexpr size_t blockElementsNumber{16 * blockSize};
+
+    size_t size() const { return mSize; }
+    size_t getBlocksNumber() const { return (mSize + blockSize - 1) / blockSize; }
+    void resize(const size_t size);
+    Mat4 get(const size_t index) const;
+    void set(const size_t index, const Mat4& mat);
+
+    // Element at the column c and the row r of the matrix in the lane is at [(c * 4 + r) * blockSize + lane]
+    float* getBlock(const size_t blockIndex) { return &mElements[blockIndex * blockElementsNumber]; }
+    const float* getBlock(const size_t blockIndex) const { return &mElements[blockIndex * blockElementsNumber]; }
+
+private:
+    std::vector<float> mElements;
+    size_t mSize{};
+};
+
+// Points have the w equal to 1
+inline void transformPoints(const Mat4& mat, const Vec3Array& points, Vec3Array& result);
+// The result can be the same array as the lhs, but not as the rhs
+inline void multiply(const Mat4Array& lhs, const Mat4Array& rhs, Mat4Array& result);
+inline void normalize(Vec3Array& vectors);
+
+inline void Vec3Array::resize(const size_t size)
+{
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+}
+
+inline void Vec3Array::set(const size_t index, const Vec3& vec)
+{
+    x[index] = vec.x;
+    y[index] = vec.y;
+    z[index] = vec.z;
+}
+
+inline void Mat4Array::resize(const size_t size)
+{
+    mSize = size;
+    mElements.resize(getBlocksNumber() * blockElementsNumber);
+}
+
+inline Mat4 Mat4Array::get(const size_t index) const
+{
+    const auto block = getBlock(index / blockSize);
+    const auto lane = index % blockSize;
+
+    Mat4 mat;
+    for (size_t column{}; column < 4; ++column)
+    {
+        mat.data[column] = {
+            block[(column * 4 + 0) * blockSize + lane],
+            block[(column * 4 + 1) * blockSize + lane],
+            block[(column * 4 + 2) * blockSize + lane],
+            block[(column * 4 + 3) * blockSize + lane],
+        };
+    }
+
+    return mat;
+}
+
+inline void Mat4Array::set(const size_t index, const Mat4& mat)
+{
+    const auto block = getBlock(index / blockSize);
+    const auto lane = index % blockSize;
+
+    for (size_t column{}; column < 4; ++column)
+    {
+        block[(column * 4 + 0) * blockSize + lane] = mat.data[column].x;
+        block[(column * 4 + 1) * blockSize + lane] = mat.data[column].y;
+        block[(column * 4 + 2) * blockSize + lane] = mat.data[column].z;
+        block[(column * 4 + 3) * blockSize + lane] = mat.data[column].w;
+    }
+}
+
+inline void transformPoints(const Mat4& mat, const Vec3Array& points, Vec3Array& result)
+{
+    const auto count = points.size();
+    result.resize(count);
+
+    size_t i{};
+#ifdef TS_MATH_SSE
+    std::array<__m128, 16> matElements;
+    for (size_t column{}; column < 4; ++column)
+    {
+        matElements[column * 4 + 0] = _mm_set1_ps(mat.data[column].x);
+        matElements[column * 4 + 1] = _mm_set1_ps(mat.data[column].y);
+        matElements[column * 4 + 2] = _mm_set1_ps(mat.data[column].z);
+        matElements[column * 4 + 3] = _mm_set1_ps(mat.data[column].w);
+    }
+
+    const auto one = _mm_set1_ps(1.f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const auto x = _mm_loadu_ps(&points.x[i]);
+        const auto y = _mm_loadu_ps(&points.y[i]);
+        const auto z = _mm_loadu_ps(&points.z[i]);
+
+        std::array<__m128, 3> transformed;
+        for (size_t row{}; row < 3; ++row)
+        {
+            auto value = _mm_mul_ps(x, matElements[0 * 4 + row]);
+            value = _mm_add_ps(value, _mm_mul_ps(y, matElements[1 * 4 + row]));
+            value = _mm_add_ps(value, _mm_mul_ps(z, matElements[2 * 4 + row]));
+            value = _mm_add_ps(value, _mm_mul_ps(one, matElements[3 * 4 + row]));
+            transformed[row] = value;
+        }
+
+        _mm_storeu_ps(&result.x[i], transformed[0]);
+        _mm_storeu_ps(&result.y[i], transformed[1]);
+        _mm_storeu_ps(&result.z[i], transformed[2]);
+    }
+#endif // TS_MATH_SSE
+
+    for (; i < count; ++i)
+    {
+        const Vec3 transformed = scalar::multiply(mat, Vec4{points.x[i], points.y[i], points.z[i], 1.f});
+        result.set(i, transformed);
+    }
+}
+
+inline void multiply(const Mat4Array& lhs, const Mat4Array& rhs, Mat4Array& result)
+{
+    if (lhs.size() != rhs.size())
+    {
+        throw Exception{"Matrix arrays have different sizes."};
+    }
+
+    result.resize(lhs.size());
+
+#ifdef TS_MATH_SSE
+    static_assert(Mat4Array::blockSize == 4);
+
+    // Unused lanes of the last block are zeroed, so they can be multiplied too
+    for (size_t blockIndex{}; blockIndex < lhs.getBlocksNumber(); ++blockIndex)
+    {
+        const auto lhsBlock = lhs.getBlock(blockIndex);
+        const auto rhsBlock = rhs.getBlock(blockIndex);
+        const auto resultBlock = result.getBlock(blockIndex);
+
+        for (size_t row{}; row < 4; ++row)
+        {
+            const auto lhs0 = _mm_loadu_ps(&lhsBlock[(0 * 4 + row) * 4]);
+            const auto lhs1 = _mm_loadu_ps(&lhsBlock[(1 * 4 + row) * 4]);
+            const auto lhs2 = _mm_loadu_ps(&lhsBlock[(2 * 4 + row) * 4]);
+            const auto lhs3 = _mm_loadu_ps(&lhsBlock[(3 * 4 + row) * 4]);
+
+            for (size_t column{}; column < 4; ++column)
+            {
+                auto value = _mm_mul_ps(_mm_loadu_ps(&rhsBlock[(column * 4 + 0) * 4]), lhs0);
+                value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(&rhsBlock[(column * 4 + 1) * 4]), lhs1));
+                value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(&rhsBlock[(column * 4 + 2) * 4]), lhs2));
+                value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(&rhsBlock[(column * 4 + 3) * 4]), lhs3));
+                _mm_storeu_ps(&resultBlock[(column * 4 + row) * 4], value);
+            }
+        }
+    }
+#else
+    for (size_t i{}; i < lhs.size(); ++i)
+    {
+        result.set(i, scalar::multiply(lhs.get(i), rhs.get(i)));
+    }
+#endif // TS_MATH_SSE
+}
+
+inline void normalize(Vec3Array& vectors)
+{
+    const auto count = vectors.size();
+
+    size_t i{};
+#ifdef TS_MATH_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        const auto x = _mm_loadu_ps(&vectors.x[i]);
+        const auto y = _mm_loadu_ps(&vectors.y[i]);
+        const auto z = _mm_loadu_ps(&vectors.z[i]);
+
+        auto squaredMag = _mm_mul_ps(x, x);
+        squaredMag = _mm_add_ps(squaredMag, _mm_mul_ps(y, y));
+        squaredMag = _mm_add_ps(squaredMag, _mm_mul_ps(z, z));
+        const auto mag = _mm_sqrt_ps(squaredMag);
+
+        _mm_storeu_ps(&vectors.x[i], _mm_div_ps(x, mag));
+        _mm_storeu_ps(&vectors.y[i], _mm_div_ps(y, mag));
+        _mm_storeu_ps(&vectors.z[i], _mm_div_ps(z, mag));
+    }
+#endif // TS_MATH_SSE
+
+    for (; i < count; ++i)
+    {
+        vectors.set(i, math::normalize(vectors.get(i)));
+    }
+}
+} // namespace ver
+} // namespace ts
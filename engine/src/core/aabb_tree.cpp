@@ -0,0 +1,513 @@
+#include "aabb_tree.h"
+
+#include <algorithm>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace aabb
+{
+Aabb merge(const Aabb& a, const Aabb& b)
+{
+    return {
+        {std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+        {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)}};
+}
+
+Aabb fatten(const Aabb& box, const float margin)
+{
+    return {
+        {box.min.x - margin, box.min.y - margin, box.min.z - margin},
+        {box.max.x + margin, box.max.y + margin, box.max.z + margin}};
+}
+
+float getSurfaceArea(const Aabb& box)
+{
+    const auto x = box.max.x - box.min.x;
+    const auto y = box.max.y - box.min.y;
+    const auto z = box.max.z - box.min.z;
+    return 2.f * ((x * y) + (y * z) + (z * x));
+}
+
+bool contains(const Aabb& outer, const Aabb& inner)
+{
+    return (outer.min.x <= inner.min.x) && (outer.min.y <= inner.min.y) && (outer.min.z <= inner.min.z) &&
+        (inner.max.x <= outer.max.x) && (inner.max.y <= outer.max.y) && (inner.max.z <= outer.max.z);
+}
+
+bool overlapsSphere(const Aabb& box, const math::Vec3& center, const float radius)
+{
+    const auto x = std::clamp(center.x, box.min.x, box.max.x) - center.x;
+    const auto y = std::clamp(center.y, box.min.y, box.max.y) - center.y;
+    const auto z = std::clamp(center.z, box.min.z, box.max.z) - center.z;
+    return ((x * x) + (y * y) + (z * z)) <= (radius * radius);
+}
+
+float intersectRay(const Aabb& box, const math::Vec3& origin, const math::Vec3& invDirection, const float maxDistance)
+{
+    auto tMin = 0.f;
+    auto tMax = maxDistance;
+    for (const auto& [boxMin, boxMax, rayOrigin, invDir] : {
+        std::array{box.min.x, box.max.x, origin.x, invDirection.x},
+        std::array{box.min.y, box.max.y, origin.y, invDirection.y},
+        std::array{box.min.z, box.max.z, origin.z, invDirection.z}})
+    {
+        // Ray parallel to the slab has the infinite distances, or NaN when it starts on its border, which both
+        // comparisons below ignore
+        auto t1 = (boxMin - rayOrigin) * invDir;
+        auto t2 = (boxMax - rayOrigin) * invDir;
+        if (t1 > t2)
+        {
+            std::swap(t1, t2);
+        }
+
+        tMin = (t1 > tMin) ? t1 : tMin;
+        tMax = (t2 < tMax) ? t2 : tMax;
+        if (tMin > tMax)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+    }
+
+    return tMin;
+}
+
+Aabb transform(const Aabb& box, const math::Mat4& mat)
+{
+    // Center is transformed as a point and the extent by the absolute values of the rotation and scale
+    const math::Vec4 localCenter{
+        (box.min.x + box.max.x) / 2.f,
+        (box.min.y + box.max.y) / 2.f,
+        (box.min.z + box.max.z) / 2.f,
+        1.f};
+    const std::array localExtent{
+        (box.max.x - box.min.x) / 2.f,
+        (box.max.y - box.min.y) / 2.f,
+        (box.max.z - box.min.z) / 2.f};
+
+    const auto center = mat * localCenter;
+    math::Vec3 extent{};
+    for (size_t column{}; column < 3; ++column)
+    {
+        const auto& basis = mat.data[column];
+        extent.x += std::abs(basis.x) * localExtent[column];
+        extent.y += std::abs(basis.y) * localExtent[column];
+        extent.z += std::abs(basis.z) * localExtent[column];
+    }
+
+    return {
+        {center.x - extent.x, center.y - extent.y, center.z - extent.z},
+        {center.x + extent.x, center.y + extent.y, center.z + extent.z}};
+}
+} // namespace aabb
+
+uint32_t AabbTree::createProxy(const Aabb& box, const uint32_t userData)
+{
+    const auto proxy = allocateNode();
+    mNodes[proxy].box = aabb::fatten(box, fatMargin);
+    mNodes[proxy].userData = userData;
+    insertLeaf(proxy);
+    ++mProxiesNumber;
+
+    return proxy;
+}
+
+void AabbTree::destroyProxy(const uint32_t proxy)
+{
+    TS_ASSERT((proxy < mNodes.size()) && mNodes[proxy].isLeaf() && (mNodes[proxy].height == 0));
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --mProxiesNumber;
+}
+
+bool AabbTree::moveProxy(const uint32_t proxy, const Aabb& box)
+{
+    TS_ASSERT((proxy < mNodes.size()) && mNodes[proxy].isLeaf() && (mNodes[proxy].height == 0));
+
+    if (aabb::contains(mNodes[proxy].box, box))
+    {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    mNodes[proxy].box = aabb::fatten(box, fatMargin);
+    insertLeaf(proxy);
+
+    return true;
+}
+
+void AabbTree::setProxyBounds(const uint32_t proxy, const Aabb& box)
+{
+    TS_ASSERT((proxy < mNodes.size()) && mNodes[proxy].isLeaf() && (mNodes[proxy].height == 0));
+
+    mNodes[proxy].box = aabb::fatten(box, fatMargin);
+}
+
+void AabbTree::refit()
+{
+    if (mRoot == nullNode)
+    {
+        return;
+    }
+
+    // Parents precede their children in the pre-order, so the reversed one merges the children first.
+    // The order of the internal nodes is kept until the tree structure changes.
+    if (mRefitOrder.empty() && !mNodes[mRoot].isLeaf())
+    {
+        mRefitOrder.push_back(mRoot);
+        for (size_t i{}; i < mRefitOrder.size(); ++i)
+        {
+            const auto& node = mNodes[mRefitOrder[i]];
+            for (const auto child : {node.child1, node.child2})
+            {
+                if (!mNodes[child].isLeaf())
+                {
+                    mRefitOrder.push_back(child);
+                }
+            }
+        }
+    }
+
+    for (auto it = mRefitOrder.rbegin(); it != mRefitOrder.rend(); ++it)
+    {
+        auto& node = mNodes[*it];
+        node.box = aabb::merge(mNodes[node.child1].box, mNodes[node.child2].box);
+    }
+}
+
+void AabbTree::build(const std::span<const Aabb> boxes, const std::span<const uint32_t> userData)
+{
+    TS_ASSERT(boxes.size() == userData.size());
+
+    clear();
+    if (boxes.empty())
+    {
+        return;
+    }
+
+    mNodes.resize((2 * boxes.size()) - 1);
+    std::vector<uint32_t> leaves(boxes.size());
+    std::vector<math::Vec3> centers(boxes.size());
+    for (uint32_t i{}; i < boxes.size(); ++i)
+    {
+        mNodes[i].box = aabb::fatten(boxes[i], fatMargin);
+        mNodes[i].userData = userData[i];
+        leaves[i] = i;
+        centers[i] = {boxes[i].min.x + boxes[i].max.x, boxes[i].min.y + boxes[i].max.y, boxes[i].min.z + boxes[i].max.z};
+    }
+
+    // Internal nodes are taken from the free list, which is linked after the leaves
+    for (auto i = static_cast<uint32_t>(boxes.size()); i < mNodes.size(); ++i)
+    {
+        mNodes[i].parent = (i + 1 < mNodes.size()) ? (i + 1) : nullNode;
+        mNodes[i].height = -1;
+    }
+    mFreeList = (mNodes.size() > boxes.size()) ? static_cast<uint32_t>(boxes.size()) : nullNode;
+
+    mRoot = buildSubtree(leaves, centers);
+    mNodes[mRoot].parent = nullNode;
+    mProxiesNumber = boxes.size();
+}
+
+void AabbTree::clear()
+{
+    mNodes.clear();
+    mRefitOrder.clear();
+    mRoot = nullNode;
+    mFreeList = nullNode;
+    mProxiesNumber = 0;
+}
+
+bool AabbTree::isValid() const
+{
+    if (mRoot == nullNode)
+    {
+        return mProxiesNumber == 0;
+    }
+
+    if (mNodes[mRoot].parent != nullNode)
+    {
+        return false;
+    }
+
+    size_t leavesNumber{};
+    std::vector<uint32_t> stack{mRoot};
+    while (!stack.empty())
+    {
+        const auto nodeIndex = stack.back();
+        stack.pop_back();
+
+        const auto& node = mNodes[nodeIndex];
+        if (node.isLeaf())
+        {
+            leavesNumber += (node.height == 0);
+            continue;
+        }
+
+        const auto& child1 = mNodes[node.child1];
+        const auto& child2 = mNodes[node.child2];
+        if ((child1.parent != nodeIndex) || (child2.parent != nodeIndex) ||
+            (node.height != 1 + std::max(child1.height, child2.height)) ||
+            !aabb::contains(node.box, child1.box) || !aabb::contains(node.box, child2.box))
+        {
+            return false;
+        }
+
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+    }
+
+    return leavesNumber == mProxiesNumber;
+}
+
+uint32_t AabbTree::allocateNode()
+{
+    if (mFreeList == nullNode)
+    {
+        mNodes.emplace_back();
+        return static_cast<uint32_t>(mNodes.size() - 1);
+    }
+
+    const auto node = mFreeList;
+    mFreeList = mNodes[node].parent;
+    mNodes[node] = {};
+
+    return node;
+}
+
+void AabbTree::freeNode(const uint32_t node)
+{
+    mNodes[node].parent = mFreeList;
+    mNodes[node].child1 = nullNode;
+    mNodes[node].child2 = nullNode;
+    mNodes[node].height = -1;
+    mFreeList = node;
+}
+
+void AabbTree::insertLeaf(const uint32_t leaf)
+{
+    mRefitOrder.clear();
+
+    if (mRoot == nullNode)
+    {
+        mRoot = leaf;
+        mNodes[leaf].parent = nullNode;
+        return;
+    }
+
+    // Descends to the sibling whose merge with the leaf grows the surface areas of the tree the least,
+    // every level down adds the growth of the current node, which all the ancestors inherit
+    const auto leafBox = mNodes[leaf].box;
+    auto index = mRoot;
+    while (!mNodes[index].isLeaf())
+    {
+        const auto& node = mNodes[index];
+        const auto area = aabb::getSurfaceArea(node.box);
+        const auto combinedArea = aabb::getSurfaceArea(aabb::merge(node.box, leafBox));
+
+        const auto cost = 2.f * combinedArea;
+        const auto inheritanceCost = 2.f * (combinedArea - area);
+
+        const auto getChildCost = [&](const uint32_t child) {
+            const auto& childBox = mNodes[child].box;
+            const auto mergedArea = aabb::getSurfaceArea(aabb::merge(childBox, leafBox));
+            return mNodes[child].isLeaf() ?
+                (mergedArea + inheritanceCost) :
+                ((mergedArea - aabb::getSurfaceArea(childBox)) + inheritanceCost);
+        };
+
+        const auto cost1 = getChildCost(node.child1);
+        const auto cost2 = getChildCost(node.child2);
+        if ((cost < cost1) && (cost < cost2))
+        {
+            break;
+        }
+
+        index = (cost1 < cost2) ? node.child1 : node.child2;
+    }
+
+    const auto sibling = index;
+    const auto oldParent = mNodes[sibling].parent;
+    const auto newParent = allocateNode();
+    mNodes[newParent].parent = oldParent;
+    mNodes[newParent].box = aabb::merge(leafBox, mNodes[sibling].box);
+    mNodes[newParent].height = mNodes[sibling].height + 1;
+    mNodes[newParent].child1 = sibling;
+    mNodes[newParent].child2 = leaf;
+    mNodes[sibling].parent = newParent;
+    mNodes[leaf].parent = newParent;
+
+    if (oldParent == nullNode)
+    {
+        mRoot = newParent;
+    }
+    else if (mNodes[oldParent].child1 == sibling)
+    {
+        mNodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        mNodes[oldParent].child2 = newParent;
+    }
+
+    fixUpwards(mNodes[leaf].parent);
+}
+
+void AabbTree::removeLeaf(const uint32_t leaf)
+{
+    mRefitOrder.clear();
+
+    if (leaf == mRoot)
+    {
+        mRoot = nullNode;
+        return;
+    }
+
+    const auto parent = mNodes[leaf].parent;
+    const auto grandParent = mNodes[parent].parent;
+    const auto sibling = (mNodes[parent].child1 == leaf) ? mNodes[parent].child2 : mNodes[parent].child1;
+
+    freeNode(parent);
+    mNodes[sibling].parent = grandParent;
+    if (grandParent == nullNode)
+    {
+        mRoot = sibling;
+        return;
+    }
+
+    if (mNodes[grandParent].child1 == parent)
+    {
+        mNodes[grandParent].child1 = sibling;
+    }
+    else
+    {
+        mNodes[grandParent].child2 = sibling;
+    }
+
+    fixUpwards(grandParent);
+}
+
+void AabbTree::fixUpwards(uint32_t node)
+{
+    while (node != nullNode)
+    {
+        node = balance(node);
+
+        auto& current = mNodes[node];
+        current.height = 1 + std::max(mNodes[current.child1].height, mNodes[current.child2].height);
+        current.box = aabb::merge(mNodes[current.child1].box, mNodes[current.child2].box);
+
+        node = current.parent;
+    }
+}
+
+uint32_t AabbTree::balance(const uint32_t iA)
+{
+    auto& a = mNodes[iA];
+    if (a.isLeaf() || (a.height < 2))
+    {
+        return iA;
+    }
+
+    const auto iB = a.child1;
+    const auto iC = a.child2;
+    auto& b = mNodes[iB];
+    auto& c = mNodes[iC];
+
+    // Higher child takes the place of A, which becomes its child together with the lower grandchild
+    const auto rotateUp = [&](const uint32_t iUp, Node& up, Node& other, uint32_t Node::* const aSlot) {
+        const auto iF = up.child1;
+        const auto iG = up.child2;
+        auto& f = mNodes[iF];
+        auto& g = mNodes[iG];
+
+        up.child1 = iA;
+        up.parent = a.parent;
+        a.parent = iUp;
+
+        if (up.parent == nullNode)
+        {
+            mRoot = iUp;
+        }
+        else if (mNodes[up.parent].child1 == iA)
+        {
+            mNodes[up.parent].child1 = iUp;
+        }
+        else
+        {
+            mNodes[up.parent].child2 = iUp;
+        }
+
+        const auto [iKept, iMoved] = (f.height > g.height) ? std::pair{iF, iG} : std::pair{iG, iF};
+        auto& kept = mNodes[iKept];
+        auto& moved = mNodes[iMoved];
+
+        up.child2 = iKept;
+        a.*aSlot = iMoved;
+        moved.parent = iA;
+
+        a.box = aabb::merge(other.box, moved.box);
+        up.box = aabb::merge(a.box, kept.box);
+        a.height = 1 + std::max(other.height, moved.height);
+        up.height = 1 + std::max(a.height, kept.height);
+
+        return iUp;
+    };
+
+    const auto heightDifference = c.height - b.height;
+    if (heightDifference > 1)
+    {
+        return rotateUp(iC, c, b, &Node::child2);
+    }
+
+    if (heightDifference < -1)
+    {
+        return rotateUp(iB, b, c, &Node::child1);
+    }
+
+    return iA;
+}
+
+uint32_t AabbTree::buildSubtree(const std::span<uint32_t> leaves, const std::span<const math::Vec3> centers)
+{
+    if (leaves.size() == 1)
+    {
+        return leaves.front();
+    }
+
+    // Leaves are split at the median of their centers along the longest axis of the centers bounds
+    Aabb centersBounds{centers[leaves.front()], centers[leaves.front()]};
+    for (const auto leaf : leaves)
+    {
+        centersBounds = aabb::merge(centersBounds, {centers[leaf], centers[leaf]});
+    }
+
+    const std::array axisLengths{
+        centersBounds.max.x - centersBounds.min.x,
+        centersBounds.max.y - centersBounds.min.y,
+        centersBounds.max.z - centersBounds.min.z};
+    const auto splitAxis = static_cast<size_t>(std::distance(axisLengths.begin(), std::ranges::max_element(axisLengths)));
+
+    const auto half = leaves.size() / 2;
+    std::ranges::nth_element(leaves, leaves.begin() + half, {}, [&](const uint32_t leaf) {
+        const auto& center = centers[leaf];
+        return (splitAxis == 0) ? center.x : ((splitAxis == 1) ? center.y : center.z);
+    });
+
+    const auto node = allocateNode();
+    const auto child1 = buildSubtree(leaves.first(half), centers);
+    const auto child2 = buildSubtree(leaves.subspan(half), centers);
+
+    mNodes[node].child1 = child1;
+    mNodes[node].child2 = child2;
+    mNodes[node].box = aabb::merge(mNodes[child1].box, mNodes[child2].box);
+    mNodes[node].height = 1 + std::max(mNodes[child1].height, mNodes[child2].height);
+    mNodes[child1].parent = node;
+    mNodes[child2].parent = node;
+
+    return node;
+}
+} // namespace ver
+} // namespace ts
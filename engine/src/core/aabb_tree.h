@@ -0,0 +1,271 @@
+#pragma once
+
+#include "tsengine/math.hpp"
+#include "tsengine/logger.h"
+
+#include "frustum_culling.h"
+
+#include <span>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+struct Aabb
+{
+    math::Vec3 min, max;
+};
+
+namespace aabb
+{
+Aabb merge(const Aabb& a, const Aabb& b);
+Aabb fatten(const Aabb& box, const float margin);
+float getSurfaceArea(const Aabb& box);
+bool contains(const Aabb& outer, const Aabb& inner);
+bool overlapsSphere(const Aabb& box, const math::Vec3& center, const float radius);
+// Distance along the ray at which it enters the box, the infinity when it misses it within the max distance.
+// Components of the inverted direction may be infinite.
+float intersectRay(const Aabb& box, const math::Vec3& origin, const math::Vec3& invDirection, const float maxDistance);
+// Box enclosing the local box transformed by the matrix
+Aabb transform(const Aabb& box, const math::Mat4& mat);
+} // namespace aabb
+
+struct Ray
+{
+    math::Vec3 origin;
+    // Unit length
+    math::Vec3 direction;
+};
+
+// Dynamic bounding volume hierarchy of boxes. Leaves keep the boxes fattened by a margin, so the proxies moving
+// inside of them don't change the tree, the others are reinserted at the place of the cheapest surface area and
+// the tree is kept balanced by rotations on the way up. Many proxies moved at once can instead set their bounds
+// and refit the tree in one bottom up pass.
+class AabbTree final
+{
+public:
+    static constexpr uint32_t nullNode{std::numeric_limits<uint32_t>::max()};
+    static constexpr float fatMargin{0.1f};
+
+    // Returns the proxy of the box, which stays valid until it's destroyed
+    uint32_t createProxy(const Aabb& box, const uint32_t userData);
+    void destroyProxy(const uint32_t proxy);
+    // Returns true when the proxy left its fat box and was reinserted
+    bool moveProxy(const uint32_t proxy, const Aabb& box);
+    // Changes the box without moving the proxy in the tree, refit has to be called before the next query
+    void setProxyBounds(const uint32_t proxy, const Aabb& box);
+    void refit();
+    // Replaces the tree by one built top down by the median splits, proxy of every box is its index
+    void build(const std::span<const Aabb> boxes, const std::span<const uint32_t> userData);
+    void clear();
+
+    uint32_t getUserData(const uint32_t proxy) const { return mNodes.at(proxy).userData; }
+    const Aabb& getFatBounds(const uint32_t proxy) const { return mNodes.at(proxy).box; }
+    size_t getProxiesNumber() const { return mProxiesNumber; }
+    // Leaf has the height of 0
+    int32_t getHeight() const { return (mRoot == nullNode) ? 0 : mNodes[mRoot].height; }
+    // Checks the links, heights and bounds of all the nodes
+    bool isValid() const;
+
+    // Calls func(proxy) for the proxies whose fat box isn't fully outside of any plane
+    template<typename TFunc>
+    void queryFrustum(const Frustum& frustum, TFunc&& func) const;
+    // Calls func(proxy) for the proxies whose fat box overlaps the sphere
+    template<typename TFunc>
+    void querySphere(const math::Vec3& center, const float radius, TFunc&& func) const;
+    // Calls func(proxy, distance) for the proxies whose fat box the ray enters within the max distance,
+    // the returned distance clips the ray, so returning the hit distance finds the closest one. Max distance is finite.
+    template<typename TFunc>
+    void raycast(const Ray& ray, float maxDistance, TFunc&& func) const;
+
+private:
+    // Stack of a traversal holds at most one node more than the tree height, which the rotations keep logarithmic
+    static constexpr size_t maxStackSize{256};
+
+    struct Node
+    {
+        Aabb box;
+        // Next free node for the freed ones
+        uint32_t parent{nullNode};
+        uint32_t child1{nullNode};
+        uint32_t child2{nullNode};
+        // -1 for the freed ones
+        int32_t height{};
+        uint32_t userData{};
+
+        bool isLeaf() const { return child1 == nullNode; }
+    };
+
+    uint32_t allocateNode();
+    void freeNode(const uint32_t node);
+    void insertLeaf(const uint32_t leaf);
+    void removeLeaf(const uint32_t leaf);
+    // Rotates the higher child up when the children heights differ by more than one, returns the new subtree root
+    uint32_t balance(const uint32_t node);
+    void fixUpwards(uint32_t node);
+    // Centers are doubled, which doesn't change their order
+    uint32_t buildSubtree(const std::span<uint32_t> leaves, const std::span<const math::Vec3> centers);
+
+    std::vector<Node> mNodes;
+    uint32_t mRoot{nullNode};
+    uint32_t mFreeList{nullNode};
+    size_t mProxiesNumber{};
+    // Internal nodes in the pre-order, cleared by the changes of the structure
+    std::vector<uint32_t> mRefitOrder;
+};
+
+template<typename TFunc>
+void AabbTree::queryFrustum(const Frustum& frustum, TFunc&& func) const
+{
+    if (mRoot == nullNode)
+    {
+        return;
+    }
+    TS_ASSERT(getHeight() < static_cast<int32_t>(maxStackSize));
+
+    constexpr uint8_t allPlanesMask{(1 << Frustum::planesNumber) - 1};
+
+    // Planes which the node box is fully inside of are dropped from the mask of its subtree,
+    // the subtree inside of all of them is reported without any further tests
+    std::array<std::pair<uint32_t, uint8_t>, maxStackSize> stack;
+    size_t stackSize{};
+    stack[stackSize++] = {mRoot, allPlanesMask};
+    while (stackSize > 0)
+    {
+        auto [nodeIndex, planesMask] = stack[--stackSize];
+        const auto& node = mNodes[nodeIndex];
+
+        const math::Vec3 center{
+            (node.box.min.x + node.box.max.x) / 2.f,
+            (node.box.min.y + node.box.max.y) / 2.f,
+            (node.box.min.z + node.box.max.z) / 2.f};
+        const math::Vec3 extent{
+            (node.box.max.x - node.box.min.x) / 2.f,
+            (node.box.max.y - node.box.min.y) / 2.f,
+            (node.box.max.z - node.box.min.z) / 2.f};
+
+        auto isOutside = false;
+        for (size_t planeIndex{}; planeIndex < Frustum::planesNumber; ++planeIndex)
+        {
+            if ((planesMask & (1 << planeIndex)) == 0)
+            {
+                continue;
+            }
+
+            const auto& plane = frustum.planes[planeIndex];
+            const auto distance = (plane.x * center.x) + (plane.y * center.y) + (plane.z * center.z) + plane.w;
+            const auto radius = (std::abs(plane.x) * extent.x) + (std::abs(plane.y) * extent.y) + (std::abs(plane.z) * extent.z);
+            if (distance + radius < 0.f)
+            {
+                isOutside = true;
+                break;
+            }
+
+            if (distance - radius >= 0.f)
+            {
+                planesMask &= ~(1 << planeIndex);
+            }
+        }
+
+        if (isOutside)
+        {
+            continue;
+        }
+
+        if (node.isLeaf())
+        {
+            func(nodeIndex);
+            continue;
+        }
+
+        stack[stackSize++] = {node.child1, planesMask};
+        stack[stackSize++] = {node.child2, planesMask};
+    }
+}
+
+template<typename TFunc>
+void AabbTree::querySphere(const math::Vec3& center, const float radius, TFunc&& func) const
+{
+    if (mRoot == nullNode)
+    {
+        return;
+    }
+    TS_ASSERT(getHeight() < static_cast<int32_t>(maxStackSize));
+
+    std::array<uint32_t, maxStackSize> stack;
+    size_t stackSize{};
+    stack[stackSize++] = mRoot;
+    while (stackSize > 0)
+    {
+        const auto nodeIndex = stack[--stackSize];
+        const auto& node = mNodes[nodeIndex];
+        if (!aabb::overlapsSphere(node.box, center, radius))
+        {
+            continue;
+        }
+
+        if (node.isLeaf())
+        {
+            func(nodeIndex);
+            continue;
+        }
+
+        stack[stackSize++] = node.child1;
+        stack[stackSize++] = node.child2;
+    }
+}
+
+template<typename TFunc>
+void AabbTree::raycast(const Ray& ray, float maxDistance, TFunc&& func) const
+{
+    if (mRoot == nullNode)
+    {
+        return;
+    }
+    TS_ASSERT(getHeight() < static_cast<int32_t>(maxStackSize));
+
+    const math::Vec3 invDirection{1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z};
+
+    // Nodes are popped with the distance at which the ray entered them, the ones behind the clipped end are skipped
+    std::array<std::pair<uint32_t, float>, maxStackSize> stack;
+    size_t stackSize{};
+    const auto rootDistance = aabb::intersectRay(mNodes[mRoot].box, ray.origin, invDirection, maxDistance);
+    if (rootDistance <= maxDistance)
+    {
+        stack[stackSize++] = {mRoot, rootDistance};
+    }
+
+    while (stackSize > 0)
+    {
+        const auto [nodeIndex, distance] = stack[--stackSize];
+        if (distance > maxDistance)
+        {
+            continue;
+        }
+
+        const auto& node = mNodes[nodeIndex];
+        if (node.isLeaf())
+        {
+            maxDistance = std::min(maxDistance, func(nodeIndex, distance));
+            continue;
+        }
+
+        // The closer child is pushed as the last one, so it's visited first
+        auto first = std::pair{node.child1, aabb::intersectRay(mNodes[node.child1].box, ray.origin, invDirection, maxDistance)};
+        auto second = std::pair{node.child2, aabb::intersectRay(mNodes[node.child2].box, ray.origin, invDirection, maxDistance)};
+        if (first.second < second.second)
+        {
+            std::swap(first, second);
+        }
+
+        for (const auto& child : {first, second})
+        {
+            if (child.second <= maxDistance)
+            {
+                stack[stackSize++] = child;
+            }
+        }
+    }
+}
+} // namespace ver
+} // namespace ts
@@ -1,7 +1,11 @@
 #include "tsengine/asset_store.h"
 
 #include "globals.hpp"
+#include "mesh_processing.h"
+#include "cooked_mesh.h"
+#include "mapped_file.h"
 #include "tsengine/logger.h"
+#include "tsengine/job_system.h"
 
 #include "tsengine/ecs/ecs.h"
 #include "tsengine/ecs/components/mesh_component.hpp"
@@ -15,18 +19,22 @@ inline namespace TS_VER
 {
 namespace
 {
-    std::vector<MeshComponent::Vertex> mVertices;
-    std::vector<uint32_t> mIndices;
-}
-
-// TODO: avoid the same files
-void AssetStore::Models::load()
-{
-    for (const auto entity : gReg.getSystem<AssetStore>().getSystemEntities())
+    struct Model
     {
-        auto& meshComponent = entity.getComponent<MeshComponent>();
-        const auto& fileName = meshComponent.assetName;
+        std::unique_ptr<MappedFile> cookedFile;
+        // Filled only when the model is imported from the source file
+        std::vector<GpuVertex> importedVertices;
+        std::vector<uint32_t> importedIndices;
 
+        cooked_mesh::MeshView mesh;
+    };
+
+    std::vector<Model> mModels;
+    size_t mVerticesCount{};
+    size_t mIndicesCount{};
+
+    Model importModel(const std::string& fileName)
+    {
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         if (!tinyobj::LoadObj(&attrib, &shapes, nullptr, nullptr, nullptr, fileName.data()))
@@ -34,8 +42,8 @@ void AssetStore::Models::load()
             TS_ERR(("Can not open the file: " + fileName).c_str());
         }
 
-        const auto oldIndexCount = mIndices.size();
-
+        std::vector<MeshComponent::Vertex> vertices;
+        std::vector<uint32_t> indices;
         for (const auto& shape : shapes)
         {
             for (const auto& index : shape.mesh.indices)
@@ -59,32 +67,172 @@ void AssetStore::Models::load()
 
                 vertex.color = vertex.normal;
 
-                mVertices.emplace_back(std::move(vertex));
-                mIndices.emplace_back(static_cast<uint32_t>(mIndices.size()));
+                vertices.emplace_back(std::move(vertex));
+                indices.emplace_back(static_cast<uint32_t>(indices.size()));
+            }
+        }
+
+        const auto importedVerticesCount = vertices.size();
+        weldVertices(vertices, indices);
+        TS_LOG(std::format("{} vertices welded from {} to {}", fileName, importedVerticesCount, vertices.size()).c_str());
+
+        const auto importedAcmr = analyzeVertexCache(indices, vertices.size()).acmr;
+        optimizeVertexCache(indices, vertices.size());
+        optimizeVertexFetch(vertices, indices);
+        TS_LOG(std::format("{} ACMR optimized from {:.3f} to {:.3f}",
+            fileName, importedAcmr, analyzeVertexCache(indices, vertices.size()).acmr).c_str());
+
+        // Levels share the vertices, their indices are stored after the base ones
+        Model model;
+        const auto lods = generateLods(vertices, indices, MeshComponent::maxLodsCount);
+        for (const auto& lod : lods)
+        {
+            model.mesh.lods[model.mesh.lodsCount++] = {
+                .firstIndex = static_cast<uint32_t>(indices.size()),
+                .indexCount = static_cast<uint32_t>(lod.indices.size()),
+                .error = lod.error};
+            indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+        }
+        TS_LOG(std::format("{} levels of detail generated with {} triangles at the last one",
+            fileName, lods.size(), lods.empty() ? 0 : lods.back().indices.size() / 3).c_str());
+
+        const auto bounds = computeBounds(vertices);
+        model.mesh.boundsMin = bounds.min;
+        model.mesh.boundsMax = bounds.max;
+#if PACKED_VERTICES
+        auto packedVertices = packVertices(vertices);
+        model.importedVertices = std::move(packedVertices.vertices);
+        model.mesh.positionScale = packedVertices.positionScale;
+        model.mesh.positionBias = packedVertices.positionBias;
+#else
+        model.importedVertices = std::move(vertices);
+#endif // PACKED_VERTICES
+        model.importedIndices = std::move(indices);
+        model.mesh.vertices = model.importedVertices;
+        model.mesh.indices = model.importedIndices;
+
+        return model;
+    }
+
+    Model loadModel(const std::string& fileName)
+    {
+        const auto cookedPath = fileName + cooked_mesh::fileExtension.data();
+        const auto sourceWriteTime = cooked_mesh::getSourceWriteTime(fileName);
+
+        if (std::filesystem::exists(cookedPath))
+        {
+            Model model{.cookedFile = std::make_unique<MappedFile>(cookedPath)};
+            if (const auto meshView = cooked_mesh::read(*model.cookedFile, sourceWriteTime))
+            {
+                model.mesh = *meshView;
+
+                return model;
             }
+
+            TS_LOG(("Cooked mesh is outdated: " + cookedPath).c_str());
+        }
+
+        auto model = importModel(fileName);
+        if (!cooked_mesh::write(cookedPath, sourceWriteTime, model.mesh))
+        {
+            TS_WARN(("Cooked mesh can not be written: " + cookedPath).c_str());
         }
 
-        meshComponent.firstIndex = oldIndexCount;
-        meshComponent.indexCount = mIndices.size() - oldIndexCount;
+        return model;
+    }
+}
+
+void AssetStore::Models::load()
+{
+    const auto& entities = gReg.getSystem<AssetStore>().getSystemEntities();
+
+    // Every file is loaded once, in the order of the first appearance, so the buffer layout is deterministic
+    std::vector<const std::string*> fileNames;
+    std::unordered_map<std::string_view, size_t> modelIndexPerFileName;
+    std::vector<size_t> modelIndexPerEntity;
+    modelIndexPerEntity.reserve(entities.size());
+    for (const auto entity : entities)
+    {
+        const auto& fileName = entity.getComponent<MeshComponent>().assetName;
+        const auto [it, isInserted] = modelIndexPerFileName.try_emplace(fileName, mModels.size() + fileNames.size());
+        if (isInserted)
+        {
+            fileNames.emplace_back(&fileName);
+        }
+
+        modelIndexPerEntity.emplace_back(it->second);
+    }
+
+    const auto firstNewModel = mModels.size();
+    mModels.resize(firstNewModel + fileNames.size());
+    getJobSystem().parallelFor(0, fileNames.size(), [&](const size_t i) {
+        mModels[firstNewModel + i] = loadModel(*fileNames[i]);
+    }, 1);
+
+    // Indices are local to every model, so the vertices of each are addressed with the vertex offset
+    struct MeshRange
+    {
+        size_t firstIndex;
+        size_t vertexOffset;
+    };
+
+    std::vector<MeshRange> meshRanges;
+    meshRanges.reserve(mModels.size());
+    size_t verticesCount{}, indicesCount{};
+    for (const auto& model : mModels)
+    {
+        meshRanges.push_back({indicesCount, verticesCount});
+        verticesCount += model.mesh.vertices.size();
+        indicesCount += model.mesh.indices.size();
+    }
+    mVerticesCount = verticesCount;
+    mIndicesCount = indicesCount;
+
+    for (size_t i{}; i < entities.size(); ++i)
+    {
+        auto& meshComponent = entities[i].getComponent<MeshComponent>();
+        const auto& meshRange = meshRanges[modelIndexPerEntity[i]];
+        const auto& mesh = mModels[modelIndexPerEntity[i]].mesh;
+        meshComponent.firstIndex = meshRange.firstIndex;
+        meshComponent.indexCount = cooked_mesh::getBaseIndicesCount(mesh);
+        meshComponent.vertexOffset = meshRange.vertexOffset;
+        meshComponent.positionScale = mesh.positionScale;
+        meshComponent.positionBias = mesh.positionBias;
+        meshComponent.boundsMin = mesh.boundsMin;
+        meshComponent.boundsMax = mesh.boundsMax;
+        meshComponent.lodsCount = mesh.lodsCount;
+        for (size_t level{}; level < mesh.lodsCount; ++level)
+        {
+            meshComponent.lods[level] = {
+                .firstIndex = meshRange.firstIndex + mesh.lods[level].firstIndex,
+                .indexCount = mesh.lods[level].indexCount,
+                .error = mesh.lods[level].error};
+        }
     }
 }
 
 void AssetStore::Models::writeTo(char* const destination)
 {
-    const size_t verticesSize = sizeof(mVertices.at(0)) * mVertices.size();
-    const size_t indicesSize = sizeof(mIndices.at(0)) * mIndices.size();
-    memcpy(destination, mVertices.data(), verticesSize);
-    memcpy(destination + verticesSize, mIndices.data(), indicesSize);
+    auto verticesDestination = destination;
+    auto indicesDestination = destination + getIndexOffset();
+    for (const auto& model : mModels)
+    {
+        memcpy(verticesDestination, model.mesh.vertices.data(), model.mesh.vertices.size_bytes());
+        verticesDestination += model.mesh.vertices.size_bytes();
+
+        memcpy(indicesDestination, model.mesh.indices.data(), model.mesh.indices.size_bytes());
+        indicesDestination += model.mesh.indices.size_bytes();
+    }
 }
 
 size_t AssetStore::Models::getIndexOffset()
 {
-    return sizeof(mVertices.at(0)) * mVertices.size();
+    return sizeof(GpuVertex) * mVerticesCount;
 }
 
 size_t AssetStore::Models::getSize()
 {
-    return sizeof(mVertices.at(0)) * mVertices.size() + sizeof(mIndices.at(0)) * mIndices.size();
+    return sizeof(GpuVertex) * mVerticesCount + sizeof(uint32_t) * mIndicesCount;
 }
 } // namespace ver
 } // namespace ts
\ No newline at end of file
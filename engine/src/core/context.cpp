@@ -476,6 +476,8 @@ void Context::isVulkanDeviceExtensionsAvailable(
     VkPhysicalDeviceProperties physicalDeviceProperties;
     vkGetPhysicalDeviceProperties(mPhysicalDevice, &physicalDeviceProperties);
     mVkUniformBufferOffsetAlignment = physicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
+    mVkStorageBufferOffsetAlignment = physicalDeviceProperties.limits.minStorageBufferOffsetAlignment;
+    mVkNonCoherentAtomSize = physicalDeviceProperties.limits.nonCoherentAtomSize;
 
     const VkSampleCountFlags sampleCountFlags{
         physicalDeviceProperties.limits.framebufferColorSampleCounts & physicalDeviceProperties.limits.framebufferDepthSampleCounts};
@@ -496,6 +498,10 @@ void Context::isVulkanDeviceExtensionsAvailable(
 
     vkGetPhysicalDeviceFeatures(mPhysicalDevice, &physicalDeviceFeatures);
 
+    // Both are enabled with the rest of the supported features, the renderer falls back to the direct draws without them
+    mIsMultiDrawIndirectSupported = physicalDeviceFeatures.multiDrawIndirect;
+    mIsDrawIndirectFirstInstanceSupported = physicalDeviceFeatures.drawIndirectFirstInstance;
+
     vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &physicalDeviceFeatures2);
     if (!physicalDeviceMultiviewFeatures.multiview)
     {
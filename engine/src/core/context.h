@@ -37,6 +37,10 @@ public:
     [[nodiscard]] VkQueue getVkGraphicsQueue() const { return mVkGraphicsQueue; }
     [[nodiscard]] VkQueue getVkPresentQueue() const { return mVkPresentQueue; }
     [[nodiscard]] VkDeviceSize getUniformBufferOffsetAlignment() const { return mVkUniformBufferOffsetAlignment; }
+    [[nodiscard]] VkDeviceSize getStorageBufferOffsetAlignment() const { return mVkStorageBufferOffsetAlignment; }
+    [[nodiscard]] VkDeviceSize getNonCoherentAtomSize() const { return mVkNonCoherentAtomSize; }
+    [[nodiscard]] bool isMultiDrawIndirectSupported() const { return mIsMultiDrawIndirectSupported; }
+    [[nodiscard]] bool isDrawIndirectFirstInstanceSupported() const { return mIsDrawIndirectFirstInstanceSupported; }
 
 private:
     void createXrInstance();
@@ -87,7 +91,10 @@ private:
     VkQueue mVkGraphicsQueue{}, mVkPresentQueue{};
     VkSampleCountFlagBits mVkMultisampleCount{};
     VkDeviceSize mVkUniformBufferOffsetAlignment{};
+    VkDeviceSize mVkStorageBufferOffsetAlignment{};
+    VkDeviceSize mVkNonCoherentAtomSize{};
     bool mIsXrContextCreated{};
+    bool mIsMultiDrawIndirectSupported{}, mIsDrawIndirectFirstInstanceSupported{};
 };
 } // namespace ver
 } // namespace ts
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "controllers.h"
 #include "khronos_utils.h"
 
+#include <span>
+
 namespace
 {
 XrPath stringToXrPath(XrInstance instance, std::string_view str)
@@ -23,6 +25,11 @@ Controllers::~Controllers()
         xrDestroySpace(space);
     }
 
+    if (mTriggerAction != nullptr)
+    {
+        xrDestroyAction(mTriggerAction);
+    }
+
     if (mFlyAction != nullptr)
     {
         xrDestroyAction(mFlyAction);
@@ -53,7 +60,7 @@ void Controllers::setupControllers()
 
     createAction("handpose", "Hand Pose", XR_ACTION_TYPE_POSE_INPUT, mPoseAction);
     createAction("fly", "Fly", XR_ACTION_TYPE_FLOAT_INPUT, mFlyAction);
-    createAction("trigget_action", "Trigger Action", XR_ACTION_TYPE_BOOLEAN_INPUT, mTriggerAction);
+    createAction("trigger_action", "Trigger Action", XR_ACTION_TYPE_BOOLEAN_INPUT, mTriggerAction);
 
     for (size_t controllerIndex{}; controllerIndex < controllerCount; ++controllerIndex)
     {
@@ -67,21 +74,34 @@ void Controllers::setupControllers()
         TS_XR_CHECK(xrCreateActionSpace, mSession, &actionSpaceCreateInfo, &mSpaces.at(controllerIndex));
     }
 
-    const std::array bindings{
+    const auto suggestBindings = [this](const std::string_view profile, const std::span<const XrActionSuggestedBinding> bindings) {
+        XrInteractionProfileSuggestedBinding interactionProfileSuggestedBinding{
+            .type = XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING,
+            .interactionProfile = stringToXrPath(mInstance, profile),
+            .countSuggestedBindings = static_cast<uint32_t>(bindings.size()),
+            .suggestedBindings = bindings.data(),
+        };
+
+        TS_XR_CHECK(xrSuggestInteractionProfileBindings, mInstance, &interactionProfileSuggestedBinding);
+    };
+
+    const std::array simpleBindings{
         XrActionSuggestedBinding{mPoseAction, stringToXrPath(mInstance, "/user/hand/left/input/aim/pose")     },
         XrActionSuggestedBinding{mPoseAction, stringToXrPath(mInstance, "/user/hand/right/input/aim/pose")    },
         XrActionSuggestedBinding{mFlyAction , stringToXrPath(mInstance, "/user/hand/left/input/select/click") },
         XrActionSuggestedBinding{mFlyAction , stringToXrPath(mInstance, "/user/hand/right/input/select/click")},
     };
-
-    XrInteractionProfileSuggestedBinding interactionProfileSuggestedBinding{
-        .type = XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING,
-        .interactionProfile = stringToXrPath(mInstance, interactionProfile),
-        .countSuggestedBindings = static_cast<uint32_t>(bindings.size()),
-        .suggestedBindings = bindings.data(),
+    suggestBindings(simpleInteractionProfile, simpleBindings);
+
+    const std::array touchBindings{
+        XrActionSuggestedBinding{mPoseAction   , stringToXrPath(mInstance, "/user/hand/left/input/aim/pose")      },
+        XrActionSuggestedBinding{mPoseAction   , stringToXrPath(mInstance, "/user/hand/right/input/aim/pose")     },
+        XrActionSuggestedBinding{mFlyAction    , stringToXrPath(mInstance, "/user/hand/left/input/squeeze/value") },
+        XrActionSuggestedBinding{mFlyAction    , stringToXrPath(mInstance, "/user/hand/right/input/squeeze/value")},
+        XrActionSuggestedBinding{mTriggerAction, stringToXrPath(mInstance, "/user/hand/left/input/trigger/value") },
+        XrActionSuggestedBinding{mTriggerAction, stringToXrPath(mInstance, "/user/hand/right/input/trigger/value")},
     };
-
-    TS_XR_CHECK(xrSuggestInteractionProfileBindings, mInstance, &interactionProfileSuggestedBinding);
+    suggestBindings(touchInteractionProfile, touchBindings);
 
     XrSessionActionSetsAttachInfo sessionActionSetsAttachInfo{
         .type = XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO,
@@ -139,6 +159,30 @@ void Controllers::sync(const XrSpace space, const XrTime time)
         {
             mFlyStates.at(controllerIndex) = flyState.currentState;
         }
+
+        XrActionStateBoolean triggerState{XR_TYPE_ACTION_STATE_BOOLEAN};
+        updateActionStateBoolean(mSession, mTriggerAction, path, triggerState);
+
+        mTriggerStates.at(controllerIndex) = triggerState.isActive && triggerState.currentState;
+    }
+}
+
+Ray Controllers::getAimRay(const size_t controllerIndex, const math::Vec3& cameraPos) const
+{
+    // Aim pose looks along its negative z axis
+    const auto& pose = mPoses.at(controllerIndex);
+    return {
+        .origin = math::Vec3{pose[3]} + (cameraPos * -1.f),
+        .direction = math::normalize(math::Vec3{pose[2]} * -1.f)};
+}
+
+void Controllers::updatePointedEntities(const SpatialIndexSystem& spatialIndex, const math::Vec3& cameraPos)
+{
+    for (size_t controllerIndex{}; controllerIndex < controllerCount; ++controllerIndex)
+    {
+        const auto ray = getAimRay(controllerIndex, cameraPos);
+        auto& pointedEntity = mPointedEntities.at(controllerIndex);
+        pointedEntity = (ray.direction.isNan()) ? std::nullopt : spatialIndex.raycast(ray, maxPointingDistance);
     }
 }
 
@@ -164,6 +208,17 @@ void Controllers::updateActionStateFloat(const XrSession session, const XrAction
     TS_XR_CHECK(xrGetActionStateFloat, session, &actionStateGetInfo, &state);
 }
 
+void Controllers::updateActionStateBoolean(const XrSession session, const XrAction action, const XrPath path, XrActionStateBoolean& state)
+{
+    XrActionStateGetInfo actionStateGetInfo{
+        .type = XR_TYPE_ACTION_STATE_GET_INFO,
+        .action = action,
+        .subactionPath = path
+    };
+
+    TS_XR_CHECK(xrGetActionStateBoolean, session, &actionStateGetInfo, &state);
+}
+
 void Controllers::createAction(const std::string& actionName, const std::string& localizedActionName, const XrActionType type, XrAction& action)
 {
     const XrActionCreateInfo actionCreateInfo{
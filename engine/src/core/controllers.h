@@ -2,6 +2,7 @@
 
 #include "internal_utils.h"
 #include "tsengine/math.hpp"
+#include "ecs/systems/spatial_index_system.hpp"
 
 #include "openxr/openxr.h"
 
@@ -15,7 +16,9 @@ class Controllers final
 
     static constexpr std::string_view actionSetName{"actionset"};
     static constexpr std::string_view localizedActionSetName{"Actions"};
-    static constexpr std::string_view interactionProfile{"/interaction_profiles/khr/simple_controller"};
+    static constexpr std::string_view simpleInteractionProfile{"/interaction_profiles/khr/simple_controller"};
+    // The simple controller has no trigger, the trigger action is bound only for the controllers having it
+    static constexpr std::string_view touchInteractionProfile{"/interaction_profiles/oculus/touch_controller"};
 
 public:
     Controllers(XrInstance xrInstance, XrSession xrSession) : mInstance(xrInstance), mSession(xrSession)
@@ -23,12 +26,24 @@ public:
     ~Controllers();
 
     static constexpr size_t controllerCount{2};
+    // Entities further away from the controller can't be pointed at
+    static constexpr float maxPointingDistance{100.f};
 
     void setupControllers();
     void sync(const XrSpace space, const XrTime time);
 
     [[nodiscard]] bool getFlyState(const size_t controllerIndex) const { return mFlyStates.at(controllerIndex); }
     [[nodiscard]] math::Mat4 getPose(const size_t controllerIndex) const { return mPoses.at(controllerIndex); }
+    [[nodiscard]] bool getTriggerState(const size_t controllerIndex) const { return mTriggerStates.at(controllerIndex); }
+    // Ray from the controller along its aim in the world space, the world is moved by the camera position
+    [[nodiscard]] Ray getAimRay(const size_t controllerIndex, const math::Vec3& cameraPos) const;
+
+    // Looks up the closest entity on the aim ray of every controller
+    void updatePointedEntities(const SpatialIndexSystem& spatialIndex, const math::Vec3& cameraPos);
+    [[nodiscard]] const std::optional<RayHit>& getPointedEntity(const size_t controllerIndex) const
+    {
+        return mPointedEntities.at(controllerIndex);
+    }
 
 private:
     XrInstance mInstance{};
@@ -39,6 +54,8 @@ private:
     std::array<XrPath, controllerCount> mPaths;
     std::array<math::Mat4, controllerCount> mPoses{};
     std::array<float, controllerCount> mFlyStates{};
+    std::array<bool, controllerCount> mTriggerStates{};
+    std::array<std::optional<RayHit>, controllerCount> mPointedEntities{};
 
     void createAction(
         const std::string& actionName,
@@ -48,6 +65,7 @@ private:
 
     void updateActionStatePose(const XrSession session, const XrAction action, const XrPath path, XrActionStatePose& state);
     void updateActionStateFloat(const XrSession session, const XrAction action, const XrPath path, XrActionStateFloat& state);
+    void updateActionStateBoolean(const XrSession session, const XrAction action, const XrPath path, XrActionStateBoolean& state);
 };
 } // namespace ver
 } // namespace ts
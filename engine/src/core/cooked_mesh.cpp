@@ -0,0 +1,166 @@
+#include "cooked_mesh.h"
+#include "mapped_file.h"
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace cooked_mesh
+{
+namespace
+{
+constexpr uint64_t alignBlob(const uint64_t offset)
+{
+    return (offset + blobAlignment - 1) & ~(blobAlignment - 1);
+}
+
+// Counts come from the file, so they're compared before any multiplication which could wrap
+bool isBlobInside(const uint64_t offset, const uint64_t count, const size_t elementSize, const size_t fileSize)
+{
+    return (offset <= fileSize) && (count <= (fileSize - offset) / elementSize);
+}
+} // namespace
+
+VertexLayout getVertexLayout()
+{
+#if PACKED_VERTICES
+    return {
+        .stride = sizeof(GpuVertex),
+        .attributesCount = 2,
+        .attributes = {{
+            {.offset = offsetof(GpuVertex, position), .componentType = ComponentType::SNORM16, .componentsCount = 4},
+            {.offset = offsetof(GpuVertex, normal), .componentType = ComponentType::SNORM16, .componentsCount = 2},
+        }},
+    };
+#else
+    return {
+        .stride = sizeof(GpuVertex),
+        .attributesCount = 3,
+        .attributes = {{
+            {.offset = offsetof(GpuVertex, position), .componentType = ComponentType::FLOAT32, .componentsCount = 3},
+            {.offset = offsetof(GpuVertex, normal), .componentType = ComponentType::FLOAT32, .componentsCount = 3},
+            {.offset = offsetof(GpuVertex, color), .componentType = ComponentType::FLOAT32, .componentsCount = 3},
+        }},
+    };
+#endif // PACKED_VERTICES
+}
+
+int64_t getSourceWriteTime(const std::filesystem::path& sourcePath)
+{
+    std::error_code errorCode;
+    const auto writeTime = std::filesystem::last_write_time(sourcePath, errorCode);
+
+    return errorCode ? 0 : static_cast<int64_t>(writeTime.time_since_epoch().count());
+}
+
+bool write(const std::filesystem::path& path, const int64_t sourceWriteTime, const MeshView& mesh)
+{
+    const auto& [vertices, indices, positionScale, positionBias, boundsMin, boundsMax, lods, lodsCount] = mesh;
+
+    // Value initialization zeroes the padding too, so the same mesh always gives the same bytes
+    auto header = Header();
+    header.magic = magic;
+    header.version = version;
+    header.vertexLayout = getVertexLayout();
+    header.sourceWriteTime = sourceWriteTime;
+    header.positionScale = {positionScale.x, positionScale.y, positionScale.z};
+    header.positionBias = {positionBias.x, positionBias.y, positionBias.z};
+    header.boundsMin = {boundsMin.x, boundsMin.y, boundsMin.z};
+    header.boundsMax = {boundsMax.x, boundsMax.y, boundsMax.z};
+    header.verticesCount = vertices.size();
+    header.verticesOffset = alignBlob(sizeof(Header));
+    header.indicesCount = indices.size();
+    header.indicesOffset = alignBlob(alignBlob(sizeof(Header)) + vertices.size_bytes());
+    header.lodsCount = lodsCount;
+    header.lods = lods;
+
+    std::vector<char> fileData(header.indicesOffset + indices.size_bytes());
+    memcpy(fileData.data(), &header, sizeof(header));
+    memcpy(fileData.data() + header.verticesOffset, vertices.data(), vertices.size_bytes());
+    memcpy(fileData.data() + header.indicesOffset, indices.data(), indices.size_bytes());
+
+    // The file is renamed at the end, so a partially written one is never read
+    auto temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file{temporaryPath, std::ios::binary};
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        file.write(fileData.data(), fileData.size());
+        if (!file.good())
+        {
+            return false;
+        }
+    }
+
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryPath, path, errorCode);
+
+    return !errorCode;
+}
+
+std::optional<MeshView> read(const MappedFile& file, const int64_t sourceWriteTime)
+{
+    if (file.getSize() < sizeof(Header))
+    {
+        return std::nullopt;
+    }
+
+    Header header;
+    memcpy(&header, file.getData(), sizeof(header));
+    if ((header.magic != magic) ||
+        (header.version != version) ||
+        (header.vertexLayout != getVertexLayout()) ||
+        (header.sourceWriteTime != sourceWriteTime))
+    {
+        return std::nullopt;
+    }
+
+    const auto isLodOutside = [&header](const LodRange& lod) {
+        return static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > header.indicesCount;
+    };
+    if ((header.lodsCount > header.lods.size()) ||
+        std::ranges::any_of(std::span{header.lods}.first(header.lodsCount), isLodOutside))
+    {
+        return std::nullopt;
+    }
+
+    if ((header.verticesOffset % blobAlignment != 0) ||
+        (header.indicesOffset % blobAlignment != 0) ||
+        !isBlobInside(header.verticesOffset, header.verticesCount, sizeof(GpuVertex), file.getSize()) ||
+        !isBlobInside(header.indicesOffset, header.indicesCount, sizeof(uint32_t), file.getSize()))
+    {
+        return std::nullopt;
+    }
+
+    // Indices go to the GPU as they are, so they're checked once on the load
+    const std::span indices{reinterpret_cast<const uint32_t*>(file.getData() + header.indicesOffset), static_cast<size_t>(header.indicesCount)};
+    if (std::ranges::any_of(indices, [&header](const uint32_t index) { return index >= header.verticesCount; }))
+    {
+        return std::nullopt;
+    }
+
+    return MeshView{
+        .vertices = {
+            reinterpret_cast<const GpuVertex*>(file.getData() + header.verticesOffset),
+            static_cast<size_t>(header.verticesCount)},
+        .indices = indices,
+        .positionScale = {header.positionScale[0], header.positionScale[1], header.positionScale[2]},
+        .positionBias = {header.positionBias[0], header.positionBias[1], header.positionBias[2]},
+        .boundsMin = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]},
+        .boundsMax = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]},
+        .lods = header.lods,
+        .lodsCount = header.lodsCount,
+    };
+}
+
+size_t getBaseIndicesCount(const MeshView& mesh)
+{
+    return (mesh.lodsCount > 0) ? mesh.lods[0].firstIndex : mesh.indices.size();
+}
+} // namespace cooked_mesh
+} // namespace ver
+} // namespace ts
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "mesh_processing.h"
+
+#include <span>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+class MappedFile;
+
+// Binary mesh written next to the source model after the first import:
+// header, then the vertex blob and the index blob, each aligned to blobAlignment
+namespace cooked_mesh
+{
+inline constexpr std::string_view fileExtension{".tsmesh"};
+inline constexpr std::array magic{'T', 'S', 'M', 'S'};
+inline constexpr uint32_t version{4};
+inline constexpr size_t blobAlignment{64};
+
+enum class ComponentType : uint32_t
+{
+    FLOAT32,
+    SNORM16
+};
+
+struct VertexAttribute
+{
+    uint32_t offset;
+    ComponentType componentType;
+    uint32_t componentsCount;
+
+    bool operator==(const VertexAttribute&) const = default;
+};
+
+struct VertexLayout
+{
+    static constexpr size_t maxAttributesCount{4};
+
+    uint32_t stride;
+    uint32_t attributesCount;
+    std::array<VertexAttribute, maxAttributesCount> attributes;
+
+    bool operator==(const VertexLayout&) const = default;
+};
+
+// Range of a simplified level in the indices
+struct LodRange
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+
+    bool operator==(const LodRange&) const = default;
+};
+
+struct Header
+{
+    std::array<char, 4> magic;
+    uint32_t version;
+    VertexLayout vertexLayout;
+    // Cooked file is outdated when the source model is modified
+    int64_t sourceWriteTime;
+    std::array<float, 3> positionScale;
+    std::array<float, 3> positionBias;
+    std::array<float, 3> boundsMin;
+    std::array<float, 3> boundsMax;
+    uint64_t verticesCount;
+    uint64_t verticesOffset;
+    uint64_t indicesCount;
+    uint64_t indicesOffset;
+    uint32_t lodsCount;
+    std::array<LodRange, MeshComponent::maxLodsCount> lods;
+};
+
+struct MeshView
+{
+    std::span<const GpuVertex> vertices;
+    // Base indices followed by the ones of the simplified levels
+    std::span<const uint32_t> indices;
+    math::Vec3 positionScale{1.f};
+    math::Vec3 positionBias{};
+    // Bounding box of the positions before the quantization
+    math::Vec3 boundsMin{};
+    math::Vec3 boundsMax{};
+    std::array<LodRange, MeshComponent::maxLodsCount> lods{};
+    uint32_t lodsCount{};
+};
+
+// Base range is in front of the first simplified level
+size_t getBaseIndicesCount(const MeshView& mesh);
+
+// Layout of GpuVertex, the attributes are in the order of the shader locations
+VertexLayout getVertexLayout();
+int64_t getSourceWriteTime(const std::filesystem::path& sourcePath);
+
+// Returns false when the file couldn't be written, the mesh is fine to be used without it
+bool write(const std::filesystem::path& path, const int64_t sourceWriteTime, const MeshView& mesh);
+
+// Views into the mapped file, nothing is returned when it's outdated or written by a different version
+std::optional<MeshView> read(const MappedFile& file, const int64_t sourceWriteTime);
+} // namespace cooked_mesh
+} // namespace ver
+} // namespace ts
@@ -6,6 +6,7 @@
 #include "context.h"
 #include "window.h"
 #include "tsengine/logger.h"
+#include "tsengine/event_bus.hpp"
 #include "mirror_view.h"
 #include "headset.h"
 #include "controllers.h"
@@ -16,6 +17,8 @@
 #include "tsengine/ecs/ecs.h" 
 #include "ecs/systems/movement_system.hpp" 
 #include "ecs/systems/render_system.hpp"
+#include "ecs/systems/transform_system.hpp"
+#include "ecs/systems/spatial_index_system.hpp"
 
 namespace ts
 {
@@ -38,6 +41,7 @@ namespace
     __forceinline void runCleaner()
     {
         isAlreadyInitiated = false;
+        logger::flush();
     }
 } // namespace
 
@@ -99,7 +103,9 @@ int run(Engine* const game) try
 
     gReg.addSystem<AssetStore>();
     gReg.addSystem<MovementSystem>();
-    gReg.addSystem<RenderSystem>(ctx.getUniformBufferOffsetAlignment());
+    gReg.addSystem<TransformSystem>();
+    gReg.addSystem<SpatialIndexSystem>();
+    gReg.addSystem<RenderSystem>();
 
     gReg.update();
 
@@ -174,7 +180,22 @@ int run(Engine* const game) try
 #endif
 
             controllers.sync(headset.getXrSpace(), headset.getXrFrameState().predictedDisplayTime);
-            gReg.getSystem<MovementSystem>().update(dt, controllers);
+            gReg.schedule<MovementSystem>([&](MovementSystem& system) { system.update(dt, controllers); });
+        }
+
+        // Scheduled after the systems moving the entities, so the world matrices and the spatial index following them
+        // include all the changes of the frame
+        gReg.schedule<TransformSystem>([](TransformSystem& system) { system.update(); });
+        gReg.schedule<SpatialIndexSystem>([](SpatialIndexSystem& system) { system.update(); });
+        gReg.runScheduledSystems();
+        getJobSystem().rethrowDetachedException();
+        // Events queued by the systems are handled on the main thread before the rendering
+        getEventBus().dispatchQueuedEvents();
+
+        if (frameResult == Headset::BeginFrameResult::RENDER_FULLY)
+        {
+            const auto cameraPos = gReg.getEntityByTag("player").getComponent<TransformComponent>().getWorldPosition();
+            controllers.updatePointedEntities(gReg.getSystem<SpatialIndexSystem>(), cameraPos);
 
             renderer.render(swapchainImageIndex);
             const auto mirrorResult = mirrorView.render(swapchainImageIndex);
@@ -198,6 +219,7 @@ int run(Engine* const game) try
     game->close();
     ctx.sync();
     isAlreadyInitiated = false;
+    logger::flush();
 
     return EXIT_SUCCESS;
 }
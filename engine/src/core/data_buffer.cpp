@@ -52,6 +52,10 @@ void DataBuffer::createDataBuffer(const VkBufferUsageFlags bufferUsageFlags, con
         TS_ERR("Can not find the suitable memory index");
     }
 
+    VkPhysicalDeviceMemoryProperties supportedMemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(mCtx.getVkPhysicalDevice(), &supportedMemoryProperties);
+    mMemoryProperties = supportedMemoryProperties.memoryTypes[suitableMemoryTypeIndex].propertyFlags;
+
     VkMemoryAllocateInfo memoryAllocateInfo{
         .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
         .allocationSize = memoryRequirements.size,
@@ -99,5 +103,26 @@ void DataBuffer::unmap() const
 {
     vkUnmapMemory(mCtx.getVkDevice(), mDeviceMemory);
 }
+
+void DataBuffer::flush(std::vector<VkMappedMemoryRange>& ranges) const
+{
+    if (ranges.empty())
+    {
+        return;
+    }
+
+    const auto atomSize = mCtx.getNonCoherentAtomSize();
+    for (auto& range : ranges)
+    {
+        const auto end = std::min(khronos_utils::align(range.offset + range.size, atomSize), mSize);
+
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = mDeviceMemory;
+        range.offset -= range.offset % atomSize;
+        range.size = (end == mSize) ? VK_WHOLE_SIZE : (end - range.offset);
+    }
+
+    TS_VK_CHECK(vkFlushMappedMemoryRanges, mCtx.getVkDevice(), static_cast<uint32_t>(ranges.size()), ranges.data());
+}
 } // namespace ver
 } // namespace ts
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "vulkan/vulkan.h"
 
+#include <vector>
+
 namespace ts
 {
 inline namespace TS_VER
@@ -26,11 +28,17 @@ public:
     void* map() const;
     void unmap() const;
 
+    // Makes the host writes to the mapped ranges visible to the device, it's required only without the coherent memory.
+    // Ranges are aligned to the nonCoherentAtomSize and their memory is set here.
+    void flush(std::vector<VkMappedMemoryRange>& ranges) const;
+    [[nodiscard]] bool isHostCoherent() const { return (mMemoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0; }
+
 private:
     const Context& mCtx;
     VkBuffer mBuffer{};
     VkDeviceMemory mDeviceMemory{};
     VkDeviceSize mSize{};
+    VkMemoryPropertyFlags mMemoryProperties{};
 };
 } // namespace ver
 } // namespace ts
\ No newline at end of file
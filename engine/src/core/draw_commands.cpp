@@ -0,0 +1,299 @@
+#include "draw_commands.h"
+
+#include "tsengine/ecs/components/transform_component.hpp"
+#include "tsengine/logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace
+{
+constexpr uint32_t maxMaterialId{(1u << draw_key::materialBits) - 1};
+constexpr uint32_t maxMeshId{(1u << draw_key::meshBits) - 1};
+} // namespace
+
+namespace lod
+{
+uint32_t select(const MeshComponent& mesh, const math::Mat4& worldMat, const LodSelection& selection)
+{
+    if ((mesh.lodsCount == 0) || selection.eyePositions.empty())
+    {
+        return 0;
+    }
+
+    // Bounding sphere of the mesh in the world space, the errors grow with the largest scale of the axes
+    const math::Vec3 localExtent{
+        (mesh.boundsMax.x - mesh.boundsMin.x) / 2.f,
+        (mesh.boundsMax.y - mesh.boundsMin.y) / 2.f,
+        (mesh.boundsMax.z - mesh.boundsMin.z) / 2.f};
+    const auto center = worldMat * math::Vec4{
+        (mesh.boundsMin.x + mesh.boundsMax.x) / 2.f,
+        (mesh.boundsMin.y + mesh.boundsMax.y) / 2.f,
+        (mesh.boundsMin.z + mesh.boundsMax.z) / 2.f,
+        1.f};
+
+    float scale{};
+    for (size_t column{}; column < 3; ++column)
+    {
+        const auto& basis = worldMat.data[column];
+        scale = std::max(scale, std::sqrt((basis.x * basis.x) + (basis.y * basis.y) + (basis.z * basis.z)));
+    }
+    const auto radius = scale *
+        std::sqrt((localExtent.x * localExtent.x) + (localExtent.y * localExtent.y) + (localExtent.z * localExtent.z));
+
+    auto distance = std::numeric_limits<float>::max();
+    for (const auto& eyePosition : selection.eyePositions)
+    {
+        const math::Vec3 toCenter{center.x - eyePosition.x, center.y - eyePosition.y, center.z - eyePosition.z};
+        const auto centerDistance = std::sqrt((toCenter.x * toCenter.x) + (toCenter.y * toCenter.y) + (toCenter.z * toCenter.z));
+        distance = std::min(distance, centerDistance - radius);
+    }
+
+    if (distance <= 0.f)
+    {
+        return 0;
+    }
+
+    // Error of the level covers error * scale / distance of the unit size on the screen
+    const auto pixelsPerError = (scale * selection.pixelsPerUnit) / distance;
+    uint32_t level{};
+    while ((level < mesh.lodsCount) && (mesh.lods[level].error * pixelsPerError <= selection.maxPixelError))
+    {
+        ++level;
+    }
+
+    return level;
+}
+} // namespace lod
+
+void DrawCommandBuilder::build(
+    const std::vector<Entity>& entities,
+    const math::Vec3& eyePos,
+    const std::span<const uint8_t> visibility,
+    const std::optional<LodSelection>& lodSelection)
+{
+    mDrawList.clear();
+    mMaterialIds.clear();
+    mMeshIds.clear();
+    mLodLevels.resize(entities.size());
+    for (uint32_t i{}; i < entities.size(); ++i)
+    {
+        if (!visibility.empty() && (visibility[i] == 0))
+        {
+            continue;
+        }
+
+        const auto entity = entities[i];
+        mLodLevels[i] = (lodSelection.has_value() && entity.hasComponent<MeshComponent>()) ?
+            static_cast<uint8_t>(lod::select(
+                entity.getComponent<MeshComponent>(),
+                entity.getComponent<TransformComponent>().getWorldMat(),
+                *lodSelection)) :
+            0;
+
+        mDrawList.add(makeDrawKey(entity, eyePos, mLodLevels[i]), i);
+    }
+    mDrawList.sort();
+    mDrawList.buildBatches();
+
+    const auto& items = mDrawList.getItems();
+    mInstanceObjects.resize(items.size());
+    for (size_t i{}; i < items.size(); ++i)
+    {
+        const auto entity = entities[items[i].index];
+        mInstanceObjects[i] = entity.hasComponent<MeshComponent>() ? getObjectIndex(entity) : 0;
+    }
+
+    mIndirectCommands.clear();
+    mIndirectGroups.clear();
+    mTrianglesNumber = 0;
+    const auto& batches = mDrawList.getBatches();
+    for (uint32_t batchIndex{}; batchIndex < batches.size(); ++batchIndex)
+    {
+        const auto& batch = batches[batchIndex];
+        const auto key = items[batch.firstItem].key;
+        if (draw_key::getMesh(key) == 0)
+        {
+            continue;
+        }
+
+        const auto pipeline = draw_key::getPipeline(key);
+        const auto isGroupContinued = !mIndirectGroups.empty() &&
+            (mIndirectGroups.back().pipeline == pipeline) &&
+            ((mIndirectGroups.back().firstBatch + mIndirectGroups.back().commandsNumber) == batchIndex);
+        if (!isGroupContinued)
+        {
+            mIndirectGroups.push_back({
+                .pipeline = pipeline,
+                .firstBatch = batchIndex,
+                .firstCommand = static_cast<uint32_t>(mIndirectCommands.size()),
+                .commandsNumber = 0});
+        }
+        ++mIndirectGroups.back().commandsNumber;
+
+        // Instances of the batch share the level, it's a part of the mesh in the key
+        const auto entityIndex = items[batch.firstItem].index;
+        const auto& mesh = entities[entityIndex].getComponent<MeshComponent>();
+        const auto lod = mesh.getLod(mLodLevels[entityIndex]);
+        mIndirectCommands.push_back({
+            .indexCount = static_cast<uint32_t>(lod.indexCount),
+            .instanceCount = batch.itemsNumber,
+            .firstIndex = static_cast<uint32_t>(lod.firstIndex),
+            .vertexOffset = static_cast<int32_t>(mesh.vertexOffset),
+            .firstInstance = batch.firstItem});
+        mTrianglesNumber += (lod.indexCount / 3) * batch.itemsNumber;
+    }
+}
+
+void DrawCommandBuilder::splitRecording(const size_t maxRanges, const size_t minBatchesPerRange)
+{
+    mRecordingRanges.clear();
+    mRecordingGroups.clear();
+
+    const auto batchesNumber = mDrawList.getBatches().size();
+    if (batchesNumber == 0)
+    {
+        return;
+    }
+
+    const auto rangesNumber = std::clamp<size_t>(
+        batchesNumber / std::max<size_t>(minBatchesPerRange, 1), 1, std::max<size_t>(maxRanges, 1));
+
+    size_t groupIndex{};
+    for (size_t rangeIndex{}; rangeIndex < rangesNumber; ++rangeIndex)
+    {
+        const auto first = static_cast<uint32_t>((batchesNumber * rangeIndex) / rangesNumber);
+        const auto end = static_cast<uint32_t>((batchesNumber * (rangeIndex + 1)) / rangesNumber);
+        auto& range = mRecordingRanges.emplace_back(DrawRecordingRange{
+            .firstBatch = first,
+            .batchesNumber = end - first,
+            .firstIndirectGroup = static_cast<uint32_t>(mRecordingGroups.size()),
+            .indirectGroupsNumber = 0});
+
+        // A group crossing the end of the range is continued by the next one
+        for (; groupIndex < mIndirectGroups.size(); ++groupIndex)
+        {
+            const auto& group = mIndirectGroups[groupIndex];
+            if (group.firstBatch >= end)
+            {
+                break;
+            }
+
+            const auto groupEnd = group.firstBatch + group.commandsNumber;
+            const auto cutFirst = std::max(group.firstBatch, first);
+            const auto cutEnd = std::min(groupEnd, end);
+            mRecordingGroups.push_back({
+                .pipeline = group.pipeline,
+                .firstBatch = cutFirst,
+                .firstCommand = group.firstCommand + (cutFirst - group.firstBatch),
+                .commandsNumber = cutEnd - cutFirst});
+            ++range.indirectGroupsNumber;
+
+            if (groupEnd > end)
+            {
+                break;
+            }
+        }
+    }
+}
+
+void DrawCommandBuilder::setMeshEntities(const std::vector<Entity>& meshEntities, const size_t meshEntitiesVersion)
+{
+    if (mMeshEntitiesVersion == meshEntitiesVersion)
+    {
+        return;
+    }
+
+    mMeshEntitiesVersion = meshEntitiesVersion;
+
+    mObjectIndices.clear();
+    for (uint32_t i{}; i < meshEntities.size(); ++i)
+    {
+        const auto id = static_cast<size_t>(meshEntities[i].getId());
+        if (id >= mObjectIndices.size())
+        {
+            mObjectIndices.resize(id + 1);
+        }
+        mObjectIndices[id] = i;
+    }
+}
+
+PipelineType DrawCommandBuilder::getPipelineType(const Entity entity)
+{
+#define PIPELINE(type)                                                  \
+    if (entity.hasComponent<RendererComponent<PipelineType::type>>())   \
+    {                                                                   \
+        return PipelineType::type;                                      \
+    }
+
+    TS_PIPELINES_LIST
+#undef PIPELINE
+
+    return PipelineType::INVALID;
+}
+
+size_t DrawCommandBuilder::MaterialHash::operator()(const Material& material) const
+{
+    size_t seed{};
+    for (const auto value : {material.color.x, material.color.y, material.color.z, material.roughness, material.metallic})
+    {
+        // Adding zero turns -0.f into 0.f, they have to land in the same bucket as they are equal
+        seed ^= std::hash<float>{}(value + 0.f) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    return seed;
+}
+
+DrawKey DrawCommandBuilder::makeDrawKey(const Entity entity, const math::Vec3& eyePos, const uint32_t lodLevel)
+{
+    const auto pipelineType = getPipelineType(entity);
+
+    // Materials and meshes are numbered in the order of their first appearance, 0 means none
+    uint32_t material{};
+    if (pipelineType == PipelineType::PBR)
+    {
+        const auto& entityMaterial = entity.getComponent<RendererComponent<PipelineType::PBR>>().material;
+        material = mMaterialIds.try_emplace(entityMaterial, static_cast<uint32_t>(mMaterialIds.size()) + 1).first->second;
+
+        // Material is a part of the per object data, it only orders the draws, so the ones past the field share its last id
+        material = std::min(material, maxMaterialId);
+    }
+
+    uint32_t mesh{};
+    if (entity.hasComponent<MeshComponent>())
+    {
+        const auto& meshComponent = entity.getComponent<MeshComponent>();
+        const auto meshKey = (static_cast<uint64_t>(meshComponent.getLod(lodLevel).firstIndex) << 32) | meshComponent.vertexOffset;
+        mesh = mMeshIds.try_emplace(meshKey, static_cast<uint32_t>(mMeshIds.size()) + 1).first->second;
+
+        // Draws with the same mesh id become instances of one draw, so the ids can't be shared
+        if (mesh > maxMeshId)
+        {
+            TS_ERR(std::format("{} meshes don't fit in the draw key", mMeshIds.size()).c_str());
+        }
+    }
+
+    // Entities without a transform, like the grid, aren't placed anywhere, they're ordered by their state only
+    float depth{};
+    if (entity.hasComponent<TransformComponent>())
+    {
+        const auto pos = entity.getComponent<TransformComponent>().getWorldPosition();
+        const math::Vec3 toEye{pos.x - eyePos.x, pos.y - eyePos.y, pos.z - eyePos.z};
+        depth = (toEye.x * toEye.x) + (toEye.y * toEye.y) + (toEye.z * toEye.z);
+    }
+
+    return draw_key::make(
+        entity.getComponent<RendererComponentBase>().z,
+        static_cast<uint32_t>(pipelineType),
+        material,
+        mesh,
+        depth);
+}
+} // namespace ver
+} // namespace ts
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "draw_list.h"
+
+#include "tsengine/ecs/ecs.h"
+#include "tsengine/ecs/components/mesh_component.hpp"
+#include "tsengine/ecs/components/renderer_component.hpp"
+
+#include <optional>
+#include <span>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Contiguous part of the sorted batches recorded into one command buffer, the indirect groups crossing its bounds are cut
+struct DrawRecordingRange
+{
+    uint32_t firstBatch;
+    uint32_t batchesNumber;
+    uint32_t firstIndirectGroup;
+    uint32_t indirectGroupsNumber;
+};
+
+// Eyes in the world space and the pixels covered by the unit size at the unit distance
+struct LodSelection
+{
+    std::span<const math::Vec3> eyePositions;
+    float pixelsPerUnit;
+    // Largest error of the selected levels on the screen
+    float maxPixelError{1.f};
+};
+
+namespace lod
+{
+// Coarsest level of the mesh whose error projected from the closest eye stays under the max pixel error.
+// All the eyes share the level, as they're drawn by the same commands.
+uint32_t select(const MeshComponent& mesh, const math::Mat4& worldMat, const LodSelection& selection);
+} // namespace lod
+
+// CPU side of the draw submission, everything the command buffer needs is built from the registry
+// without touching the device
+class DrawCommandBuilder final
+{
+public:
+    // Draws are sorted by their keys and the neighbouring meshes needing the same state become instances of one
+    // indirect command, the commands of one pipeline are grouped into one indirect call.
+    // Entities with zero visibility are skipped, empty visibility draws all of them. Meshes are drawn with the level
+    // of detail picked by the selection, or with the base one without it. Depth of the draws is their distance
+    // to the eye in the world space.
+    void build(
+        const std::vector<Entity>& entities,
+        const math::Vec3& eyePos,
+        const std::span<const uint8_t> visibility = {},
+        const std::optional<LodSelection>& lodSelection = std::nullopt);
+
+    // Splits the built batches into at most maxRanges ranges of similar size, none smaller than minBatchesPerRange
+    // unless all the batches are fewer
+    void splitRecording(const size_t maxRanges, const size_t minBatchesPerRange);
+
+    // Per object data is stored in the order of the mesh entities, so the slots change only with the set of them
+    void setMeshEntities(const std::vector<Entity>& meshEntities, const size_t meshEntitiesVersion);
+    uint32_t getObjectIndex(const Entity entity) const { return mObjectIndices.at(entity.getId()); }
+
+    static PipelineType getPipelineType(const Entity entity);
+
+    const DrawList& getDrawList() const { return mDrawList; }
+    // Index of the per object data of every sorted draw, the instances of a batch read it with gl_InstanceIndex
+    const std::vector<uint32_t>& getInstanceObjects() const { return mInstanceObjects; }
+    const std::vector<DrawIndexedIndirectCommand>& getIndirectCommands() const { return mIndirectCommands; }
+    const std::vector<IndirectDrawGroup>& getIndirectGroups() const { return mIndirectGroups; }
+    const std::vector<DrawRecordingRange>& getRecordingRanges() const { return mRecordingRanges; }
+    // Indirect groups of the recording ranges, cut at their bounds
+    const std::vector<IndirectDrawGroup>& getRecordingGroups() const { return mRecordingGroups; }
+    // Level of detail of every entity in the order of the built ones, valid for the drawn meshes
+    const std::vector<uint8_t>& getLodLevels() const { return mLodLevels; }
+    size_t getTrianglesNumber() const { return mTrianglesNumber; }
+
+private:
+    using Material = RendererComponent<PipelineType::PBR>::Material;
+
+    struct MaterialHash
+    {
+        size_t operator()(const Material& material) const;
+    };
+
+    DrawKey makeDrawKey(const Entity entity, const math::Vec3& eyePos, const uint32_t lodLevel);
+
+    DrawList mDrawList;
+    std::vector<uint32_t> mInstanceObjects;
+    std::vector<DrawIndexedIndirectCommand> mIndirectCommands;
+    std::vector<IndirectDrawGroup> mIndirectGroups;
+    std::vector<DrawRecordingRange> mRecordingRanges;
+    std::vector<IndirectDrawGroup> mRecordingGroups;
+    std::vector<uint8_t> mLodLevels;
+    size_t mTrianglesNumber{};
+
+    std::vector<uint32_t> mObjectIndices;
+    size_t mMeshEntitiesVersion{std::numeric_limits<size_t>::max()};
+    // Numbered anew by every build, so the ids of the removed ones don't fill the fields of the keys
+    std::unordered_map<Material, uint32_t, MaterialHash> mMaterialIds;
+    std::unordered_map<uint64_t, uint32_t> mMeshIds;
+};
+} // namespace ver
+} // namespace ts
@@ -0,0 +1,150 @@
+#include "draw_list.h"
+
+#include "tsengine/logger.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace draw_key
+{
+namespace
+{
+constexpr uint32_t depthShift{0};
+constexpr uint32_t meshShift{16};
+constexpr uint32_t materialShift{meshShift + meshBits};
+constexpr uint32_t pipelineShift{materialShift + materialBits};
+constexpr uint32_t zShift{pipelineShift + pipelineBits};
+
+constexpr uint64_t mask(const uint32_t bits)
+{
+    return (uint64_t{1} << bits) - 1;
+}
+} // namespace
+
+DrawKey make(const int32_t z, const uint32_t pipeline, const uint32_t material, const uint32_t mesh, const float depth)
+{
+    TS_ASSERT_MSG(pipeline <= mask(pipelineBits), "Pipeline doesn't fit in the draw key");
+    TS_ASSERT_MSG(material <= mask(materialBits), "Material doesn't fit in the draw key");
+    TS_ASSERT_MSG(mesh <= mask(meshBits), "Mesh doesn't fit in the draw key");
+
+    // Biased, so the negative values are ordered before the positive ones
+    const auto clampedZ = std::clamp(z, int32_t{std::numeric_limits<int16_t>::min()}, int32_t{std::numeric_limits<int16_t>::max()});
+    const auto biasedZ = static_cast<uint64_t>(clampedZ - std::numeric_limits<int16_t>::min());
+
+    // Bits of the non negative floats are ordered like their values
+    const auto depthBits = static_cast<uint64_t>(std::bit_cast<uint32_t>(std::max(depth, 0.f)) >> 16);
+
+    return (biasedZ << zShift) |
+        ((pipeline & mask(pipelineBits)) << pipelineShift) |
+        ((material & mask(materialBits)) << materialShift) |
+        ((mesh & mask(meshBits)) << meshShift) |
+        (depthBits << depthShift);
+}
+
+uint32_t getPipeline(const DrawKey key)
+{
+    return static_cast<uint32_t>((key >> pipelineShift) & mask(pipelineBits));
+}
+
+uint32_t getMaterial(const DrawKey key)
+{
+    return static_cast<uint32_t>((key >> materialShift) & mask(materialBits));
+}
+
+uint32_t getMesh(const DrawKey key)
+{
+    return static_cast<uint32_t>((key >> meshShift) & mask(meshBits));
+}
+
+bool isSameState(const DrawKey lhs, const DrawKey rhs)
+{
+    return (lhs >> meshShift) == (rhs >> meshShift);
+}
+} // namespace draw_key
+
+void DrawList::sort()
+{
+    constexpr size_t bucketsNumber{256};
+    constexpr size_t passesNumber{sizeof(DrawKey)};
+
+    // Histograms of all the passes are counted in one read of the keys
+    std::array<std::array<uint32_t, bucketsNumber>, passesNumber> histograms{};
+    for (const auto& item : mItems)
+    {
+        for (size_t pass{}; pass < passesNumber; ++pass)
+        {
+            ++histograms[pass][(item.key >> (pass * 8)) & 0xFF];
+        }
+    }
+
+    mSortBuffer.resize(mItems.size());
+    for (size_t pass{}; pass < passesNumber; ++pass)
+    {
+        auto& histogram = histograms[pass];
+        const auto shift = pass * 8;
+        if (histogram[(mItems.empty() ? 0 : (mItems.front().key >> shift) & 0xFF)] == mItems.size())
+        {
+            continue;
+        }
+
+        uint32_t offset{};
+        for (auto& count : histogram)
+        {
+            offset += std::exchange(count, offset);
+        }
+
+        for (const auto& item : mItems)
+        {
+            mSortBuffer[histogram[(item.key >> shift) & 0xFF]++] = item;
+        }
+
+        mItems.swap(mSortBuffer);
+    }
+}
+
+void DrawList::buildBatches()
+{
+    mBatches.clear();
+    for (uint32_t i{}; i < mItems.size(); ++i)
+    {
+        const auto key = mItems[i].key;
+        if (!mBatches.empty() && (draw_key::getMesh(key) != 0))
+        {
+            auto& batch = mBatches.back();
+            if (draw_key::isSameState(mItems[batch.firstItem].key, key))
+            {
+                ++batch.itemsNumber;
+                continue;
+            }
+        }
+
+        mBatches.push_back({.firstItem = i, .itemsNumber = 1});
+    }
+}
+
+void DrawStateTracker::reset()
+{
+    mPipeline = invalidState;
+    mStatistics = {};
+}
+
+bool DrawStateTracker::shouldBindPipeline(const uint32_t pipeline)
+{
+    if (mPipeline == pipeline)
+    {
+        ++mStatistics.pipelineBindsSkipped;
+        return false;
+    }
+
+    mPipeline = pipeline;
+    ++mStatistics.pipelineBinds;
+    return true;
+}
+} // namespace ver
+} // namespace ts
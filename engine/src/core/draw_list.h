@@ -0,0 +1,123 @@
+#pragma once
+
+#include "tsengine/math.hpp"
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Draws sorted by the key are grouped by the state they need, from the most significant bits:
+// z (16), pipeline (4), material (12), mesh (16) and depth (16)
+using DrawKey = uint64_t;
+
+namespace draw_key
+{
+inline constexpr uint32_t pipelineBits{4};
+inline constexpr uint32_t materialBits{12};
+inline constexpr uint32_t meshBits{16};
+
+// Depth has to be non negative, it's compared through the upper bits of its floating point representation
+DrawKey make(const int32_t z, const uint32_t pipeline, const uint32_t material, const uint32_t mesh, const float depth);
+uint32_t getPipeline(const DrawKey key);
+uint32_t getMaterial(const DrawKey key);
+uint32_t getMesh(const DrawKey key);
+// Keys differing only by the depth need the same state
+bool isSameState(const DrawKey lhs, const DrawKey rhs);
+} // namespace draw_key
+
+struct DrawItem
+{
+    DrawKey key;
+    // Position of the draw in the data of the caller
+    uint32_t index;
+};
+
+// Range of the sorted items drawn as instances of one draw
+struct DrawBatch
+{
+    uint32_t firstItem;
+    uint32_t itemsNumber;
+};
+
+// Same layout as VkDrawIndexedIndirectCommand, so the array can be copied to the indirect buffer
+struct DrawIndexedIndirectCommand
+{
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+
+    bool operator==(const DrawIndexedIndirectCommand&) const = default;
+};
+
+// Neighbouring mesh batches drawn with one pipeline by one indirect call, every batch has its command
+struct IndirectDrawGroup
+{
+    uint32_t pipeline;
+    uint32_t firstBatch;
+    uint32_t firstCommand;
+    uint32_t commandsNumber;
+};
+
+class DrawList final
+{
+public:
+    void clear() { mItems.clear(); }
+    void add(const DrawKey key, const uint32_t index) { mItems.push_back({key, index}); }
+
+    // Stable LSD radix sort, passes over the bytes equal in all the keys are skipped
+    void sort();
+    // Neighbouring sorted items with a mesh, which differ only by the depth, are joined into one batch
+    void buildBatches();
+
+    const std::vector<DrawItem>& getItems() const { return mItems; }
+    const std::vector<DrawBatch>& getBatches() const { return mBatches; }
+
+private:
+    std::vector<DrawItem> mItems;
+    std::vector<DrawItem> mSortBuffer;
+    std::vector<DrawBatch> mBatches;
+};
+
+struct DrawStatistics
+{
+    // Draw calls, an indirect call is counted once for all its commands
+    size_t draws, indirectCommands, instances;
+    size_t pipelineBinds, pipelineBindsSkipped;
+
+    DrawStatistics& operator+=(const DrawStatistics& other)
+    {
+        draws += other.draws;
+        indirectCommands += other.indirectCommands;
+        instances += other.instances;
+        pipelineBinds += other.pipelineBinds;
+        pipelineBindsSkipped += other.pipelineBindsSkipped;
+        return *this;
+    }
+};
+
+// Remembers the state bound in the command buffer, so the binds repeating it can be skipped
+class DrawStateTracker final
+{
+public:
+    void reset();
+
+    bool shouldBindPipeline(const uint32_t pipeline);
+    void countDraw(const size_t instancesNumber) { ++mStatistics.draws; mStatistics.instances += instancesNumber; }
+    void countIndirectCommands(const size_t commandsNumber, const size_t instancesNumber)
+    {
+        mStatistics.indirectCommands += commandsNumber;
+        mStatistics.instances += instancesNumber;
+    }
+
+    const DrawStatistics& getStatistics() const { return mStatistics; }
+
+private:
+    static constexpr uint32_t invalidState{std::numeric_limits<uint32_t>::max()};
+
+    uint32_t mPipeline{invalidState};
+    DrawStatistics mStatistics{};
+};
+} // namespace ver
+} // namespace ts
@@ -0,0 +1,79 @@
+#include "tsengine/event_bus.hpp"
+
+#include "tsengine/logger.h"
+
+#include <format>
+#include <thread>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+EventBus::EventBus(const size_t arenaSize) : mArenaSize{arenaSize}
+{
+    for (auto& arena : mArenas)
+    {
+        arena.data = std::make_unique<std::byte[]>(mArenaSize);
+    }
+}
+
+EventBus::~EventBus()
+{
+    for (auto& arena : mArenas)
+    {
+        flush(arena, false);
+    }
+}
+
+void EventBus::dispatchQueuedEvents()
+{
+    const auto frameArena = mActiveArena.load();
+    mActiveArena.store(1 - frameArena);
+
+    // Writers which have chosen the arena of the frame are finishing their events
+    auto& arena = mArenas[frameArena];
+    while (arena.writers.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    flush(arena, true);
+
+    if (const auto droppedEventsNumber = mDroppedEventsNumber.exchange(0, std::memory_order_relaxed); droppedEventsNumber > 0)
+    {
+        TS_WARN(std::format("{} queued events were dropped, the arena of {} bytes is full", droppedEventsNumber, mArenaSize).c_str());
+    }
+}
+
+void EventBus::flush(Arena& arena, const bool shouldDispatch)
+{
+    const auto head = arena.head.load();
+    for (size_t offset{}; offset < head;)
+    {
+        auto* const pRecord = arena.data.get() + offset;
+        const auto& queuedEvent = *std::launder(reinterpret_cast<QueuedEvent*>(pRecord));
+        offset += queuedEvent.size;
+
+        if (queuedEvent.dispatch == nullptr)
+        {
+            continue;
+        }
+
+        auto* const pEvent = pRecord + queuedEventOffset;
+        if (shouldDispatch)
+        {
+            queuedEvent.dispatch(*this, pEvent);
+        }
+        queuedEvent.destroy(pEvent);
+    }
+
+    arena.head.store(0);
+}
+
+EventBus& getEventBus()
+{
+    static EventBus eventBus;
+    return eventBus;
+}
+} // namespace ver
+} // namespace ts
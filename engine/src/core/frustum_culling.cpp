@@ -0,0 +1,292 @@
+#include "frustum_culling.h"
+#include "aabb_tree.h"
+
+#include "tsengine/ecs/components/mesh_component.hpp"
+#include "tsengine/ecs/components/transform_component.hpp"
+
+#include <bit>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace frustum
+{
+namespace
+{
+// Plane which every point is inside of
+constexpr math::Vec4 openPlane{0.f, 0.f, 0.f, 1.f};
+
+// Points further out than this, relative to their distance from the origin, are treated as outside of a plane
+constexpr float planeTolerance{1e-4f};
+
+math::Vec4 getRow(const math::Mat4& mat, const size_t row)
+{
+    const auto element = [row](const math::Vec4& column) {
+        return std::array{column.x, column.y, column.z, column.w}[row];
+    };
+
+    return {element(mat.data[0]), element(mat.data[1]), element(mat.data[2]), element(mat.data[3])};
+}
+
+math::Vec4 normalizePlane(const math::Vec4& plane)
+{
+    const auto length = std::sqrt((plane.x * plane.x) + (plane.y * plane.y) + (plane.z * plane.z));
+    return (length > 0.f) ? plane * (1.f / length) : openPlane;
+}
+
+float getDistance(const math::Vec4& plane, const math::Vec3& point)
+{
+    return (plane.x * point.x) + (plane.y * point.y) + (plane.z * point.z) + plane.w;
+}
+
+std::array<math::Vec3, 8> getCorners(const math::Mat4& viewProj)
+{
+    const auto invViewProj = math::inverse(viewProj);
+
+    std::array<math::Vec3, 8> corners;
+    for (size_t i{}; i < corners.size(); ++i)
+    {
+        const math::Vec4 clipCorner{(i & 1) ? 1.f : -1.f, (i & 2) ? 1.f : -1.f, (i & 4) ? 1.f : -1.f, 1.f};
+        const auto corner = invViewProj * clipCorner;
+        corners[i] = {corner.x / corner.w, corner.y / corner.w, corner.z / corner.w};
+    }
+
+    return corners;
+}
+} // namespace
+
+Frustum make(const math::Mat4& viewProj)
+{
+    const auto x = getRow(viewProj, 0);
+    const auto y = getRow(viewProj, 1);
+    const auto z = getRow(viewProj, 2);
+    const auto w = getRow(viewProj, 3);
+
+    return {{
+        normalizePlane(w + x),
+        normalizePlane(w + (x * -1.f)),
+        normalizePlane(w + y),
+        normalizePlane(w + (y * -1.f)),
+        normalizePlane(w + z),
+        normalizePlane(w + (z * -1.f)),
+    }};
+}
+
+Frustum makeConservative(const std::span<const math::Mat4> viewProjs)
+{
+    std::vector<Frustum> frusta;
+    std::vector<math::Vec3> corners;
+    for (const auto& viewProj : viewProjs)
+    {
+        frusta.push_back(make(viewProj));
+        std::ranges::copy(getCorners(viewProj), std::back_inserter(corners));
+    }
+
+    Frustum conservativeFrustum;
+    conservativeFrustum.planes.fill(openPlane);
+    for (size_t side{}; side < Frustum::planesNumber; ++side)
+    {
+        for (const auto& frustum : frusta)
+        {
+            const auto& plane = frustum.planes[side];
+            const auto containsAllCorners = std::ranges::all_of(corners, [&plane](const math::Vec3& corner) {
+                const auto magnitude = std::sqrt((corner.x * corner.x) + (corner.y * corner.y) + (corner.z * corner.z));
+                return getDistance(plane, corner) >= -planeTolerance * (1.f + magnitude);
+            });
+
+            if (containsAllCorners)
+            {
+                conservativeFrustum.planes[side] = plane;
+                break;
+            }
+        }
+    }
+
+    return conservativeFrustum;
+}
+
+bool isBoxVisible(const Frustum& frustum, const math::Vec3& center, const math::Vec3& extent)
+{
+    for (const auto& plane : frustum.planes)
+    {
+        const auto distance = (plane.x * center.x) + (plane.y * center.y) + (plane.z * center.z) + plane.w;
+        const auto radius = (std::abs(plane.x) * extent.x) + (std::abs(plane.y) * extent.y) + (std::abs(plane.z) * extent.z);
+        if (distance + radius < 0.f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+} // namespace frustum
+
+void FrustumCuller::cull(const Frustum& frustum, const std::vector<Entity>& entities, const size_t entitiesVersion)
+{
+    setEntities(entities, entitiesVersion);
+
+    // Boxes are packed again only when some transform has changed since the last time
+    const auto transformsVersion = TransformComponent::getLatestVersion();
+    if (mPackedTransformsVersion != transformsVersion)
+    {
+        packBounds(entities);
+        mPackedTransformsVersion = transformsVersion;
+    }
+
+    mVisibility.resize(entities.size());
+    mStatistics = {};
+
+    size_t i{};
+#ifdef TS_MATH_SSE
+    std::array<std::array<__m128, 4>, Frustum::planesNumber> planes;
+    std::array<std::array<__m128, 3>, Frustum::planesNumber> absNormals;
+    for (size_t planeIndex{}; planeIndex < Frustum::planesNumber; ++planeIndex)
+    {
+        const auto& plane = frustum.planes[planeIndex];
+        planes[planeIndex] = {_mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z), _mm_set1_ps(plane.w)};
+        absNormals[planeIndex] = {_mm_set1_ps(std::abs(plane.x)), _mm_set1_ps(std::abs(plane.y)), _mm_set1_ps(std::abs(plane.z))};
+    }
+
+    const auto zero = _mm_setzero_ps();
+    for (; i < entities.size(); i += lanesNumber)
+    {
+        const auto centerX = _mm_loadu_ps(&mCenters[0][i]);
+        const auto centerY = _mm_loadu_ps(&mCenters[1][i]);
+        const auto centerZ = _mm_loadu_ps(&mCenters[2][i]);
+        const auto extentX = _mm_loadu_ps(&mExtents[0][i]);
+        const auto extentY = _mm_loadu_ps(&mExtents[1][i]);
+        const auto extentZ = _mm_loadu_ps(&mExtents[2][i]);
+
+        // Bit of every lane is cleared once its box is fully outside of any plane
+        int visibleMask{(1 << lanesNumber) - 1};
+        for (size_t planeIndex{}; planeIndex < Frustum::planesNumber; ++planeIndex)
+        {
+            const auto& [planeX, planeY, planeZ, planeW] = planes[planeIndex];
+            const auto& [absX, absY, absZ] = absNormals[planeIndex];
+
+            auto distance = _mm_mul_ps(planeX, centerX);
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeY, centerY));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeZ, centerZ));
+            distance = _mm_add_ps(distance, planeW);
+
+            auto radius = _mm_mul_ps(absX, extentX);
+            radius = _mm_add_ps(radius, _mm_mul_ps(absY, extentY));
+            radius = _mm_add_ps(radius, _mm_mul_ps(absZ, extentZ));
+
+            visibleMask &= ~_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        const auto lanesUsed = std::min(lanesNumber, entities.size() - i);
+        for (size_t lane{}; lane < lanesUsed; ++lane)
+        {
+            mVisibility[i + lane] = static_cast<uint8_t>((visibleMask >> lane) & 1);
+        }
+        mStatistics.visible += std::popcount(static_cast<uint32_t>(visibleMask & ((1 << lanesUsed) - 1)));
+    }
+#else
+    for (; i < entities.size(); ++i)
+    {
+        const math::Vec3 center{mCenters[0][i], mCenters[1][i], mCenters[2][i]};
+        const math::Vec3 extent{mExtents[0][i], mExtents[1][i], mExtents[2][i]};
+        mVisibility[i] = frustum::isBoxVisible(frustum, center, extent);
+        mStatistics.visible += mVisibility[i];
+    }
+#endif // TS_MATH_SSE
+
+    mStatistics.culled = entities.size() - mStatistics.visible;
+}
+
+void FrustumCuller::cull(const Frustum& frustum, const std::vector<Entity>& entities, const size_t entitiesVersion, const AabbTree& tree)
+{
+    setEntities(entities, entitiesVersion);
+
+    mVisibility.resize(entities.size());
+    mStatistics = {};
+    for (size_t i{}; i < entities.size(); ++i)
+    {
+        mVisibility[i] = (mHasMesh[i] == 0);
+        mStatistics.visible += mVisibility[i];
+    }
+
+    tree.queryFrustum(frustum, [&](const uint32_t proxy) {
+        const auto id = tree.getUserData(proxy);
+        const auto index = (id < mIndexPerId.size()) ? mIndexPerId[id] : invalidIndex;
+        if ((index != invalidIndex) && (mHasMesh[index] != 0))
+        {
+            mVisibility[index] = 1;
+            ++mStatistics.visible;
+        }
+    });
+
+    mStatistics.culled = entities.size() - mStatistics.visible;
+}
+
+void FrustumCuller::setEntities(const std::vector<Entity>& entities, const size_t entitiesVersion)
+{
+    if (mEntitiesVersion == entitiesVersion)
+    {
+        return;
+    }
+
+    mEntitiesVersion = entitiesVersion;
+
+    // Padding lanes of the last block are tested too, their results are dropped
+    const auto paddedSize = ((entities.size() + lanesNumber - 1) / lanesNumber) * lanesNumber;
+    for (size_t axis{}; axis < 3; ++axis)
+    {
+        mCenters[axis].assign(paddedSize, 0.f);
+        mExtents[axis].assign(paddedSize, 0.f);
+    }
+    mWorldVersions.assign(entities.size(), std::numeric_limits<uint64_t>::max());
+    mHasMesh.resize(entities.size());
+    mIndexPerId.clear();
+    for (uint32_t i{}; i < entities.size(); ++i)
+    {
+        mHasMesh[i] = entities[i].hasComponent<MeshComponent>();
+
+        const auto id = static_cast<size_t>(entities[i].getId());
+        if (id >= mIndexPerId.size())
+        {
+            mIndexPerId.resize(id + 1, invalidIndex);
+        }
+        mIndexPerId[id] = i;
+    }
+    mPackedTransformsVersion = 0;
+}
+
+void FrustumCuller::packBounds(const std::vector<Entity>& entities)
+{
+    for (size_t i{}; i < entities.size(); ++i)
+    {
+        const auto entity = entities[i];
+        if (mHasMesh[i] == 0)
+        {
+            // The box covers everything, its radius overflows to the infinity at worst, which is still inside
+            for (size_t axis{}; axis < 3; ++axis)
+            {
+                mCenters[axis][i] = 0.f;
+                mExtents[axis][i] = std::numeric_limits<float>::max();
+            }
+            continue;
+        }
+
+        const auto& transform = entity.getComponent<TransformComponent>();
+        if (mWorldVersions[i] == transform.getWorldVersion())
+        {
+            continue;
+        }
+        mWorldVersions[i] = transform.getWorldVersion();
+
+        const auto& mesh = entity.getComponent<MeshComponent>();
+        const auto box = aabb::transform({mesh.boundsMin, mesh.boundsMax}, transform.getWorldMat());
+        mCenters[0][i] = (box.min.x + box.max.x) / 2.f;
+        mCenters[1][i] = (box.min.y + box.max.y) / 2.f;
+        mCenters[2][i] = (box.min.z + box.max.z) / 2.f;
+        mExtents[0][i] = (box.max.x - box.min.x) / 2.f;
+        mExtents[1][i] = (box.max.y - box.min.y) / 2.f;
+        mExtents[2][i] = (box.max.z - box.min.z) / 2.f;
+    }
+}
+} // namespace ver
+} // namespace ts
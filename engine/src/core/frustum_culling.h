@@ -0,0 +1,71 @@
+#pragma once
+
+#include "tsengine/math.hpp"
+#include "tsengine/ecs/ecs.h"
+
+#include <span>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Points p with dot(plane.xyz, p) + plane.w >= 0 are inside of every plane, the normals have the unit length
+struct Frustum
+{
+    static constexpr size_t planesNumber{6};
+
+    std::array<math::Vec4, planesNumber> planes;
+};
+
+namespace frustum
+{
+// Planes of the clip space -w <= x, y, z <= w transformed by the matrix
+Frustum make(const math::Mat4& viewProj);
+// One frustum containing the frusta of all the matrices, every side is taken from the frustum whose plane contains
+// all the others, a side which none of them bounds is left open
+Frustum makeConservative(const std::span<const math::Mat4> viewProjs);
+bool isBoxVisible(const Frustum& frustum, const math::Vec3& center, const math::Vec3& extent);
+} // namespace frustum
+
+class AabbTree;
+
+struct CullingStatistics
+{
+    size_t visible, culled;
+};
+
+// World bounding boxes of the entities are packed as arrays of their centers and extents, so one SIMD register
+// tests the same plane against four boxes. Entities without a mesh are never culled.
+class FrustumCuller final
+{
+public:
+    void cull(const Frustum& frustum, const std::vector<Entity>& entities, const size_t entitiesVersion);
+    // Meshes are found by the query of the tree instead of testing all of them, user data of its proxies are the
+    // entity ids
+    void cull(const Frustum& frustum, const std::vector<Entity>& entities, const size_t entitiesVersion, const AabbTree& tree);
+
+    // Visibility of every entity in the order of the culled ones
+    const std::vector<uint8_t>& getVisibility() const { return mVisibility; }
+    const CullingStatistics& getStatistics() const { return mStatistics; }
+
+private:
+    static constexpr size_t lanesNumber{4};
+
+    static constexpr uint32_t invalidIndex{std::numeric_limits<uint32_t>::max()};
+
+    void setEntities(const std::vector<Entity>& entities, const size_t entitiesVersion);
+    void packBounds(const std::vector<Entity>& entities);
+
+    std::array<std::vector<float>, 3> mCenters;
+    std::array<std::vector<float>, 3> mExtents;
+    // World version of the transform whose box is packed
+    std::vector<uint64_t> mWorldVersions;
+    std::vector<uint8_t> mHasMesh;
+    std::vector<uint32_t> mIndexPerId;
+    size_t mEntitiesVersion{std::numeric_limits<size_t>::max()};
+    uint64_t mPackedTransformsVersion{};
+    std::vector<uint8_t> mVisibility;
+    CullingStatistics mStatistics{};
+};
+} // namespace ver
+} // namespace ts
@@ -0,0 +1,187 @@
+#include "tsengine/job_system.h"
+
+#include <optional>
+#include <utility>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace
+{
+constexpr size_t externalQueueIndex{};
+thread_local size_t currentQueueIndex{externalQueueIndex};
+thread_local const JobSystem* currentJobSystem{};
+} // namespace
+
+JobSystem::JobSystem(const size_t threadsNumber)
+{
+    const auto queuesNumber = std::max<size_t>(1, threadsNumber);
+    for (size_t i{}; i < queuesNumber; ++i)
+    {
+        mQueues.emplace_back(std::make_unique<Queue>());
+    }
+
+    // The first queue belongs to the threads from outside, they work on it while waiting
+    for (size_t queueIndex{1}; queueIndex < queuesNumber; ++queueIndex)
+    {
+        mWorkers.emplace_back(&JobSystem::workerLoop, this, queueIndex);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard _{mWakeMutex};
+        mIsStopping = true;
+    }
+    mWakeCondition.notify_all();
+
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::run(Job job, JobCounter* const counter)
+{
+    if (counter != nullptr)
+    {
+        counter->mPendingJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard _{mWakeMutex};
+        mQueuedJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    const auto queueIndex = (currentJobSystem == this) ? currentQueueIndex : externalQueueIndex;
+    {
+        auto& queue = *mQueues[queueIndex];
+        std::lock_guard _{queue.mutex};
+        queue.jobs.emplace_back(std::move(job), counter);
+    }
+    mWakeCondition.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    const auto queueIndex = (currentJobSystem == this) ? currentQueueIndex : externalQueueIndex;
+    while (!counter.isDone())
+    {
+        if (tryExecuteJob(queueIndex))
+        {
+            continue;
+        }
+
+        // Jobs of the counter are running on the other threads, the last one of them wakes the waiters
+        std::unique_lock lock{mWakeMutex};
+        mWakeCondition.wait(lock, [&] { return counter.isDone() || (mQueuedJobs.load(std::memory_order_acquire) > 0); });
+    }
+
+    std::lock_guard _{counter.mExceptionMutex};
+    if (counter.mException)
+    {
+        std::rethrow_exception(std::exchange(counter.mException, nullptr));
+    }
+}
+
+void JobSystem::workerLoop(const size_t queueIndex)
+{
+    currentQueueIndex = queueIndex;
+    currentJobSystem = this;
+
+    while (true)
+    {
+        if (tryExecuteJob(queueIndex))
+        {
+            continue;
+        }
+
+        std::unique_lock lock{mWakeMutex};
+        mWakeCondition.wait(lock, [this] { return mIsStopping || (mQueuedJobs.load(std::memory_order_acquire) > 0); });
+        if (mIsStopping)
+        {
+            return;
+        }
+    }
+}
+
+bool JobSystem::tryExecuteJob(const size_t queueIndex)
+{
+    std::optional<std::pair<Job, JobCounter*>> job;
+
+    {
+        auto& ownQueue = *mQueues[queueIndex];
+        std::lock_guard _{ownQueue.mutex};
+        if (!ownQueue.jobs.empty())
+        {
+            job = std::move(ownQueue.jobs.back());
+            ownQueue.jobs.pop_back();
+        }
+    }
+
+    for (size_t offset{1}; (!job.has_value()) && (offset < mQueues.size()); ++offset)
+    {
+        auto& victimQueue = *mQueues[(queueIndex + offset) % mQueues.size()];
+        std::lock_guard _{victimQueue.mutex};
+        if (!victimQueue.jobs.empty())
+        {
+            job = std::move(victimQueue.jobs.front());
+            victimQueue.jobs.pop_front();
+        }
+    }
+
+    if (!job.has_value())
+    {
+        return false;
+    }
+
+    mQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    execute(*job);
+
+    return true;
+}
+
+void JobSystem::execute(std::pair<Job, JobCounter*>& job)
+{
+    auto& [function, counter] = job;
+
+    try
+    {
+        function();
+    }
+    catch (...)
+    {
+        auto& exception = (counter != nullptr) ? counter->mException : mDetachedException;
+        std::lock_guard _{(counter != nullptr) ? counter->mExceptionMutex : mDetachedExceptionMutex};
+        if (!exception)
+        {
+            exception = std::current_exception();
+        }
+    }
+
+    // Counter can be destroyed by its waiter right after it's done, so it isn't touched after that
+    if ((counter != nullptr) && (counter->mPendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1))
+    {
+        std::lock_guard _{mWakeMutex};
+        mWakeCondition.notify_all();
+    }
+}
+
+void JobSystem::rethrowDetachedException()
+{
+    std::lock_guard _{mDetachedExceptionMutex};
+    if (mDetachedException)
+    {
+        std::rethrow_exception(std::exchange(mDetachedException, nullptr));
+    }
+}
+
+JobSystem& getJobSystem()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+} // namespace ver
+} // namespace ts
@@ -2,6 +2,11 @@
 
 #include "internal_utils.h"
 
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <thread>
+
 #ifdef _WIN32
 #include <Windows.h>
 #endif
@@ -13,7 +18,6 @@ inline namespace TS_VER
 namespace
 {
 constexpr std::string_view formatingEnd{"\033[0m"};
-std::mutex loggerMutex;
 
 enum class Color
 {
@@ -37,39 +41,251 @@ consteval std::string_view colorToString(Color color)
     }
 }
 
-__forceinline std::string currentDateTimeToStr()
+// ERROR is a macro of Windows.h
+enum class Level
+{
+    INFO,
+    WARNING,
+    ERR
+};
+
+void debugBreak()
 {
-    return std::format("{:%d-%m-%Y %H:%M:%OS}",
-        std::chrono::zoned_time(std::chrono::current_zone(), std::chrono::system_clock::now()));
+#ifdef _WIN32
+    DebugBreak();
+#else
+#error not implemented
+#endif // _WIN32
 }
 
-#ifndef NDEBUG
-inline auto debugInfo(std::string fileName, std::string functionName, int lineNumber)
+// Call sites only copy their message into a slot of the bounded MPSC queue, the background writer formats
+// the records and writes them to the console. Slots carry the sequence numbers of the positions they can be
+// written and read at, so the producers claim them with one CAS and never wait for each other.
+// It's never destroyed, so the statics logging from their destructors still find it. The engine flushes it on the shutdown.
+class AsyncLogger final
 {
-    std::ostringstream ss;
-    if (fileName.length() || functionName.length())
+    TS_NOT_COPYABLE_AND_MOVEABLE(AsyncLogger);
+
+public:
+    AsyncLogger() : mRecords{std::make_unique<Record[]>(capacity)}
     {
-        ss << " at";
+        for (size_t i{}; i < capacity; ++i)
+        {
+            mRecords[i].sequence.store(i, std::memory_order_relaxed);
+            mRecords[i].message.reserve(initialMessageCapacity);
+        }
+
+        mWriter = std::thread{&AsyncLogger::writerLoop, this};
     }
 
-    if (fileName.length())
+    void push(const Level level, const char* message, const char* fileName, const char* functionName, const int lineNumber)
     {
-        ss << " " << fileName;
+        auto position = mEnqueuePosition.load(std::memory_order_relaxed);
+        Record* pRecord{};
+        while (true)
+        {
+            pRecord = &mRecords[position % capacity];
+            const auto sequence = pRecord->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+            if (difference == 0)
+            {
+                if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Queue is full, only the infos can be dropped
+                if ((mOverflowPolicy.load(std::memory_order_relaxed) == logger::OverflowPolicy::DROP) && (level == Level::INFO))
+                {
+                    mDroppedNumber.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                std::this_thread::yield();
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        pRecord->level = level;
+        pRecord->time = std::chrono::system_clock::now();
+        pRecord->fileName = fileName;
+        pRecord->functionName = functionName;
+        pRecord->lineNumber = lineNumber;
+        pRecord->message.assign(message);
+        pRecord->sequence.store(position + 1, std::memory_order_release);
+
+        mPublishedNumber.fetch_add(1, std::memory_order_release);
+        mPublishedNumber.notify_one();
     }
 
-    if (functionName.length())
+    // Waits until the writer passes every record claimed before
+    void flush()
     {
-        ss << " " << functionName;
+        const auto targetPosition = mEnqueuePosition.load();
+        auto writtenPosition = mWrittenPosition.load();
+        while (writtenPosition < targetPosition)
+        {
+            mWrittenPosition.wait(writtenPosition);
+            writtenPosition = mWrittenPosition.load();
+        }
     }
 
-    if (lineNumber != NOT_PRINT_LINE_NUMBER)
+    void setOverflowPolicy(const logger::OverflowPolicy policy) { mOverflowPolicy.store(policy, std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t capacity{1024};
+    static constexpr size_t initialMessageCapacity{256};
+    static constexpr size_t flushInterval{64};
+
+    struct Record
+    {
+        std::atomic<uint64_t> sequence;
+        Level level;
+        std::chrono::system_clock::time_point time;
+        // Static strings of the logging macros
+        const char* fileName;
+        const char* functionName;
+        int lineNumber;
+        // Keeps its capacity between the uses of the slot
+        std::string message;
+    };
+
+    void writerLoop()
     {
-        ss << ":" + std::to_string(lineNumber);
+        uint64_t readPosition{};
+        std::string line;
+        while (true)
+        {
+            const auto publishedNumber = mPublishedNumber.load(std::memory_order_acquire);
+
+            auto& record = mRecords[readPosition % capacity];
+            if (record.sequence.load(std::memory_order_acquire) == readPosition + 1)
+            {
+                write(record, line);
+                record.sequence.store(readPosition + capacity, std::memory_order_release);
+                readPosition++;
+
+                // Flushes don't wait for the end of a long burst
+                if (readPosition % flushInterval == 0)
+                {
+                    publishWritten(readPosition, line);
+                }
+                continue;
+            }
+
+            publishWritten(readPosition, line);
+            mPublishedNumber.wait(publishedNumber, std::memory_order_acquire);
+        }
     }
 
-    return ss.str();
-}
+    // Drops are reported before, so the flushes see them too. Streams are flushed before the position is published
+    // and aren't touched again until something new is written, so the callers of flush can use them freely after.
+    void publishWritten(const uint64_t position, std::string& line)
+    {
+        const auto droppedNumber = mDroppedNumber.exchange(0, std::memory_order_relaxed);
+        if ((droppedNumber == 0) && (position == mPublishedPosition))
+        {
+            return;
+        }
+
+        if (droppedNumber > 0)
+        {
+            writeDropped(droppedNumber, line);
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+        mPublishedPosition = position;
+        mWrittenPosition.store(position);
+        mWrittenPosition.notify_all();
+    }
+
+    void write(const Record& record, std::string& line)
+    {
+        // Looking up the zone is expensive, it's done once
+        static const auto* const pTimeZone = std::chrono::current_zone();
+
+        const auto [color, levelName] = getLevelStyle(record.level);
+        line.clear();
+        std::format_to(std::back_inserter(line), "{}[{}][{:%d-%m-%Y %H:%M:%OS}",
+            color, levelName, std::chrono::zoned_time(pTimeZone, record.time));
+#ifndef NDEBUG
+        appendDebugInfo(line, record.fileName, record.functionName, record.lineNumber);
 #endif // !NDEBUG
+        std::format_to(std::back_inserter(line), "]: {}{}\n", formatingEnd, record.message);
+
+        auto& stream = (record.level == Level::ERR) ? std::cerr : std::cout;
+        stream.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+
+    void writeDropped(const size_t droppedNumber, std::string& line)
+    {
+        line.clear();
+        std::format_to(std::back_inserter(line), "{}[WARNING]: {}{} messages were dropped, the logger queue was full\n",
+            colorToString(Color::YELLOW), formatingEnd, droppedNumber);
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+
+    static std::pair<std::string_view, std::string_view> getLevelStyle(const Level level)
+    {
+        switch (level)
+        {
+        case Level::INFO:
+            return {colorToString(Color::GREEN), "INFO"};
+        case Level::WARNING:
+            return {colorToString(Color::YELLOW), "WARNING"};
+        default:
+            return {colorToString(Color::RED), "ERROR"};
+        }
+    }
+
+#ifndef NDEBUG
+    static void appendDebugInfo(std::string& line, const std::string_view fileName, const std::string_view functionName, const int lineNumber)
+    {
+        if (!fileName.empty() || !functionName.empty())
+        {
+            line += " at";
+        }
+
+        if (!fileName.empty())
+        {
+            std::format_to(std::back_inserter(line), " {}", fileName);
+        }
+
+        if (!functionName.empty())
+        {
+            std::format_to(std::back_inserter(line), " {}", functionName);
+        }
+
+        if (lineNumber != NOT_PRINT_LINE_NUMBER)
+        {
+            std::format_to(std::back_inserter(line), ":{}", lineNumber);
+        }
+    }
+#endif // !NDEBUG
+
+    std::unique_ptr<Record[]> mRecords;
+    alignas(64) std::atomic<uint64_t> mEnqueuePosition{};
+    alignas(64) std::atomic<uint64_t> mWrittenPosition{};
+    alignas(64) std::atomic<uint32_t> mPublishedNumber{};
+    std::atomic<size_t> mDroppedNumber{};
+    std::atomic<logger::OverflowPolicy> mOverflowPolicy{logger::OverflowPolicy::BLOCK};
+    // Only used by the writer
+    uint64_t mPublishedPosition{};
+    std::thread mWriter;
+};
+
+AsyncLogger& getAsyncLogger()
+{
+    static auto* const pAsyncLogger = new AsyncLogger;
+    return *pAsyncLogger;
+}
 } // namespace
 
 namespace logger
@@ -80,18 +296,7 @@ void log(
     const char* functionName,
     int lineNumber)
 {
-    std::lock_guard<std::mutex> _{loggerMutex};
-
-    std::cout
-        << colorToString(Color::GREEN)
-        << "[INFO][" + currentDateTimeToStr()
-#ifndef NDEBUG
-        << debugInfo(fileName, functionName, lineNumber)
-#endif // !NDEBUG
-        + "]: "
-        << formatingEnd
-        << message
-        << "\n";
+    getAsyncLogger().push(Level::INFO, message, fileName, functionName, lineNumber);
 }
 
 void warning(
@@ -101,27 +306,14 @@ void warning(
     int lineNumber,
     bool debugBreak)
 {
-    std::lock_guard<std::mutex> _{loggerMutex};
-
-    std::cout
-        << colorToString(Color::YELLOW)
-        << "[WARNING][" + currentDateTimeToStr()
-#ifndef NDEBUG
-        << debugInfo(fileName, functionName, lineNumber)
-#endif // !NDEBUG
-        + "]: "
-        << formatingEnd
-        << message
-        << "\n";
+    getAsyncLogger().push(Level::WARNING, message, fileName, functionName, lineNumber);
 
 #ifndef NDEBUG
     if (debugBreak)
     {
-#ifdef _WIN32
-        DebugBreak();
-#else
-#error not implemented
-#endif // _WIN32
+        // The debugger shows the warning already written
+        getAsyncLogger().flush();
+        ts::debugBreak();
     }
 #endif // !NDEBUG
 }
@@ -134,28 +326,15 @@ void error(
     bool throwException,
     bool debugBreak)
 {
-    std::lock_guard<std::mutex> _{loggerMutex};
+    // Error can end the program, so it isn't left in the queue
+    getAsyncLogger().push(Level::ERR, message, fileName, functionName, lineNumber);
+    getAsyncLogger().flush();
 
-    std::cerr
-        << colorToString(Color::RED)
-        << "[ERROR][" << currentDateTimeToStr()
 #ifndef NDEBUG
-        << debugInfo(fileName, functionName, lineNumber)
-#endif // !NDEBUG
-        << "]: "
-        << formatingEnd
-        << message
-        << "\n";
-
-#ifndef NDEBUG
-if (debugBreak)
-{
-#ifdef _WIN32
-    DebugBreak();
-#else
-#error not implemented
-#endif // _WIN32
-}
+    if (debugBreak)
+    {
+        ts::debugBreak();
+    }
 #endif // !NDEBUG
 
     if (throwException)
@@ -163,6 +342,16 @@ if (debugBreak)
         throw Exception{};
     }
 }
+
+void setOverflowPolicy(const OverflowPolicy policy)
+{
+    getAsyncLogger().setOverflowPolicy(policy);
+}
+
+void flush()
+{
+    getAsyncLogger().flush();
+}
 } // namespace logger
 } // namespace ver
-} // namespace ts
\ No newline at end of file
+} // namespace ts
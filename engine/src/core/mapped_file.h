@@ -0,0 +1,30 @@
+#pragma once
+
+#include "internal_utils.h"
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Read-only mapping of a whole file, implemented by the os layer
+class MappedFile final
+{
+    TS_NOT_COPYABLE_AND_MOVEABLE(MappedFile);
+
+public:
+    MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    [[nodiscard]] const std::byte* getData() const { return mpData; }
+    [[nodiscard]] size_t getSize() const { return mSize; }
+
+private:
+    void* mpFile{};
+    void* mpMapping{};
+    const std::byte* mpData{};
+    size_t mSize{};
+
+    void unmap();
+};
+} // namespace ver
+} // namespace ts
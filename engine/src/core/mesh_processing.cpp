@@ -0,0 +1,783 @@
+#include "mesh_processing.h"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <span>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+namespace
+{
+struct WeldKeyHash
+{
+    size_t operator()(const MeshComponent::Vertex& vertex) const
+    {
+        size_t seed{};
+        for (const auto value : {
+            vertex.position.x, vertex.position.y, vertex.position.z,
+            vertex.normal.x, vertex.normal.y, vertex.normal.z})
+        {
+            // Adding zero turns -0.f into 0.f, they have to land in the same bucket as they are equal
+            seed ^= std::hash<float>{}(value + 0.f) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+
+        return seed;
+    }
+};
+
+struct WeldKeyEqual
+{
+    bool operator()(const MeshComponent::Vertex& lhs, const MeshComponent::Vertex& rhs) const
+    {
+        return (lhs.position == rhs.position) && (lhs.normal == rhs.normal);
+    }
+};
+
+struct PositionHash
+{
+    size_t operator()(const math::Vec3& position) const
+    {
+        size_t seed{};
+        for (const auto value : {position.x, position.y, position.z})
+        {
+            seed ^= std::hash<float>{}(value + 0.f) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+
+        return seed;
+    }
+};
+
+constexpr auto noCollapse = std::numeric_limits<uint32_t>::max();
+
+// Sum of the squared distances from the planes, weighted by the areas of their triangles
+struct Quadric
+{
+    // Upper triangle of the symmetric matrix
+    std::array<double, 10> elements{};
+    double weight{};
+
+    void addPlane(const std::array<double, 4>& plane, const double planeWeight)
+    {
+        const auto& [a, b, c, d] = plane;
+        const std::array products{a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+        for (size_t i{}; i < elements.size(); ++i)
+        {
+            elements[i] += products[i] * planeWeight;
+        }
+        weight += planeWeight;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for (size_t i{}; i < elements.size(); ++i)
+        {
+            elements[i] += other.elements[i];
+        }
+        weight += other.weight;
+
+        return *this;
+    }
+
+    // Mean of the squared distances
+    double getError(const math::Vec3& point) const
+    {
+        if (weight <= 0.)
+        {
+            return 0.;
+        }
+
+        const double x{point.x}, y{point.y}, z{point.z};
+        const auto& [aa, ab, ac, ad, bb, bc, bd, cc, cd, dd] = elements;
+        const auto error = (aa * x * x) + (2. * ab * x * y) + (2. * ac * x * z) + (2. * ad * x) +
+            (bb * y * y) + (2. * bc * y * z) + (2. * bd * y) +
+            (cc * z * z) + (2. * cd * z) +
+            dd;
+
+        return std::max(error / weight, 0.);
+    }
+};
+
+std::array<double, 3> getTriangleNormal(const math::Vec3& p0, const math::Vec3& p1, const math::Vec3& p2)
+{
+    const std::array<double, 3> e1{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+    const std::array<double, 3> e2{p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+    return {
+        (e1[1] * e2[2]) - (e1[2] * e2[1]),
+        (e1[2] * e2[0]) - (e1[0] * e2[2]),
+        (e1[0] * e2[1]) - (e1[1] * e2[0])};
+}
+
+// Forsyth's scoring constants, the cache is a LRU larger than the hardware one
+constexpr size_t maxCacheSize{32};
+constexpr float cacheDecayPower{1.5f};
+constexpr float lastTriangleScore{0.75f};
+constexpr float valenceBoostScale{2.f};
+constexpr float valenceBoostPower{0.5f};
+
+constexpr auto notInCache = std::numeric_limits<uint32_t>::max();
+
+float vertexScore(const uint32_t cachePosition, const uint32_t activeTrianglesCount)
+{
+    if (activeTrianglesCount == 0)
+    {
+        return -1.f;
+    }
+
+    float score{};
+    if (cachePosition != notInCache)
+    {
+        if (cachePosition < 3)
+        {
+            // The vertices of the last triangle get a fixed score, so they aren't reused too eagerly
+            score = lastTriangleScore;
+        }
+        else
+        {
+            const auto scaler = 1.f / (maxCacheSize - 3);
+            score = std::pow(1.f - static_cast<float>(cachePosition - 3) * scaler, cacheDecayPower);
+        }
+    }
+
+    // Vertices with only a few triangles left are prioritized to get rid of them
+    score += valenceBoostScale * std::pow(static_cast<float>(activeTrianglesCount), -valenceBoostPower);
+
+    return score;
+}
+
+int16_t toSnorm16(const float value)
+{
+    return static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * std::numeric_limits<int16_t>::max()));
+}
+
+float fromSnorm16(const int16_t value)
+{
+    return std::max(static_cast<float>(value) / std::numeric_limits<int16_t>::max(), -1.f);
+}
+
+float signNotZero(const float value)
+{
+    return (value >= 0.f) ? 1.f : -1.f;
+}
+} // namespace
+
+void weldVertices(std::vector<MeshComponent::Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<MeshComponent::Vertex> uniqueVertices;
+    uniqueVertices.reserve(vertices.size());
+
+    std::unordered_map<MeshComponent::Vertex, uint32_t, WeldKeyHash, WeldKeyEqual> uniqueVertexIndices;
+    uniqueVertexIndices.reserve(vertices.size());
+
+    std::vector<uint32_t> remap(vertices.size());
+    for (size_t i{}; i < vertices.size(); ++i)
+    {
+        const auto [it, isInserted] = uniqueVertexIndices.try_emplace(vertices[i], static_cast<uint32_t>(uniqueVertices.size()));
+        if (isInserted)
+        {
+            uniqueVertices.emplace_back(vertices[i]);
+        }
+
+        remap[i] = it->second;
+    }
+
+    for (auto& index : indices)
+    {
+        index = remap[index];
+    }
+
+    uniqueVertices.shrink_to_fit();
+    vertices = std::move(uniqueVertices);
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, const size_t verticesCount)
+{
+    const auto trianglesCount = indices.size() / 3;
+    if (trianglesCount == 0)
+    {
+        return;
+    }
+
+    // Triangles adjacent to every vertex, the ones already emitted are swapped to the end of each range
+    std::vector<uint32_t> activeTrianglesCounts(verticesCount);
+    for (const auto index : indices)
+    {
+        activeTrianglesCounts[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(verticesCount + 1);
+    for (size_t vertex{}; vertex < verticesCount; ++vertex)
+    {
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + activeTrianglesCounts[vertex];
+    }
+
+    std::vector<uint32_t> adjacentTriangles(indices.size());
+    {
+        auto insertPositions = adjacencyOffsets;
+        for (size_t i{}; i < indices.size(); ++i)
+        {
+            adjacentTriangles[insertPositions[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<uint32_t> cachePositions(verticesCount, notInCache);
+    std::vector<float> vertexScores(verticesCount);
+    for (size_t vertex{}; vertex < verticesCount; ++vertex)
+    {
+        vertexScores[vertex] = vertexScore(notInCache, activeTrianglesCounts[vertex]);
+    }
+
+    std::vector<float> triangleScores(trianglesCount);
+    std::vector<bool> isTriangleEmitted(trianglesCount);
+    for (size_t triangle{}; triangle < trianglesCount; ++triangle)
+    {
+        triangleScores[triangle] =
+            vertexScores[indices[3 * triangle]] + vertexScores[indices[3 * triangle + 1]] + vertexScores[indices[3 * triangle + 2]];
+    }
+
+    std::vector<uint32_t> optimizedIndices;
+    optimizedIndices.reserve(indices.size());
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(maxCacheSize + 3);
+    nextCache.reserve(maxCacheSize + 3);
+
+    size_t nextUnemittedTriangle{};
+    auto bestTriangle = static_cast<uint32_t>(std::distance(triangleScores.begin(), std::ranges::max_element(triangleScores)));
+    while (true)
+    {
+        if (bestTriangle == notInCache)
+        {
+            // Nothing in the cache has any triangles left, so continue with the next one in the original order
+            while ((nextUnemittedTriangle < trianglesCount) && isTriangleEmitted[nextUnemittedTriangle])
+            {
+                nextUnemittedTriangle++;
+            }
+
+            if (nextUnemittedTriangle == trianglesCount)
+            {
+                break;
+            }
+
+            bestTriangle = static_cast<uint32_t>(nextUnemittedTriangle);
+        }
+
+        isTriangleEmitted[bestTriangle] = true;
+
+        nextCache.clear();
+        for (size_t corner{}; corner < 3; ++corner)
+        {
+            const auto vertex = indices[3 * bestTriangle + corner];
+            optimizedIndices.emplace_back(vertex);
+            if (std::ranges::find(nextCache, vertex) == nextCache.end())
+            {
+                nextCache.emplace_back(vertex);
+            }
+
+            auto adjacencyEnd = adjacencyOffsets[vertex] + activeTrianglesCounts[vertex];
+            for (auto i = adjacencyOffsets[vertex]; i < adjacencyEnd; ++i)
+            {
+                if (adjacentTriangles[i] == bestTriangle)
+                {
+                    std::swap(adjacentTriangles[i], adjacentTriangles[adjacencyEnd - 1]);
+                    activeTrianglesCounts[vertex]--;
+                    break;
+                }
+            }
+        }
+
+        for (const auto vertex : cache)
+        {
+            if (std::ranges::find(nextCache, vertex) == nextCache.end())
+            {
+                nextCache.emplace_back(vertex);
+            }
+        }
+
+        // Vertices pushed out of the cache are scored once more, as they aren't in the cache anymore
+        for (size_t position{}; position < nextCache.size(); ++position)
+        {
+            cachePositions[nextCache[position]] = (position < maxCacheSize) ? static_cast<uint32_t>(position) : notInCache;
+        }
+
+        bestTriangle = notInCache;
+        float bestScore{-1.f};
+        for (const auto vertex : nextCache)
+        {
+            const auto newScore = vertexScore(cachePositions[vertex], activeTrianglesCounts[vertex]);
+            const auto scoreDelta = newScore - vertexScores[vertex];
+            vertexScores[vertex] = newScore;
+
+            const auto adjacencyBegin = adjacencyOffsets[vertex];
+            for (auto i = adjacencyBegin; i < adjacencyBegin + activeTrianglesCounts[vertex]; ++i)
+            {
+                const auto triangle = adjacentTriangles[i];
+                triangleScores[triangle] += scoreDelta;
+                if (triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        if (nextCache.size() > maxCacheSize)
+        {
+            nextCache.resize(maxCacheSize);
+        }
+        std::swap(cache, nextCache);
+    }
+
+    indices = std::move(optimizedIndices);
+}
+
+void optimizeVertexFetch(std::vector<MeshComponent::Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), notInCache);
+    std::vector<MeshComponent::Vertex> orderedVertices;
+    orderedVertices.reserve(vertices.size());
+
+    for (auto& index : indices)
+    {
+        if (remap[index] == notInCache)
+        {
+            remap[index] = static_cast<uint32_t>(orderedVertices.size());
+            orderedVertices.emplace_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices = std::move(orderedVertices);
+}
+
+float simplifyMesh(const std::vector<MeshComponent::Vertex>& vertices, std::vector<uint32_t>& indices, const size_t targetIndicesCount)
+{
+    // Vertices at the same position are one vertex of the topology, the other ones are its wedges
+    std::vector<math::Vec3> positions;
+    std::vector<uint32_t> positionPerVertex(vertices.size());
+    {
+        std::unordered_map<math::Vec3, uint32_t, PositionHash> positionIndices;
+        positionIndices.reserve(vertices.size());
+        for (size_t vertex{}; vertex < vertices.size(); ++vertex)
+        {
+            const auto [it, isInserted] = positionIndices.try_emplace(vertices[vertex].position, static_cast<uint32_t>(positions.size()));
+            if (isInserted)
+            {
+                positions.emplace_back(vertices[vertex].position);
+            }
+            positionPerVertex[vertex] = it->second;
+        }
+    }
+
+    std::vector<uint32_t> wedgeOffsets(positions.size() + 1);
+    for (const auto position : positionPerVertex)
+    {
+        wedgeOffsets[position + 1]++;
+    }
+    std::partial_sum(wedgeOffsets.begin(), wedgeOffsets.end(), wedgeOffsets.begin());
+    std::vector<uint32_t> wedges(vertices.size());
+    {
+        auto insertPositions = wedgeOffsets;
+        for (uint32_t vertex{}; vertex < vertices.size(); ++vertex)
+        {
+            wedges[insertPositions[positionPerVertex[vertex]]++] = vertex;
+        }
+    }
+
+    const auto getCornerPositions = [&](const size_t triangle) {
+        return std::array{
+            positionPerVertex[indices[3 * triangle]],
+            positionPerVertex[indices[3 * triangle + 1]],
+            positionPerVertex[indices[3 * triangle + 2]]};
+    };
+
+    // Edges of only one triangle are on an open border
+    std::vector<uint8_t> isLocked(positions.size());
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeUsesCounts;
+        for (size_t triangle{}; triangle < indices.size() / 3; ++triangle)
+        {
+            const auto corners = getCornerPositions(triangle);
+            for (size_t edge{}; edge < 3; ++edge)
+            {
+                const auto a = corners[edge];
+                const auto b = corners[(edge + 1) % 3];
+                edgeUsesCounts[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+            }
+        }
+
+        for (const auto& [edge, usesCount] : edgeUsesCounts)
+        {
+            if (usesCount == 1)
+            {
+                isLocked[edge >> 32] = true;
+                isLocked[edge & std::numeric_limits<uint32_t>::max()] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(positions.size());
+    for (size_t triangle{}; triangle < indices.size() / 3; ++triangle)
+    {
+        const auto corners = getCornerPositions(triangle);
+        const auto& p0 = positions[corners[0]];
+        auto normal = getTriangleNormal(p0, positions[corners[1]], positions[corners[2]]);
+        const auto length = std::sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+        if (length == 0.)
+        {
+            continue;
+        }
+
+        for (auto& value : normal)
+        {
+            value /= length;
+        }
+        const std::array plane{normal[0], normal[1], normal[2], -((normal[0] * p0.x) + (normal[1] * p0.y) + (normal[2] * p0.z))};
+        for (const auto corner : corners)
+        {
+            quadrics[corner].addPlane(plane, length / 2.);
+        }
+    }
+
+    struct Collapse
+    {
+        double error;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // Every pass collapses the cheapest edges whose vertices and neighbourhoods aren't changed by any other one,
+    // so the flips are checked against the final positions
+    double maxError{};
+    std::vector<uint32_t> adjacencyOffsets, adjacentTriangles;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTargets(positions.size(), noCollapse);
+    std::vector<uint8_t> isTouched(positions.size());
+    std::vector<uint32_t> neighbourStamps(positions.size());
+    uint32_t neighbourStamp{};
+    while (indices.size() > targetIndicesCount)
+    {
+        const auto trianglesCount = indices.size() / 3;
+
+        adjacencyOffsets.assign(positions.size() + 1, 0);
+        for (const auto index : indices)
+        {
+            adjacencyOffsets[positionPerVertex[index] + 1]++;
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacentTriangles.resize(indices.size());
+        {
+            auto insertPositions = adjacencyOffsets;
+            for (size_t i{}; i < indices.size(); ++i)
+            {
+                adjacentTriangles[insertPositions[positionPerVertex[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        collapses.clear();
+        for (size_t triangle{}; triangle < trianglesCount; ++triangle)
+        {
+            const auto corners = getCornerPositions(triangle);
+            for (size_t edge{}; edge < 3; ++edge)
+            {
+                const auto a = corners[edge];
+                const auto b = corners[(edge + 1) % 3];
+                for (const auto& [from, to] : {std::pair{a, b}, std::pair{b, a}})
+                {
+                    if (isLocked[from] == 0)
+                    {
+                        auto merged = quadrics[from];
+                        merged += quadrics[to];
+                        collapses.push_back({merged.getError(positions[to]), from, to});
+                    }
+                }
+            }
+        }
+        std::ranges::sort(collapses, {}, &Collapse::error);
+
+        const auto trianglesToRemove = trianglesCount - (targetIndicesCount / 3);
+        size_t removedTrianglesCount{};
+        std::ranges::fill(isTouched, 0);
+        for (const auto& [error, from, to] : collapses)
+        {
+            if (removedTrianglesCount >= trianglesToRemove)
+            {
+                break;
+            }
+
+            if ((isTouched[from] != 0) || (isTouched[to] != 0))
+            {
+                continue;
+            }
+
+            // Triangles which keep their area mustn't turn over
+            auto isFlipped = false;
+            size_t collapsedTrianglesCount{};
+            for (auto i = adjacencyOffsets[from]; (i < adjacencyOffsets[from + 1]) && !isFlipped; ++i)
+            {
+                const auto corners = getCornerPositions(adjacentTriangles[i]);
+                if (std::ranges::find(corners, to) != corners.end())
+                {
+                    collapsedTrianglesCount++;
+                    continue;
+                }
+
+                std::array<math::Vec3, 3> moved;
+                for (size_t corner{}; corner < 3; ++corner)
+                {
+                    moved[corner] = positions[(corners[corner] == from) ? to : corners[corner]];
+                }
+                const auto before = getTriangleNormal(positions[corners[0]], positions[corners[1]], positions[corners[2]]);
+                const auto after = getTriangleNormal(moved[0], moved[1], moved[2]);
+                isFlipped = ((before[0] * after[0]) + (before[1] * after[1]) + (before[2] * after[2])) <= 0.;
+            }
+
+            if (isFlipped)
+            {
+                continue;
+            }
+
+            // Vertices adjacent to both of them have to be the opposite corners of the collapsed triangles,
+            // any other one would be left with its edges pinched together
+            ++neighbourStamp;
+            for (auto i = adjacencyOffsets[to]; i < adjacencyOffsets[to + 1]; ++i)
+            {
+                for (const auto corner : getCornerPositions(adjacentTriangles[i]))
+                {
+                    neighbourStamps[corner] = neighbourStamp;
+                }
+            }
+
+            size_t sharedNeighboursCount{};
+            for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; ++i)
+            {
+                for (const auto corner : getCornerPositions(adjacentTriangles[i]))
+                {
+                    if ((corner != from) && (corner != to) && (neighbourStamps[corner] == neighbourStamp))
+                    {
+                        sharedNeighboursCount++;
+                        neighbourStamps[corner] = 0;
+                    }
+                }
+            }
+
+            if (sharedNeighboursCount != collapsedTrianglesCount)
+            {
+                continue;
+            }
+
+            collapseTargets[from] = to;
+            quadrics[to] += quadrics[from];
+            maxError = std::max(maxError, error);
+            removedTrianglesCount += collapsedTrianglesCount;
+
+            for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; ++i)
+            {
+                for (const auto corner : getCornerPositions(adjacentTriangles[i]))
+                {
+                    isTouched[corner] = true;
+                }
+            }
+        }
+
+        if (removedTrianglesCount == 0)
+        {
+            break;
+        }
+
+        const auto getCollapsedVertex = [&](const uint32_t vertex) {
+            const auto target = collapseTargets[positionPerVertex[vertex]];
+            if (target == noCollapse)
+            {
+                return vertex;
+            }
+
+            const auto& normal = vertices[vertex].normal;
+            const auto getSimilarity = [&](const uint32_t wedge) {
+                const auto& wedgeNormal = vertices[wedge].normal;
+                return (normal.x * wedgeNormal.x) + (normal.y * wedgeNormal.y) + (normal.z * wedgeNormal.z);
+            };
+
+            return *std::ranges::max_element(
+                std::span{wedges}.subspan(wedgeOffsets[target], wedgeOffsets[target + 1] - wedgeOffsets[target]),
+                {},
+                getSimilarity);
+        };
+
+        std::vector<uint32_t> simplifiedIndices;
+        simplifiedIndices.reserve(indices.size());
+        for (size_t triangle{}; triangle < trianglesCount; ++triangle)
+        {
+            const std::array triangleVertices{
+                getCollapsedVertex(indices[3 * triangle]),
+                getCollapsedVertex(indices[3 * triangle + 1]),
+                getCollapsedVertex(indices[3 * triangle + 2])};
+            const auto p0 = positionPerVertex[triangleVertices[0]];
+            const auto p1 = positionPerVertex[triangleVertices[1]];
+            const auto p2 = positionPerVertex[triangleVertices[2]];
+            if ((p0 != p1) && (p1 != p2) && (p2 != p0))
+            {
+                simplifiedIndices.insert(simplifiedIndices.end(), triangleVertices.begin(), triangleVertices.end());
+            }
+        }
+        indices = std::move(simplifiedIndices);
+
+        std::ranges::fill(collapseTargets, noCollapse);
+    }
+
+    return static_cast<float>(std::sqrt(maxError));
+}
+
+std::vector<MeshLod> generateLods(
+    const std::vector<MeshComponent::Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    const size_t maxLodsCount)
+{
+    // Levels removing only a few triangles aren't worth their indices
+    constexpr size_t minRemovedPercent{25};
+
+    std::vector<MeshLod> lods;
+    auto lodIndices = indices;
+    float error{};
+    while (lods.size() < maxLodsCount)
+    {
+        const auto previousIndicesCount = lodIndices.size();
+
+        // Errors are measured against the previous level, so their sum bounds the distance from the base one
+        error += simplifyMesh(vertices, lodIndices, (previousIndicesCount / 6) * 3);
+        if (lodIndices.empty() || ((lodIndices.size() * 100) > (previousIndicesCount * (100 - minRemovedPercent))))
+        {
+            break;
+        }
+
+        auto& lod = lods.emplace_back(MeshLod{lodIndices, error});
+        optimizeVertexCache(lod.indices, vertices.size());
+    }
+
+    return lods;
+}
+
+std::array<int16_t, 2> encodeOctahedral(const math::Vec3& normal)
+{
+    const auto length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.f)
+    {
+        return {};
+    }
+
+    auto x = normal.x / length;
+    auto y = normal.y / length;
+    if (normal.z < 0.f)
+    {
+        // The lower hemisphere is folded over the diagonals
+        const auto foldedX = (1.f - std::abs(y)) * signNotZero(x);
+        y = (1.f - std::abs(x)) * signNotZero(y);
+        x = foldedX;
+    }
+
+    return {toSnorm16(x), toSnorm16(y)};
+}
+
+math::Vec3 decodeOctahedral(const std::array<int16_t, 2>& encoded)
+{
+    math::Vec3 normal{fromSnorm16(encoded[0]), fromSnorm16(encoded[1]), 0.f};
+    normal.z = 1.f - std::abs(normal.x) - std::abs(normal.y);
+
+    const auto t = std::max(-normal.z, 0.f);
+    normal.x += (normal.x >= 0.f) ? -t : t;
+    normal.y += (normal.y >= 0.f) ? -t : t;
+
+    return math::normalize(normal);
+}
+
+Bounds computeBounds(const std::vector<MeshComponent::Vertex>& vertices)
+{
+    if (vertices.empty())
+    {
+        return {};
+    }
+
+    math::Vec3 min{std::numeric_limits<float>::max()};
+    math::Vec3 max{std::numeric_limits<float>::lowest()};
+    for (const auto& vertex : vertices)
+    {
+        min = {std::min(min.x, vertex.position.x), std::min(min.y, vertex.position.y), std::min(min.z, vertex.position.z)};
+        max = {std::max(max.x, vertex.position.x), std::max(max.y, vertex.position.y), std::max(max.z, vertex.position.z)};
+    }
+
+    return {min, max};
+}
+
+PackedVertices packVertices(const std::vector<MeshComponent::Vertex>& vertices)
+{
+    PackedVertices packedVertices;
+    if (vertices.empty())
+    {
+        packedVertices.positionScale = math::Vec3{1.f};
+        return packedVertices;
+    }
+
+    const auto [min, max] = computeBounds(vertices);
+
+    // Flat axes get any non zero scale, they're dequantized to the bias anyway
+    const auto halfExtent = [](const float minValue, const float maxValue) {
+        return (maxValue > minValue) ? (maxValue - minValue) / 2.f : 1.f;
+    };
+    packedVertices.positionScale = {halfExtent(min.x, max.x), halfExtent(min.y, max.y), halfExtent(min.z, max.z)};
+    packedVertices.positionBias = {(min.x + max.x) / 2.f, (min.y + max.y) / 2.f, (min.z + max.z) / 2.f};
+
+    const auto& scale = packedVertices.positionScale;
+    const auto& bias = packedVertices.positionBias;
+    packedVertices.vertices.reserve(vertices.size());
+    for (const auto& vertex : vertices)
+    {
+        packedVertices.vertices.push_back({
+            .position = {
+                toSnorm16((vertex.position.x - bias.x) / scale.x),
+                toSnorm16((vertex.position.y - bias.y) / scale.y),
+                toSnorm16((vertex.position.z - bias.z) / scale.z),
+                0
+            },
+            .normal = encodeOctahedral(vertex.normal),
+        });
+    }
+
+    return packedVertices;
+}
+
+VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, const size_t verticesCount, const size_t cacheSize)
+{
+    if (indices.empty())
+    {
+        return {};
+    }
+
+    // Every vertex remembers the miss which put it into the cache, it's evicted after cacheSize more misses
+    std::vector<size_t> missTimestamps(verticesCount);
+    std::vector<bool> isVertexUsed(verticesCount);
+    size_t missesCount{}, uniqueVerticesCount{};
+    for (const auto index : indices)
+    {
+        if (!isVertexUsed[index])
+        {
+            isVertexUsed[index] = true;
+            uniqueVerticesCount++;
+        }
+
+        if ((missTimestamps[index] == 0) || (missesCount - missTimestamps[index] >= cacheSize))
+        {
+            missesCount++;
+            missTimestamps[index] = missesCount;
+        }
+    }
+
+    return {
+        .acmr = static_cast<float>(missesCount) / static_cast<float>(indices.size() / 3),
+        .atvr = static_cast<float>(missesCount) / static_cast<float>(uniqueVerticesCount),
+    };
+}
+} // namespace ver
+} // namespace ts
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "tsengine/ecs/ecs.h"
+#include "tsengine/ecs/components/mesh_component.hpp"
+
+#include "shaders/vertex_format.h"
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Vertex layout uploaded to the vertex buffer
+#if PACKED_VERTICES
+using GpuVertex = MeshComponent::PackedVertex;
+#else
+using GpuVertex = MeshComponent::Vertex;
+#endif // PACKED_VERTICES
+
+struct PackedVertices
+{
+    std::vector<MeshComponent::PackedVertex> vertices;
+    math::Vec3 positionScale;
+    math::Vec3 positionBias;
+};
+
+struct Bounds
+{
+    math::Vec3 min;
+    math::Vec3 max;
+};
+
+struct MeshLod
+{
+    std::vector<uint32_t> indices;
+    // Distance from the base surface, in the units of the positions
+    float error;
+};
+
+struct VertexCacheStatistics
+{
+    // Average cache miss ratio, transformed vertices per triangle
+    float acmr;
+    // Average transform to vertex ratio, transformed vertices per unique vertex
+    float atvr;
+};
+
+// Merges the vertices with the same position and normal, indices are remapped to the unique vertices
+void weldVertices(std::vector<MeshComponent::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<uint32_t>& indices, const size_t verticesCount);
+
+// Reorders vertices in the order of the first use by the indices, unreferenced vertices are dropped
+void optimizeVertexFetch(std::vector<MeshComponent::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+std::array<int16_t, 2> encodeOctahedral(const math::Vec3& normal);
+math::Vec3 decodeOctahedral(const std::array<int16_t, 2>& encoded);
+
+// Axis aligned box of the positions, empty vertices give a box at the origin
+Bounds computeBounds(const std::vector<MeshComponent::Vertex>& vertices);
+
+// Positions are quantized into the bounding box of the mesh
+PackedVertices packVertices(const std::vector<MeshComponent::Vertex>& vertices);
+
+// Collapses the edges of the lowest quadric error, every vertex onto one of its neighbours, until the indices shrink to
+// the target. Vertices on open borders aren't moved, so no holes appear. Vertices are shared with the source, a collapsed
+// one is replaced by the vertex at the target position with the closest normal. Returns the largest error of the
+// collapses, the root mean square distance from the planes of the merged triangles.
+float simplifyMesh(const std::vector<MeshComponent::Vertex>& vertices, std::vector<uint32_t>& indices, const size_t targetIndicesCount);
+
+// Every level is simplified from the previous one to half of its triangles, the generation stops at the level which
+// can't be simplified enough. Indices of the levels are optimized for the vertex cache.
+std::vector<MeshLod> generateLods(
+    const std::vector<MeshComponent::Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    const size_t maxLodsCount);
+
+// Simulates a FIFO post-transform cache
+VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, const size_t verticesCount, const size_t cacheSize = 16);
+} // namespace ver
+} // namespace ts
@@ -12,7 +12,10 @@
 #include "khronos_utils.h"
 #include "headset.h"
 #include "render_target.h"
+#include "cooked_mesh.h"
+#include "frustum_culling.h"
 #include "tsengine/asset_store.h"
+#include "tsengine/job_system.h"
 
 #include "tsengine/ecs/components/renderer_component.hpp"
 #include "tsengine/ecs/components/mesh_component.hpp"
@@ -22,6 +25,31 @@ namespace ts
 {
 inline namespace TS_VER
 {
+namespace
+{
+VkFormat getVertexAttributeFormat(const cooked_mesh::VertexAttribute& attribute)
+{
+    using enum cooked_mesh::ComponentType;
+
+    static constexpr std::array float32Formats{
+        VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+    static constexpr std::array snorm16Formats{
+        VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16B16_SNORM, VK_FORMAT_R16G16B16A16_SNORM};
+
+    switch (attribute.componentType)
+    {
+    case FLOAT32:
+        return float32Formats.at(attribute.componentsCount - 1);
+    case SNORM16:
+        return snorm16Formats.at(attribute.componentsCount - 1);
+    default:
+        TS_ERR("Unsupported vertex attribute component type");
+    }
+
+    return VK_FORMAT_UNDEFINED;
+}
+} // namespace
+
 Renderer::Renderer(const Context& ctx, const Headset& headset) : mCtx{ctx}, mHeadset{headset}
 {}
 
@@ -75,8 +103,8 @@ void Renderer::createRenderer()
 
     const std::array descriptorPoolSizes{
         VkDescriptorPoolSize{
-            .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-            .descriptorCount = static_cast<uint32_t>(framesInFlightCount),
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = static_cast<uint32_t>(framesInFlightCount * 2),
         },
         VkDescriptorPoolSize{
             .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
@@ -95,9 +123,9 @@ void Renderer::createRenderer()
     const std::array descriptorSetLayoutBindings{
         VkDescriptorSetLayoutBinding{
             .binding = 0,
-            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
             .descriptorCount = 1,
-            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
         },
         VkDescriptorSetLayoutBinding{
             .binding = 1,
@@ -111,6 +139,12 @@ void Renderer::createRenderer()
             .descriptorCount = 1,
             .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
         },
+        VkDescriptorSetLayoutBinding{
+            .binding = 3,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        },
     };
 
     std::vector<VkPushConstantRange> pushConstantRanges;
@@ -119,11 +153,6 @@ void Renderer::createRenderer()
         .offset = 0,
         .size = sizeof(math::Vec3)
     });
-    pushConstantRanges.emplace_back<VkPushConstantRange>({
-        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-        .offset = pushConstantRanges.at(0).size,
-        .size = sizeof(RendererComponent<PipelineType::PBR>::Material)
-    });
 
     const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
@@ -149,7 +178,9 @@ void Renderer::createRenderer()
             mDescriptorPool,
             mDescriptorSetLayout,
             gReg.getSystem<AssetStore>().getSystemEntities().size(),
-            gReg.getSystem<RenderSystem::Lights>().getSystemEntities().size());
+            gReg.getSystem<RenderSystem::Lights>().getSystemEntities().size(),
+            gReg.getSystem<RenderSystem>().getSystemEntities().size(),
+            getJobSystem().getThreadsNumber());
     }
 
     mGridPipeline = std::make_shared<Pipeline>(mCtx);
@@ -166,32 +197,26 @@ void Renderer::createRenderer()
         "assets/shaders/light_cube.vert.spirv",
         "assets/shaders/light_cube.frag.spirv");
 
+    const auto vertexLayout = cooked_mesh::getVertexLayout();
+
     const VkVertexInputBindingDescription vertexInputBindingDescription{
         .binding = 0,
-        .stride = sizeof(MeshComponent::Vertex),
+        .stride = vertexLayout.stride,
         .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
     };
 
-    const VkVertexInputAttributeDescription vertexInputAttributePosition{
-        .location = 0,
-        .binding = 0,
-        .format = VK_FORMAT_R32G32B32_SFLOAT,
-        .offset = offsetof(MeshComponent::Vertex, position)
-    };
-
-    const VkVertexInputAttributeDescription vertexInputAttributeNormal{
-        .location = 1,
-        .binding = 0,
-        .format = VK_FORMAT_R32G32B32_SFLOAT,
-        .offset = offsetof(MeshComponent::Vertex, normal),
-    };
-
-    const VkVertexInputAttributeDescription vertexInputAttributeColor{
-        .location = 2,
-        .binding = 0,
-        .format = VK_FORMAT_R32G32B32_SFLOAT,
-        .offset = offsetof(MeshComponent::Vertex, color),
-    };
+    // Position and normal come first in every vertex layout
+    std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
+    for (uint32_t location{}; location < vertexLayout.attributesCount; ++location)
+    {
+        const auto& attribute = vertexLayout.attributes.at(location);
+        vertexInputAttributeDescriptions.push_back({
+            .location = location,
+            .binding = 0,
+            .format = getVertexAttributeFormat(attribute),
+            .offset = attribute.offset,
+        });
+    }
 
     mNormalLightingPipeline = std::make_shared<Pipeline>(mCtx);
     mNormalLightingPipeline->createPipeline(
@@ -200,7 +225,7 @@ void Renderer::createRenderer()
         "assets/shaders/normal_lighting.vert.spirv",
         "assets/shaders/normal_lighting.frag.spirv",
         {vertexInputBindingDescription},
-        {vertexInputAttributePosition, vertexInputAttributeNormal});
+        {vertexInputAttributeDescriptions.at(0), vertexInputAttributeDescriptions.at(1)});
 
     mPbrPipeline = std::make_shared<Pipeline>(mCtx);
     mPbrPipeline->createPipeline(
@@ -209,7 +234,7 @@ void Renderer::createRenderer()
         "assets/shaders/pbr.vert.spirv",
         "assets/shaders/pbr.frag.spirv",
         {vertexInputBindingDescription},
-        {vertexInputAttributePosition, vertexInputAttributeNormal, vertexInputAttributeColor});
+        vertexInputAttributeDescriptions);
 
     createVertexIndexBuffer();
 
@@ -231,6 +256,30 @@ void Renderer::render(const size_t swapchainImageIndex)
     const VkCommandBufferBeginInfo commandBufferBeginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
     TS_VK_CHECK(vkBeginCommandBuffer, commandBuffer, &commandBufferBeginInfo);
 
+    // Shaders move the world by the camera position before the eye view, the frustum has to include it too
+    const auto cameraPos = gReg.getEntityByTag("player").getComponent<TransformComponent>().getWorldPosition();
+    const auto cameraMat = math::translate(math::Mat4{1.f}, cameraPos);
+    std::array<math::Mat4, 2> eyeViewProjs;
+    std::array<math::Vec3, 2> eyePositions;
+    LodSelection lodSelection{};
+    const auto eyeCount = std::min(mHeadset.getEyeCount(), eyeViewProjs.size());
+    for (size_t eyeIndex{}; eyeIndex < eyeCount; ++eyeIndex)
+    {
+        const auto viewMat = mHeadset.getEyeViewMatrix(eyeIndex);
+        const auto projMat = mHeadset.getEyeProjectionMatrix(eyeIndex);
+        eyeViewProjs[eyeIndex] = projMat * viewMat * cameraMat;
+
+        const auto eyePosition = math::inverse(viewMat)[3];
+        eyePositions[eyeIndex] = {eyePosition.x - cameraPos.x, eyePosition.y - cameraPos.y, eyePosition.z - cameraPos.z};
+
+        // Vertical focal length in pixels, the sharper eye decides
+        const auto eyeResolution = mHeadset.getEyeResolution(static_cast<int32_t>(eyeIndex));
+        lodSelection.pixelsPerUnit = std::max(
+            lodSelection.pixelsPerUnit, (static_cast<float>(eyeResolution.height) / 2.f) * std::abs(projMat.data[1].y));
+    }
+    lodSelection.eyePositions = std::span{eyePositions.data(), eyeCount};
+
+    gReg.getSystem<RenderSystem>().prepareDraws(frustum::makeConservative(std::span{eyeViewProjs.data(), eyeCount}), lodSelection);
     updateUniformData(renderProcess);
 
     const std::array clearValues{
@@ -249,7 +298,7 @@ void Renderer::render(const size_t swapchainImageIndex)
         .pClearValues = clearValues.data()
     };
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
     const VkViewport viewport{
         .x = static_cast<float>(renderPassBeginInfo.renderArea.offset.x),
@@ -259,23 +308,54 @@ void Renderer::render(const size_t swapchainImageIndex)
         .minDepth = 0.f,
         .maxDepth = 1.f,
     };
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
     const VkRect2D scissor{
         .offset = renderPassBeginInfo.renderArea.offset,
         .extent = renderPassBeginInfo.renderArea.extent
     };
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-    VkDeviceSize vertexOffset{};
-    const auto buffer = mVertexIndexBuffer->getBuffer();
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &vertexOffset);
+    const VkCommandBufferInheritanceInfo commandBufferInheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = renderPassBeginInfo.renderPass,
+        .subpass = 0,
+        .framebuffer = renderPassBeginInfo.framebuffer,
+    };
 
-    vkCmdBindIndexBuffer(commandBuffer, buffer, mIndexOffset, VK_INDEX_TYPE_UINT32);
+    const VkCommandBufferBeginInfo secondaryCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &commandBufferInheritanceInfo,
+    };
 
+    const auto buffer = mVertexIndexBuffer->getBuffer();
     const auto descriptorSet = renderProcess->getDescriptorSet();
+    const auto indirectBuffer = renderProcess->getIndirectBuffer();
+    const auto indirectOffset = renderProcess->getIndirectCommandsOffset();
+
+    // Ranges of the draws are recorded by the workers, every one into the secondary command buffer from its own pool.
+    // Secondary command buffers don't inherit any state, so each of them sets it again.
+    auto& renderSystem = gReg.getSystem<RenderSystem>();
+    const auto rangesNumber = renderSystem.prepareRecording(renderProcess->getSecondaryCommandBuffers().size());
+    getJobSystem().parallelFor(0, rangesNumber, [&](const size_t rangeIndex) {
+        const auto secondaryCommandBuffer = renderProcess->resetSecondaryCommandBuffer(rangeIndex);
+        TS_VK_CHECK(vkBeginCommandBuffer, secondaryCommandBuffer, &secondaryCommandBufferBeginInfo);
+
+        vkCmdSetViewport(secondaryCommandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(secondaryCommandBuffer, 0, 1, &scissor);
+
+        VkDeviceSize vertexOffset{};
+        vkCmdBindVertexBuffers(secondaryCommandBuffer, 0, 1, &buffer, &vertexOffset);
+        vkCmdBindIndexBuffer(secondaryCommandBuffer, buffer, mIndexOffset, VK_INDEX_TYPE_UINT32);
 
-    gReg.getSystem<RenderSystem>().update(commandBuffer, descriptorSet);
+        renderSystem.record(rangeIndex, secondaryCommandBuffer, descriptorSet, indirectBuffer, indirectOffset);
+
+        TS_VK_CHECK(vkEndCommandBuffer, secondaryCommandBuffer);
+    }, 1);
+
+    if (rangesNumber > 0)
+    {
+        vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(rangesNumber), renderProcess->getSecondaryCommandBuffers().data());
+    }
 
     vkCmdEndRenderPass(commandBuffer);
 }
@@ -319,6 +399,21 @@ VkCommandBuffer Renderer::getCurrentCommandBuffer() const
     return mRenderProcesses.at(mCurrentRenderProcessIndex)->getCommandBuffer();
 }
 
+size_t Renderer::getUploadedUniformBytesNumber() const
+{
+    return mRenderProcesses.at(mCurrentRenderProcessIndex)->getUploadedBytesNumber();
+}
+
+size_t Renderer::getVisibleEntitiesNumber() const
+{
+    return gReg.getSystem<RenderSystem>().getCullingStatistics().visible;
+}
+
+size_t Renderer::getCulledEntitiesNumber() const
+{
+    return gReg.getSystem<RenderSystem>().getCullingStatistics().culled;
+}
+
 void Renderer::createVertexIndexBuffer()
 {
     const auto bufferSize = static_cast<VkDeviceSize>(AssetStore::Models::getSize());
@@ -357,28 +452,104 @@ void Renderer::createVertexIndexBuffer()
 
 void Renderer::updateUniformData(const std::unique_ptr<RenderProcess>& renderProcess)
 {
-    const auto assets = gReg.getSystem<AssetStore>().getSystemEntities();
-    for (size_t modelIdx{}; modelIdx < assets.size(); ++modelIdx)
+    const auto& meshEntities = gReg.getSystem<RenderSystem>().getMeshEntities();
+    for (size_t modelIdx{}; modelIdx < meshEntities.size(); ++modelIdx)
     {
-        renderProcess->mIndividualUniformData.at(modelIdx).model = assets.at(modelIdx).getComponent<TransformComponent>().modelMat;
+        const auto& transform = meshEntities[modelIdx].getComponent<TransformComponent>();
+        const auto& mesh = meshEntities[modelIdx].getComponent<MeshComponent>();
+
+        auto& modelVersion = renderProcess->mModelVersions.at(modelIdx);
+        auto& individualData = renderProcess->mIndividualUniformData.at(modelIdx);
+        const math::Vec4 positionScale{mesh.positionScale.x, mesh.positionScale.y, mesh.positionScale.z, 0.f};
+        const math::Vec4 positionBias{mesh.positionBias.x, mesh.positionBias.y, mesh.positionBias.z, 0.f};
+
+        math::Vec4 materialColor{}, materialProperties{};
+        if (meshEntities[modelIdx].hasComponent<RendererComponent<PipelineType::PBR>>())
+        {
+            const auto& material = meshEntities[modelIdx].getComponent<RendererComponent<PipelineType::PBR>>().material;
+            materialColor = {material.color.x, material.color.y, material.color.z, 0.f};
+            materialProperties = {material.roughness, material.metallic, 0.f, 0.f};
+        }
+
+        if ((modelVersion != transform.getWorldVersion()) ||
+            (individualData.positionScale != positionScale) ||
+            (individualData.positionBias != positionBias) ||
+            (individualData.materialColor != materialColor) ||
+            (individualData.materialProperties != materialProperties))
+        {
+            individualData.model = transform.getWorldMat();
+            individualData.positionScale = positionScale;
+            individualData.positionBias = positionBias;
+            individualData.materialColor = materialColor;
+            individualData.materialProperties = materialProperties;
+            modelVersion = transform.getWorldVersion();
+            renderProcess->markIndividualDataDirty(modelIdx);
+        }
     }
 
-    const auto lights = gReg.getSystem<RenderSystem::Lights>().getSystemEntities();
-    for (size_t lightIdx{}; lightIdx < lights.size(); ++lightIdx)
+    auto& lightsData = renderProcess->mLightsUniformData;
+    size_t lightIdx{};
+    for (const auto [transform, light] : gReg.view<TransformComponent, RendererComponent<PipelineType::LIGHT>>())
     {
-        renderProcess->mLightsUniformData.positions.at(lightIdx) = lights.at(lightIdx).getComponent<TransformComponent>().pos;
+        const auto lightPos = transform.getWorldPosition();
+        if (lightsData.positions.at(lightIdx) != lightPos)
+        {
+            lightsData.positions.at(lightIdx) = lightPos;
+            renderProcess->markLightsDataDirty();
+        }
+        ++lightIdx;
+    }
+
+    auto& commonData = renderProcess->mCommonUniformData;
+    const auto cameraPos = gReg.getEntityByTag("player").getComponent<TransformComponent>().getWorldPosition();
+    if (commonData.cameraPosition != cameraPos)
+    {
+        commonData.cameraPosition = cameraPos;
+        renderProcess->markCommonDataDirty();
     }
 
-    const auto cameraPos = gReg.getEntityByTag("player").getComponent<TransformComponent>().pos;
-    renderProcess->mCommonUniformData.cameraPosition = cameraPos;
     for (size_t eyeIndex{}; eyeIndex < mHeadset.getEyeCount(); ++eyeIndex)
     {
-        renderProcess->mCommonUniformData.viewMats.at(eyeIndex) = mHeadset.getEyeViewMatrix(eyeIndex);
-        renderProcess->mCommonUniformData.projMats.at(eyeIndex) = mHeadset.getEyeProjectionMatrix(eyeIndex);
+        const auto viewMat = mHeadset.getEyeViewMatrix(eyeIndex);
+        const auto projMat = mHeadset.getEyeProjectionMatrix(eyeIndex);
+        if ((commonData.viewMats.at(eyeIndex) != viewMat) || (commonData.projMats.at(eyeIndex) != projMat))
+        {
+            commonData.viewMats.at(eyeIndex) = viewMat;
+            commonData.projMats.at(eyeIndex) = projMat;
+            renderProcess->markCommonDataDirty();
+        }
+    }
+
+    const auto& renderSystem = gReg.getSystem<RenderSystem>();
+    const auto& instanceObjects = renderSystem.getInstanceObjects();
+    auto& instanceObjectsData = renderProcess->mInstanceObjectsData;
+    if (instanceObjects.size() > instanceObjectsData.size())
+    {
+        TS_ERR("Draws exceed the capacity of the render process");
+    }
+
+    if (!std::equal(instanceObjects.begin(), instanceObjects.end(), instanceObjectsData.begin()))
+    {
+        std::ranges::copy(instanceObjects, instanceObjectsData.begin());
+        renderProcess->markInstanceObjectsDataDirty();
+    }
+
+    const auto& indirectCommands = renderSystem.getIndirectCommands();
+    auto& indirectCommandsData = renderProcess->mIndirectCommandsData;
+    if (indirectCommands.size() > indirectCommandsData.size())
+    {
+        TS_ERR("Indirect commands exceed the capacity of the render process");
+    }
+
+    if (!std::equal(indirectCommands.begin(), indirectCommands.end(), indirectCommandsData.begin()))
+    {
+        std::ranges::copy(indirectCommands, indirectCommandsData.begin());
+        renderProcess->markIndirectCommandsDataDirty();
     }
 
     renderProcess->updateUniformBufferData();
 }
+
 void Renderer::initRendererFrontend()
 {
     auto& renderSystem = gReg.getSystem<RenderSystem>();
@@ -388,6 +559,9 @@ void Renderer::initRendererFrontend()
     renderSystem.mpLightCubePipeline = mLightCubePipeline;
 
     renderSystem.mpPipelineLayout = mPipelineLayout;
+
+    renderSystem.mIsMultiDrawIndirectSupported = mCtx.isMultiDrawIndirectSupported();
+    renderSystem.mIsDrawIndirectFirstInstanceSupported = mCtx.isDrawIndirectFirstInstanceSupported();
 }
 } // namespace ver
 } // namespace ts
@@ -35,6 +35,11 @@ public:
     [[nodiscard]] VkSemaphore getCurrentDrawableSemaphore() const;
     [[nodiscard]] VkSemaphore getCurrentPresentableSemaphore() const;
     [[nodiscard]] VkCommandBuffer getCurrentCommandBuffer() const;
+    // Uniform data written in the current frame, only the changed parts are uploaded
+    [[nodiscard]] size_t getUploadedUniformBytesNumber() const;
+    // Entities drawn and skipped by the frustum culling in the current frame
+    [[nodiscard]] size_t getVisibleEntitiesNumber() const;
+    [[nodiscard]] size_t getCulledEntitiesNumber() const;
 
 private:
     void createVertexIndexBuffer();
@@ -45,6 +45,11 @@ RenderProcess::~RenderProcess()
         {
             vkDestroySemaphore(device, mDrawableSemaphore, nullptr);
         }
+
+        for (const auto secondaryCommandPool : mSecondaryCommandPools)
+        {
+            vkDestroyCommandPool(device, secondaryCommandPool, nullptr);
+        }
     }
 }
 
@@ -53,9 +58,15 @@ void RenderProcess::createRendererProcess(
     const VkDescriptorPool descriptorPool,
     const VkDescriptorSetLayout descriptorSetLayout,
     const size_t modelsNum,
-    const size_t lightsNum)
+    const size_t lightsNum,
+    const size_t drawsNum,
+    const size_t secondaryCommandBuffersNum)
 {
     mIndividualUniformData.resize(modelsNum);
+    mModelVersions.resize(modelsNum);
+    mIsIndividualDataDirty.assign(modelsNum, true);
+    mInstanceObjectsData.resize(drawsNum);
+    mIndirectCommandsData.resize(drawsNum);
 
     const auto device = mCtx.getVkDevice();
 
@@ -67,6 +78,28 @@ void RenderProcess::createRendererProcess(
     };
     TS_VK_CHECK(vkAllocateCommandBuffers, device, &commandBufferAllocateInfo, &mCommandBuffer);
 
+    // The pools are reset as a whole every frame instead of their buffers one by one
+    const VkCommandPoolCreateInfo secondaryCommandPoolCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = mCtx.getVkGraphicsQueueFamilyIndex()
+    };
+
+    mSecondaryCommandPools.resize(secondaryCommandBuffersNum);
+    mSecondaryCommandBuffers.resize(secondaryCommandBuffersNum);
+    for (size_t i{}; i < secondaryCommandBuffersNum; ++i)
+    {
+        TS_VK_CHECK(vkCreateCommandPool, device, &secondaryCommandPoolCreateInfo, nullptr, &mSecondaryCommandPools[i]);
+
+        const VkCommandBufferAllocateInfo secondaryCommandBufferAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = mSecondaryCommandPools[i],
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1,
+        };
+        TS_VK_CHECK(vkAllocateCommandBuffers, device, &secondaryCommandBufferAllocateInfo, &mSecondaryCommandBuffers[i]);
+    }
+
     const VkSemaphoreCreateInfo semaphoreCreateInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
     TS_VK_CHECK(vkCreateSemaphore, device, &semaphoreCreateInfo, nullptr, &mDrawableSemaphore);
 
@@ -80,16 +113,16 @@ void RenderProcess::createRendererProcess(
 
     const auto uniformBufferOffsetAlignment = mCtx.getUniformBufferOffsetAlignment();
 
+    // Individual data of all the models is one tightly packed storage buffer array
     std::vector<VkDescriptorBufferInfo> descriptorBufferInfos;
     descriptorBufferInfos.emplace_back(VkDescriptorBufferInfo{
         .offset = 0,
-        .range = sizeof(decltype(mIndividualUniformData)::value_type),
+        .range = sizeof(decltype(mIndividualUniformData)::value_type) * static_cast<VkDeviceSize>(std::max(modelsNum, size_t{1})),
     });
 
     descriptorBufferInfos.emplace_back(VkDescriptorBufferInfo{
         .offset = descriptorBufferInfos.back().offset +
-            khronos_utils::align(descriptorBufferInfos.back().range, uniformBufferOffsetAlignment) *
-            static_cast<VkDeviceSize>(modelsNum),
+            khronos_utils::align(descriptorBufferInfos.back().range, uniformBufferOffsetAlignment),
         .range = sizeof(mCommonUniformData),
     });
 
@@ -99,16 +132,31 @@ void RenderProcess::createRendererProcess(
         .range = sizeof(mLightsUniformData)
     });
 
+    descriptorBufferInfos.emplace_back(VkDescriptorBufferInfo{
+        .offset = descriptorBufferInfos.back().offset +
+            khronos_utils::align(descriptorBufferInfos.back().range, mCtx.getStorageBufferOffsetAlignment()),
+        .range = sizeof(decltype(mInstanceObjectsData)::value_type) * static_cast<VkDeviceSize>(std::max(drawsNum, size_t{1})),
+    });
+
     if (descriptorBufferInfos.empty())
     {
         TS_ERR("Workflow isn't yet prepared");
     }
 
-    const auto uniformBufferSize = descriptorBufferInfos.back().offset + descriptorBufferInfos.back().range;
+    mIndividualDataStride = sizeof(decltype(mIndividualUniformData)::value_type);
+    mCommonDataOffset = descriptorBufferInfos.at(1).offset;
+    mLightsDataOffset = descriptorBufferInfos.at(2).offset;
+    mInstanceObjectsDataOffset = descriptorBufferInfos.at(3).offset;
+    // Indirect commands aren't accessed through a descriptor, they only have to be aligned to 4 bytes
+    mIndirectCommandsDataOffset = khronos_utils::align(descriptorBufferInfos.back().offset + descriptorBufferInfos.back().range, 4);
+
+    // The coherent memory isn't required, the written ranges are flushed without it
+    const auto uniformBufferSize = mIndirectCommandsDataOffset +
+        sizeof(decltype(mIndirectCommandsData)::value_type) * static_cast<VkDeviceSize>(std::max(drawsNum, size_t{1}));
     mUniformBuffer = std::make_unique<DataBuffer>(mCtx);
     mUniformBuffer->createDataBuffer(
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
         uniformBufferSize);
 
     mUniformBufferMemory = mUniformBuffer->map();
@@ -137,7 +185,7 @@ void RenderProcess::createRendererProcess(
             .dstBinding = 0,
             .dstArrayElement = 0,
             .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
             .pBufferInfo = &descriptorBufferInfos.at(0),
         },
         VkWriteDescriptorSet{
@@ -158,6 +206,15 @@ void RenderProcess::createRendererProcess(
             .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
             .pBufferInfo = &descriptorBufferInfos.at(2),
         },
+        VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = mDescriptorSet,
+            .dstBinding = 3,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &descriptorBufferInfos.at(3),
+        },
     };
 
     vkUpdateDescriptorSets(
@@ -168,6 +225,17 @@ void RenderProcess::createRendererProcess(
         nullptr);
 }
 
+VkCommandBuffer RenderProcess::resetSecondaryCommandBuffer(const size_t index) const
+{
+    TS_VK_CHECK(vkResetCommandPool, mCtx.getVkDevice(), mSecondaryCommandPools.at(index), 0);
+    return mSecondaryCommandBuffers[index];
+}
+
+VkBuffer RenderProcess::getIndirectBuffer() const
+{
+    return mUniformBuffer->getBuffer();
+}
+
 void RenderProcess::updateUniformBufferData()
 {
     if (mUniformBufferMemory == nullptr)
@@ -175,29 +243,62 @@ void RenderProcess::updateUniformBufferData()
         TS_ERR("Uniform buffer wasn't allocated");
     }
 
-    const auto uniformBufferOffsetAlignment = mCtx.getUniformBufferOffsetAlignment();
+    mUploadedBytesNumber = 0;
+    mFlushRanges.clear();
 
-    auto offset = static_cast<int8_t*>(mUniformBufferMemory);
+    const auto upload = [&](const VkDeviceSize offset, const void* const data, const size_t length) {
+        memcpy(static_cast<int8_t*>(mUniformBufferMemory) + offset, data, length);
+        mUploadedBytesNumber += length;
 
+        // Writes of the neighbouring individual data are flushed as one range
+        if (!mFlushRanges.empty() && ((mFlushRanges.back().offset + mFlushRanges.back().size) == offset))
+        {
+            mFlushRanges.back().size += length;
+        }
+        else
+        {
+            mFlushRanges.emplace_back(VkMappedMemoryRange{.offset = offset, .size = length});
+        }
+    };
+
+    for (size_t i{}; i < mIndividualUniformData.size(); ++i)
     {
-        constexpr auto length = sizeof(decltype(mIndividualUniformData)::value_type);
-        for (const auto& individualData : mIndividualUniformData)
+        if (mIsIndividualDataDirty[i])
         {
-            memcpy(offset, &individualData, length);
-            offset += khronos_utils::align(length, uniformBufferOffsetAlignment);
+            upload(i * mIndividualDataStride, &mIndividualUniformData[i], mIndividualDataStride);
+            mIsIndividualDataDirty[i] = false;
         }
     }
 
+    if (mIsCommonDataDirty)
+    {
+        upload(mCommonDataOffset, &mCommonUniformData, sizeof(mCommonUniformData));
+        mIsCommonDataDirty = false;
+    }
+
+    if (mIsLightsDataDirty)
+    {
+        upload(mLightsDataOffset, &mLightsUniformData, sizeof(mLightsUniformData));
+        mIsLightsDataDirty = false;
+    }
+
+    if (mIsInstanceObjectsDataDirty)
+    {
+        upload(mInstanceObjectsDataOffset, mInstanceObjectsData.data(),
+            sizeof(decltype(mInstanceObjectsData)::value_type) * mInstanceObjectsData.size());
+        mIsInstanceObjectsDataDirty = false;
+    }
+
+    if (mIsIndirectCommandsDataDirty)
     {
-        constexpr auto length = sizeof(decltype(mCommonUniformData));
-        memcpy(offset, &mCommonUniformData, length);
-        offset += khronos_utils::align(length, uniformBufferOffsetAlignment);
+        upload(mIndirectCommandsDataOffset, mIndirectCommandsData.data(),
+            sizeof(decltype(mIndirectCommandsData)::value_type) * mIndirectCommandsData.size());
+        mIsIndirectCommandsDataDirty = false;
     }
 
+    if (!mUniformBuffer->isHostCoherent())
     {
-        constexpr auto length = sizeof(decltype(mLightsUniformData));
-        memcpy(offset, &mLightsUniformData, length);
-        offset += khronos_utils::align(length, uniformBufferOffsetAlignment);
+        mUniformBuffer->flush(mFlushRanges);
     }
 }
 } // namespace ver
@@ -3,6 +3,7 @@
 #include "tsengine/math.hpp"
 #include "internal_utils.h"
 #include "shaders/common.h"
+#include "draw_list.h"
 
 #include "vulkan/vulkan.h"
 
@@ -27,14 +28,30 @@ public:
         const VkDescriptorPool descriptorPool,
         const VkDescriptorSetLayout descriptorSetLayout,
         const size_t modelsNum,
-        const size_t lightsNum);
+        const size_t lightsNum,
+        const size_t drawsNum,
+        const size_t secondaryCommandBuffersNum);
 
+    // Read by the shaders as an element of the storage buffer array, the layout has to match std430
     struct IndivialData final
     {
         math::Mat4 model;
+        // Dequantization of the packed vertex positions
+        math::Vec4 positionScale;
+        math::Vec4 positionBias;
+        // The w is unused
+        math::Vec4 materialColor;
+        // Roughness and metallic
+        math::Vec4 materialProperties;
     };
     std::vector<IndivialData> mIndividualUniformData{};
+    // World version of the transform whose matrix is in the individual data
+    std::vector<uint64_t> mModelVersions{};
     
+    // Index of the individual data of every instance in the order of the draws
+    std::vector<uint32_t> mInstanceObjectsData{};
+    std::vector<DrawIndexedIndirectCommand> mIndirectCommandsData{};
+
     struct LightData final
     {
         std::array<math::Vec3, LIGHTS_N> positions;
@@ -47,21 +64,42 @@ public:
         std::array<math::Mat4, 2> projMats;
     } mCommonUniformData{};
 
+    // Only the parts of the uniform data marked as changed are written to the buffer
+    void markIndividualDataDirty(const size_t index) { mIsIndividualDataDirty.at(index) = true; }
+    void markLightsDataDirty() { mIsLightsDataDirty = true; }
+    void markCommonDataDirty() { mIsCommonDataDirty = true; }
+    void markInstanceObjectsDataDirty() { mIsInstanceObjectsDataDirty = true; }
+    void markIndirectCommandsDataDirty() { mIsIndirectCommandsDataDirty = true; }
     void updateUniformBufferData();
+    // Bytes written to the uniform buffer by the last update
+    [[nodiscard]] size_t getUploadedBytesNumber() const { return mUploadedBytesNumber; }
 
     [[nodiscard]] VkCommandBuffer getCommandBuffer() const { return mCommandBuffer; }
+    // Every secondary command buffer has its own pool, so the buffers can be recorded by different threads at once
+    [[nodiscard]] const std::vector<VkCommandBuffer>& getSecondaryCommandBuffers() const { return mSecondaryCommandBuffers; }
+    // Releases the previous commands of the buffer, its frame has to be finished
+    [[nodiscard]] VkCommandBuffer resetSecondaryCommandBuffer(const size_t index) const;
     [[nodiscard]] VkFence getFence() const { return mFence; }
     [[nodiscard]] VkDescriptorSet getDescriptorSet() const { return mDescriptorSet; }
+    [[nodiscard]] VkBuffer getIndirectBuffer() const;
+    [[nodiscard]] VkDeviceSize getIndirectCommandsOffset() const { return mIndirectCommandsDataOffset; }
     [[nodiscard]] VkSemaphore getDrawableSemaphore() const { return mDrawableSemaphore; }
     [[nodiscard]] VkSemaphore getPresentableSemaphore() const { return mPresentableSemaphore; }
 
 private:
     const Context& mCtx;
     VkCommandBuffer mCommandBuffer{};
+    std::vector<VkCommandPool> mSecondaryCommandPools{};
+    std::vector<VkCommandBuffer> mSecondaryCommandBuffers{};
     VkSemaphore mDrawableSemaphore{}, mPresentableSemaphore{};
     VkFence mFence{};
     std::unique_ptr<DataBuffer> mUniformBuffer;
     void* mUniformBufferMemory{};
+    VkDeviceSize mIndividualDataStride{}, mCommonDataOffset{}, mLightsDataOffset{}, mInstanceObjectsDataOffset{}, mIndirectCommandsDataOffset{};
+    std::vector<uint8_t> mIsIndividualDataDirty{};
+    bool mIsLightsDataDirty{true}, mIsCommonDataDirty{true}, mIsInstanceObjectsDataDirty{true}, mIsIndirectCommandsDataDirty{true};
+    std::vector<VkMappedMemoryRange> mFlushRanges{};
+    size_t mUploadedBytesNumber{};
     VkDescriptorSet mDescriptorSet{};
     const Headset& mHeadset;
 };
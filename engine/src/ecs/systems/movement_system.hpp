@@ -24,6 +24,11 @@ public:
         requireComponent<TransformComponent>();
         requireComponent<RigidBodyComponent>();
 
+        readsComponent<RigidBodyComponent>();
+        writesComponent<TransformComponent>();
+        // Player is looked up by its tag
+        runsExclusively();
+
 #ifdef CYBSDK_FOUND
         mpCyberithDevice = CybSDK::Virt::FindDevice();
         if (mpCyberithDevice == nullptr)
@@ -74,9 +79,11 @@ public:
                 offsetZ *= -1;
             }
 
-            auto& playerPosition = player.getComponent<TransformComponent>().pos;
+            auto& playerTransform = player.getComponent<TransformComponent>();
+            auto playerPosition = playerTransform.getPosition();
             playerPosition.x += offsetX;
             playerPosition.z += offsetZ;
+            playerTransform.setPosition(playerPosition);
         }
 #else
         for (size_t controllerIndex{}; controllerIndex < controllers.controllerCount; ++controllerIndex)
@@ -90,7 +97,9 @@ public:
                 if ((!controllerPose.isNan()) || (controllerPose == math::Vec3{0.f}))
                 {
                     const math::Vec3 forward{controllers.getPose(controllerIndex)[2]};
-                    player.getComponent<TransformComponent>().pos += forward * player.getComponent<RigidBodyComponent>().velocity * dt;
+                    auto& playerTransform = player.getComponent<TransformComponent>();
+                    playerTransform.setPosition(
+                        playerTransform.getPosition() + forward * player.getComponent<RigidBodyComponent>().velocity * dt);
                 }
                 else
                 {
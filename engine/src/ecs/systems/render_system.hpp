@@ -6,8 +6,12 @@
 #include "tsengine/ecs/components/transform_component.hpp"
 #include "tsengine/ecs/components/renderer_component.hpp"
 
+#include "ecs/systems/spatial_index_system.hpp"
+
 #include "core/renderer_process.h"
 #include "core/pipeline.h"
+#include "core/draw_commands.h"
+#include "core/frustum_culling.h"
 #include "khronos_utils.h"
 
 #include "shaders/light_cube.h"
@@ -16,6 +20,9 @@
 
 #include "vulkan_tools/vulkan_functions.h"
 
+#include <numeric>
+#include <span>
+
 namespace ts
 {
 inline namespace TS_VER
@@ -25,8 +32,7 @@ class Renderer;
 class RenderSystem : public System
 {
 public:
-    RenderSystem(const VkDeviceSize vkUniformBufferOffsetAlignment) :
-        mVkUniformBufferOffsetAlignment{vkUniformBufferOffsetAlignment}
+    RenderSystem()
     {
         requireComponent<RendererComponentBase>();
 
@@ -34,120 +40,151 @@ public:
         gReg.addSystem<Meshes>();
     }
 
-    void update(const VkCommandBuffer cmdBuf, const VkDescriptorSet descriptorSet)
+    // Entities outside of the frustum aren't drawn, the meshes are looked up in the spatial index when it's registered.
+    // Level of detail of every mesh is picked for the eye closest to it.
+    void prepareDraws(const Frustum& frustum, const LodSelection& lodSelection)
     {
-        auto entities = getSystemEntities();
+        const auto& meshes = gReg.getSystem<Meshes>();
+        mDrawCommandBuilder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
 
-        std::ranges::sort(entities, std::less{}, [](const auto entity) {
-            return entity.getComponent<RendererComponentBase>().z;
-        });
+        if (gReg.hasSystem<SpatialIndexSystem>())
+        {
+            mFrustumCuller.cull(frustum, getSystemEntities(), getEntitiesVersion(), gReg.getSystem<SpatialIndexSystem>().getTree());
+        }
+        else
+        {
+            mFrustumCuller.cull(frustum, getSystemEntities(), getEntitiesVersion());
+        }
 
-        for (const auto entity : entities)
+        // Draws are ordered from the middle of the eyes, the player position translates the world the opposite way
+        math::Vec3 eyePos{};
+        if (lodSelection.eyePositions.empty())
         {
-            size_t entityIndexforUniformBufferOffset{};
-            uint32_t uniformBufferOffsets = 
-                static_cast<uint32_t>(khronos_utils::align(static_cast<VkDeviceSize>(sizeof(decltype(RenderProcess::mIndividualUniformData)::value_type)),
-                    mVkUniformBufferOffsetAlignment) * static_cast<VkDeviceSize>(entityIndexforUniformBufferOffset));
-
-            vkCmdBindDescriptorSets(
-                cmdBuf,
-                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                mpPipelineLayout,
-                0,
-                1,
-                &descriptorSet,
-                1,
-                &uniformBufferOffsets);
-
-            auto& pos = entity.getComponent<TransformComponent>().pos;
-            if (entity.hasComponent<TransformComponent>())
+            eyePos = gReg.getEntityByTag("player").getComponent<TransformComponent>().getWorldPosition() * -1.f;
+        }
+        else
+        {
+            for (const auto& eyePosition : lodSelection.eyePositions)
             {
-                vkCmdPushConstants(cmdBuf,
-                    mpPipelineLayout,
-                    VK_SHADER_STAGE_VERTEX_BIT,
-                    0,
-                    sizeof(math::Vec3),
-                    &pos);
+                eyePos += eyePosition;
             }
+            eyePos = eyePos * (1.f / static_cast<float>(lodSelection.eyePositions.size()));
+        }
+        mDrawCommandBuilder.build(getSystemEntities(), eyePos, mFrustumCuller.getVisibility(), lodSelection);
+    }
 
-            if (entity.hasComponent<MeshComponent>())
-            {
-                TS_ASSERT_MSG(!entity.hasComponent<RendererComponent<PipelineType::COLOR>>(), "Not implemented yet");
+    // Visible and culled entities of the last frame
+    const CullingStatistics& getCullingStatistics() const { return mFrustumCuller.getStatistics(); }
 
-                const auto& mesh = entity.getComponent<MeshComponent>();
+    // Triangles of the drawn levels of detail in the last frame
+    size_t getTrianglesNumber() const { return mDrawCommandBuilder.getTrianglesNumber(); }
 
-                if (entity.hasComponent<RendererComponent<PipelineType::NORMAL_LIGHTING>>())
-                {
-                    if (const auto pipe = mpNormalLightingPipeline.lock())
-                    {
-                        pipe->bind(cmdBuf);
-                    }
-                    else
-                    {
-                        throw Exception{"Invalid normal lighting pipeline"};
-                    }
-                }
-                else if (entity.hasComponent<RendererComponent<PipelineType::PBR>>())
+    const std::vector<uint32_t>& getInstanceObjects() const { return mDrawCommandBuilder.getInstanceObjects(); }
+    const std::vector<DrawIndexedIndirectCommand>& getIndirectCommands() const { return mDrawCommandBuilder.getIndirectCommands(); }
+
+    // Splits the draws between at most maxRanges command buffers, returns the number of them to record
+    size_t prepareRecording(const size_t maxRanges)
+    {
+        mDrawCommandBuilder.splitRecording(maxRanges, minBatchesPerRecording);
+        const auto rangesNumber = mDrawCommandBuilder.getRecordingRanges().size();
+        mDrawStateTrackers.resize(rangesNumber);
+        return rangesNumber;
+    }
+
+    // Records one range of the draws, the ranges can be recorded in parallel into different command buffers.
+    // Descriptor set is bound once and the meshes of every pipeline are drawn with one indirect call,
+    // the indirect commands are read from the buffer at the offset
+    void record(
+        const size_t rangeIndex,
+        const VkCommandBuffer cmdBuf,
+        const VkDescriptorSet descriptorSet,
+        const VkBuffer indirectBuffer,
+        const VkDeviceSize indirectOffset)
+    {
+        const auto& entities = getSystemEntities();
+        const auto& items = mDrawCommandBuilder.getDrawList().getItems();
+        const auto& batches = mDrawCommandBuilder.getDrawList().getBatches();
+        const auto& range = mDrawCommandBuilder.getRecordingRanges().at(rangeIndex);
+        const auto indirectGroups = std::span{mDrawCommandBuilder.getRecordingGroups()}.subspan(
+            range.firstIndirectGroup, range.indirectGroupsNumber);
+        auto& drawStateTracker = mDrawStateTrackers.at(rangeIndex);
+
+        drawStateTracker.reset();
+
+        vkCmdBindDescriptorSets(
+            cmdBuf,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            mpPipelineLayout,
+            0,
+            1,
+            &descriptorSet,
+            0,
+            nullptr);
+
+        size_t indirectGroupIndex{};
+        const auto batchesEnd = range.firstBatch + range.batchesNumber;
+        for (auto batchIndex = range.firstBatch; batchIndex < batchesEnd;)
+        {
+            if ((indirectGroupIndex < indirectGroups.size()) && (indirectGroups[indirectGroupIndex].firstBatch == batchIndex))
+            {
+                const auto& indirectGroup = indirectGroups[indirectGroupIndex++];
+                if (drawStateTracker.shouldBindPipeline(indirectGroup.pipeline))
                 {
-                    if (const auto pipe = mpPbrPipeline.lock())
-                    {
-                        pipe->bind(cmdBuf);
-                    }
-                    else
-                    {
-                        throw Exception{"Invalid pbr pipeline"};
-                    }
-                
-                    vkCmdPushConstants(cmdBuf,
-                        mpPipelineLayout,
-                        VK_SHADER_STAGE_FRAGMENT_BIT,
-                        sizeof(math::Vec3),
-                        sizeof(RendererComponent<PipelineType::PBR>::Material),
-                        &entity.getComponent<RendererComponent<PipelineType::PBR>>().material);
+                    bindPipeline(cmdBuf, static_cast<PipelineType>(indirectGroup.pipeline));
                 }
 
-                vkCmdDrawIndexed(cmdBuf,
-                    static_cast<uint32_t>(mesh.indexCount),
-                    1,
-                    static_cast<uint32_t>(mesh.firstIndex),
-                    0,
-                    0);
+                drawIndirect(cmdBuf, drawStateTracker, indirectBuffer, indirectOffset, indirectGroup);
+                batchIndex += indirectGroup.commandsNumber;
+                continue;
+            }
 
-                entityIndexforUniformBufferOffset++;
+            const auto& [key, index] = items[batches[batchIndex].firstItem];
+            const auto pipelineType = static_cast<PipelineType>(draw_key::getPipeline(key));
+            if (drawStateTracker.shouldBindPipeline(draw_key::getPipeline(key)))
+            {
+                bindPipeline(cmdBuf, pipelineType);
             }
-            else if (entity.hasComponent<RendererComponent<PipelineType::LIGHT>>())
+
+            if (pipelineType == PipelineType::LIGHT)
             {
-                if (const auto pipe = mpLightCubePipeline.lock())
-                {
-                    pipe->bind(cmdBuf);
-                }
-                else
-                {
-                    throw Exception{"Invalid pbr pipeline"};
-                }
+                const auto pos = entities[index].getComponent<TransformComponent>().getWorldPosition();
+                vkCmdPushConstants(cmdBuf,
+                    mpPipelineLayout,
+                    VK_SHADER_STAGE_VERTEX_BIT,
+                    0,
+                    sizeof(math::Vec3),
+                    &pos);
 
                 vkCmdDraw(cmdBuf, LIGHT_CUBE_DRAW_CALL_VERTEX_COUNT, 1, 0, 0);
             }
-            else if (entity.hasComponent<RendererComponent<PipelineType::GRID>>())
+            else if (pipelineType == PipelineType::GRID)
             {
-                if (auto pipe = mpGridPipeline.lock())
-                {
-                    pipe->bind(cmdBuf);
-                }
-                else
-                {
-                    throw Exception{"Invalid grid pipeline"};
-                }
-
                 vkCmdDraw(cmdBuf, GRID_DRAW_CALL_VERTEX_COUNT, 1, 0, 0);
             }
             else
             {
                 TS_ERR("Unexpected rendering workflow");
             }
+
+            drawStateTracker.countDraw(1);
+            ++batchIndex;
         }
     }
 
+    // Draws, instances and binds issued and skipped by the last recording, summed over all its command buffers
+    DrawStatistics getDrawStatistics() const
+    {
+        DrawStatistics statistics{};
+        for (const auto& drawStateTracker : mDrawStateTrackers)
+        {
+            statistics += drawStateTracker.getStatistics();
+        }
+        return statistics;
+    }
+
+    // Per object data is stored in the order of these entities, so the slots stay the same until a mesh is added or removed
+    const std::vector<Entity>& getMeshEntities() const { return gReg.getSystem<Meshes>().getSystemEntities(); }
+
     class Lights : public System
     {
     public:
@@ -164,9 +201,87 @@ public:
 
 private:
     friend Renderer;
-    const VkDeviceSize& mVkUniformBufferOffsetAlignment;
+
+    // Smaller scenes are recorded into one command buffer, splitting them costs more than it saves
+    static constexpr size_t minBatchesPerRecording{128};
+
+    void bindPipeline(const VkCommandBuffer cmdBuf, const PipelineType pipelineType) const
+    {
+        const auto& pipeline = [&]() -> const std::weak_ptr<Pipeline>& {
+            switch (pipelineType)
+            {
+            case PipelineType::NORMAL_LIGHTING: return mpNormalLightingPipeline;
+            case PipelineType::PBR: return mpPbrPipeline;
+            case PipelineType::LIGHT: return mpLightCubePipeline;
+            case PipelineType::GRID: return mpGridPipeline;
+            default: throw Exception{"Unexpected pipeline type"};
+            }
+        }();
+
+        if (const auto pipe = pipeline.lock())
+        {
+            pipe->bind(cmdBuf);
+        }
+        else
+        {
+            throw Exception{"Invalid pipeline"};
+        }
+    }
+
+    void drawIndirect(
+        const VkCommandBuffer cmdBuf,
+        DrawStateTracker& drawStateTracker,
+        const VkBuffer indirectBuffer,
+        const VkDeviceSize indirectOffset,
+        const IndirectDrawGroup& indirectGroup)
+    {
+        static_assert(sizeof(DrawIndexedIndirectCommand) == sizeof(VkDrawIndexedIndirectCommand));
+        constexpr uint32_t stride{sizeof(DrawIndexedIndirectCommand)};
+
+        const auto& commands = mDrawCommandBuilder.getIndirectCommands();
+        const auto firstCommand = commands.begin() + indirectGroup.firstCommand;
+        const auto instancesNumber = std::accumulate(firstCommand, firstCommand + indirectGroup.commandsNumber, size_t{},
+            [](const size_t sum, const auto& command) { return sum + command.instanceCount; });
+        drawStateTracker.countIndirectCommands(indirectGroup.commandsNumber, instancesNumber);
+
+        const auto offset = indirectOffset + (static_cast<VkDeviceSize>(indirectGroup.firstCommand) * stride);
+        if (!mIsDrawIndirectFirstInstanceSupported)
+        {
+            // The first instance of the indirect commands has to be 0 without the feature, so they're drawn directly
+            for (uint32_t i{}; i < indirectGroup.commandsNumber; ++i)
+            {
+                const auto& command = firstCommand[i];
+                vkCmdDrawIndexed(cmdBuf,
+                    command.indexCount,
+                    command.instanceCount,
+                    command.firstIndex,
+                    command.vertexOffset,
+                    command.firstInstance);
+                drawStateTracker.countDraw(0);
+            }
+        }
+        else if (!mIsMultiDrawIndirectSupported)
+        {
+            for (uint32_t i{}; i < indirectGroup.commandsNumber; ++i)
+            {
+                vkCmdDrawIndexedIndirect(cmdBuf, indirectBuffer, offset + (static_cast<VkDeviceSize>(i) * stride), 1, stride);
+                drawStateTracker.countDraw(0);
+            }
+        }
+        else
+        {
+            vkCmdDrawIndexedIndirect(cmdBuf, indirectBuffer, offset, indirectGroup.commandsNumber, stride);
+            drawStateTracker.countDraw(0);
+        }
+    }
+
     std::weak_ptr<Pipeline> mpGridPipeline, mpNormalLightingPipeline, mpPbrPipeline, mpLightCubePipeline;
     VkPipelineLayout mpPipelineLayout{};
+    DrawCommandBuilder mDrawCommandBuilder;
+    FrustumCuller mFrustumCuller;
+    // Every command buffer starts without any bound state, so each range has its own tracker
+    std::vector<DrawStateTracker> mDrawStateTrackers;
+    bool mIsMultiDrawIndirectSupported{}, mIsDrawIndirectFirstInstanceSupported{};
 
     class Meshes : public System
     {
@@ -174,6 +289,7 @@ private:
         Meshes()
         {
             requireComponent<MeshComponent>();
+            requireComponent<TransformComponent>();
         }
     };
 };
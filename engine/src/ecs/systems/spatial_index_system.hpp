@@ -0,0 +1,138 @@
+#pragma once
+
+#include "tsengine/ecs/ecs.h"
+
+#include "tsengine/ecs/components/mesh_component.hpp"
+#include "tsengine/ecs/components/transform_component.hpp"
+
+#include "core/aabb_tree.h"
+
+#include <optional>
+
+namespace ts
+{
+inline namespace TS_VER
+{
+struct RayHit
+{
+    Entity entity;
+    float distance;
+};
+
+// World bounding boxes of the meshes kept in the tree. It's built again when the entities change, otherwise only the
+// proxies of the changed transforms are moved, which most often stay inside of their fat boxes.
+class SpatialIndexSystem : public System
+{
+public:
+    SpatialIndexSystem()
+    {
+        requireComponent<MeshComponent>();
+        requireComponent<TransformComponent>();
+
+        readsComponent<MeshComponent>();
+        readsComponent<TransformComponent>();
+    }
+
+    // Scheduled after the transform system, so the world matrices are the ones of the current frame
+    void update()
+    {
+        if (mEntitiesVersion != getEntitiesVersion())
+        {
+            rebuild();
+        }
+        else if (mTransformsVersion != TransformComponent::getLatestVersion())
+        {
+            moveChanged();
+        }
+
+        mTransformsVersion = TransformComponent::getLatestVersion();
+    }
+
+    const AabbTree& getTree() const { return mTree; }
+
+    template<typename TFunc>
+    void queryFrustum(const Frustum& frustum, TFunc&& func) const
+    {
+        const auto& entities = getSystemEntities();
+        mTree.queryFrustum(frustum, [&](const uint32_t proxy) { func(entities[proxy]); });
+    }
+
+    template<typename TFunc>
+    void querySphere(const math::Vec3& center, const float radius, TFunc&& func) const
+    {
+        const auto& entities = getSystemEntities();
+        mTree.querySphere(center, radius, [&](const uint32_t proxy) { func(entities[proxy]); });
+    }
+
+    // Closest entity whose world bounding box the ray hits
+    std::optional<RayHit> raycast(const Ray& ray, const float maxDistance) const
+    {
+        const math::Vec3 invDirection{1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z};
+
+        std::optional<RayHit> closestHit;
+        mTree.raycast(ray, maxDistance, [&](const uint32_t proxy, float) {
+            const auto distance = aabb::intersectRay(mWorldBoxes[proxy], ray.origin, invDirection, maxDistance);
+            if (distance == std::numeric_limits<float>::infinity())
+            {
+                return maxDistance;
+            }
+
+            closestHit = RayHit{getSystemEntities()[proxy], distance};
+            return distance;
+        });
+
+        return closestHit;
+    }
+
+private:
+    static Aabb getWorldBox(const Entity entity)
+    {
+        const auto& mesh = entity.getComponent<MeshComponent>();
+        return aabb::transform({mesh.boundsMin, mesh.boundsMax}, entity.getComponent<TransformComponent>().getWorldMat());
+    }
+
+    // Proxy of every entity is its index in the system
+    void rebuild()
+    {
+        mEntitiesVersion = getEntitiesVersion();
+
+        const auto& entities = getSystemEntities();
+        mWorldBoxes.resize(entities.size());
+        mWorldVersions.resize(entities.size());
+        std::vector<uint32_t> ids(entities.size());
+        for (size_t i{}; i < entities.size(); ++i)
+        {
+            mWorldBoxes[i] = getWorldBox(entities[i]);
+            mWorldVersions[i] = entities[i].getComponent<TransformComponent>().getWorldVersion();
+            ids[i] = entities[i].getId();
+        }
+
+        mTree.build(mWorldBoxes, ids);
+    }
+
+    void moveChanged()
+    {
+        const auto& entities = getSystemEntities();
+        for (uint32_t i{}; i < entities.size(); ++i)
+        {
+            const auto worldVersion = entities[i].getComponent<TransformComponent>().getWorldVersion();
+            if (mWorldVersions[i] == worldVersion)
+            {
+                continue;
+            }
+
+            mWorldVersions[i] = worldVersion;
+            mWorldBoxes[i] = getWorldBox(entities[i]);
+            mTree.moveProxy(i, mWorldBoxes[i]);
+        }
+    }
+
+    AabbTree mTree;
+    // Exact boxes, the tree keeps the fattened ones
+    std::vector<Aabb> mWorldBoxes;
+    std::vector<uint64_t> mWorldVersions;
+    size_t mEntitiesVersion{std::numeric_limits<size_t>::max()};
+    uint64_t mTransformsVersion{};
+};
+} // namespace ver
+} // namespace ts
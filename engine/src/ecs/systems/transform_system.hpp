@@ -0,0 +1,173 @@
+#pragma once
+
+#include "tsengine/logger.h"
+
+#include "tsengine/ecs/ecs.h"
+
+#include "tsengine/ecs/components/transform_component.hpp"
+#include "tsengine/ecs/components/parent_component.hpp"
+
+namespace ts
+{
+inline namespace TS_VER
+{
+// Entities are kept in the depth first order, so every parent is updated before its children in one linear pass.
+// Transforms flag their changes in the system, so only the changed ones and the subtrees below them are visited.
+class TransformSystem : public System
+{
+public:
+    TransformSystem()
+    {
+        requireComponent<TransformComponent>();
+
+        readsComponent<ParentComponent>();
+        writesComponent<TransformComponent>();
+    }
+
+    void update()
+    {
+        if ((mEntitiesVersion != getEntitiesVersion()) || (mHierarchyVersion != ParentComponent::getHierarchyVersion()))
+        {
+            sortEntities();
+        }
+
+        auto& changedFlags = *mpChangedFlags;
+        for (size_t i{}; i < mNodes.size(); ++i)
+        {
+            auto& node = mNodes[i];
+            const auto hasParent = (node.parentIndex != invalidIndex);
+            node.isChanged = changedFlags[i] || (hasParent && mNodes[node.parentIndex].isChanged);
+            if (!node.isChanged)
+            {
+                continue;
+            }
+
+            changedFlags[i] = false;
+
+            auto& transform = node.entity.getComponent<TransformComponent>();
+            mWorldMats[i] = hasParent ? (mWorldMats[node.parentIndex] * transform.getModelMat()) : transform.getModelMat();
+            transform.setWorldMat(mWorldMats[i]);
+        }
+    }
+
+private:
+    static constexpr size_t invalidIndex{std::numeric_limits<size_t>::max()};
+
+    struct Node
+    {
+        Entity entity;
+        size_t parentIndex;
+        bool isChanged;
+    };
+
+    void sortEntities()
+    {
+        mEntitiesVersion = getEntitiesVersion();
+        mHierarchyVersion = ParentComponent::getHierarchyVersion();
+
+        const auto& entities = getSystemEntities();
+
+        // Entity ids are dense, so they are translated with an array
+        Id maxEntityId{};
+        for (const auto entity : entities)
+        {
+            maxEntityId = std::max(maxEntityId, entity.getId());
+        }
+
+        std::vector<size_t> indexPerEntity(static_cast<size_t>(maxEntityId) + 1, invalidIndex);
+        for (size_t i{}; i < entities.size(); ++i)
+        {
+            indexPerEntity[entities[i].getId()] = i;
+        }
+
+        // Children of every entity are stored contiguously, their range starts at the offset of the parent
+        std::vector<size_t> parentIndices(entities.size(), invalidIndex);
+        std::vector<size_t> childrenOffsets(entities.size() + 1);
+        for (size_t i{}; i < entities.size(); ++i)
+        {
+            if (!entities[i].hasComponent<ParentComponent>())
+            {
+                continue;
+            }
+
+            const auto parentId = entities[i].getComponent<ParentComponent>().getParent().getId();
+            const auto parentIndex = (parentId <= maxEntityId) ? indexPerEntity[parentId] : invalidIndex;
+            if (parentIndex == invalidIndex)
+            {
+                TS_WARN(std::format("Parent of the entity {} has no transform, it's treated as a root", entities[i].getId()).c_str());
+                continue;
+            }
+
+            parentIndices[i] = parentIndex;
+            ++childrenOffsets[parentIndex + 1];
+        }
+
+        for (size_t i{}; i < entities.size(); ++i)
+        {
+            childrenOffsets[i + 1] += childrenOffsets[i];
+        }
+
+        std::vector<size_t> children(childrenOffsets.back());
+        auto childrenEnds = childrenOffsets;
+        for (size_t i{}; i < entities.size(); ++i)
+        {
+            if (parentIndices[i] != invalidIndex)
+            {
+                children[childrenEnds[parentIndices[i]]++] = i;
+            }
+        }
+
+        mNodes.clear();
+        mNodes.reserve(entities.size());
+        std::vector<size_t> sortedIndices(entities.size(), invalidIndex);
+        std::vector<size_t> stack;
+        for (size_t root{}; root < entities.size(); ++root)
+        {
+            if (parentIndices[root] != invalidIndex)
+            {
+                continue;
+            }
+
+            stack.push_back(root);
+            while (!stack.empty())
+            {
+                const auto i = stack.back();
+                stack.pop_back();
+
+                sortedIndices[i] = mNodes.size();
+                const auto parentIndex = (parentIndices[i] != invalidIndex) ? sortedIndices[parentIndices[i]] : invalidIndex;
+                mNodes.push_back({.entity = entities[i], .parentIndex = parentIndex, .isChanged = true});
+
+                // Reversed, so the children are popped in their original order
+                for (auto child = childrenOffsets[i + 1]; child > childrenOffsets[i]; --child)
+                {
+                    stack.push_back(children[child - 1]);
+                }
+            }
+        }
+
+        if (mNodes.size() != entities.size())
+        {
+            TS_ERR("Transform hierarchy contains a cycle");
+        }
+
+        // Transforms linked to the previous flags stop reporting to them, as they are released here
+        mpChangedFlags = std::make_shared<std::vector<uint8_t>>(mNodes.size(), static_cast<uint8_t>(true));
+        for (size_t i{}; i < mNodes.size(); ++i)
+        {
+            auto& transform = mNodes[i].entity.getComponent<TransformComponent>();
+            transform.mpChangedFlags = mpChangedFlags;
+            transform.mNodeIndex = i;
+        }
+
+        mWorldMats.resize(mNodes.size());
+    }
+
+    std::vector<Node> mNodes;
+    std::vector<math::Mat4> mWorldMats;
+    std::shared_ptr<std::vector<uint8_t>> mpChangedFlags{std::make_shared<std::vector<uint8_t>>()};
+    size_t mEntitiesVersion{};
+    uint64_t mHierarchyVersion{};
+};
+} // namespace ver
+} // namespace ts
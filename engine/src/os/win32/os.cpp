@@ -1,4 +1,5 @@
 #include "os.h"
+#include "core/mapped_file.h"
 #include "tsengine/logger.h"
 
 namespace ts
@@ -96,5 +97,78 @@ LRESULT Win32Window::windowProcedure(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
 
     return 0;
 }
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    mpFile = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+
+    if (mpFile == INVALID_HANDLE_VALUE)
+    {
+        mpFile = nullptr;
+        TS_ERR(("File can not be opened: " + path.string()).c_str());
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(mpFile, &fileSize))
+    {
+        unmap();
+        TS_ERR(("File size can not be read: " + path.string()).c_str());
+    }
+
+    mSize = static_cast<size_t>(fileSize.QuadPart);
+    if (mSize == 0)
+    {
+        return;
+    }
+
+    mpMapping = CreateFileMappingW(mpFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mpMapping == nullptr)
+    {
+        unmap();
+        TS_ERR(("File mapping creation failure: " + path.string()).c_str());
+    }
+
+    mpData = static_cast<const std::byte*>(MapViewOfFile(mpMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mpData == nullptr)
+    {
+        unmap();
+        TS_ERR(("File can not be mapped: " + path.string()).c_str());
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+void MappedFile::unmap()
+{
+    if (mpData != nullptr)
+    {
+        UnmapViewOfFile(mpData);
+        mpData = nullptr;
+    }
+
+    if (mpMapping != nullptr)
+    {
+        CloseHandle(mpMapping);
+        mpMapping = nullptr;
+    }
+
+    if (mpFile != nullptr)
+    {
+        CloseHandle(mpFile);
+        mpFile = nullptr;
+    }
+
+    mSize = 0;
+}
 } // namespace ver
 } // namespace ts
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "glslang/Include/glslang_c_interface.h"
 #include "glslang/Public/resource_limits_c.h"
 #include "tsengine/logger.h"
+#include "tsengine/job_system.h"
 
 namespace ts
 {
@@ -172,6 +173,7 @@ void compileShaders(const std::filesystem::path shadersPath)
     }
 
     // TODO: compile only modified shaders
+    std::vector<std::filesystem::path> shadersToCompile;
     size_t shadersFoundCount{};
     for (const auto& file : std::filesystem::recursive_directory_iterator(shadersPath))
     {
@@ -190,11 +192,15 @@ void compileShaders(const std::filesystem::path shadersPath)
         }
 #endif // NDEBUG
 
-        const auto spriv = compileShaderFile(file.path());
+        shadersToCompile.emplace_back(file.path());
+    }
+
+    getJobSystem().parallelFor(0, shadersToCompile.size(), [&shadersToCompile](const size_t i) {
+        const auto spriv = compileShaderFile(shadersToCompile[i]);
 
-        const auto outputFileName = file.path().string() + ".spirv";
+        const auto outputFileName = shadersToCompile[i].string() + ".spirv";
         saveSPIRV(outputFileName, spriv);
-    }
+    }, 1);
 
     if (shadersFoundCount == 0)
     {
@@ -154,6 +154,7 @@ DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdSetScissor)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdBindVertexBuffers)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdDraw)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdDrawIndexed)
+DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdDrawIndexedIndirect)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdDispatch)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdCopyImage)
 DEVICE_LEVEL_VULKAN_FUNCTION(vkCmdPushConstants)
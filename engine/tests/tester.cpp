@@ -1,8 +1,30 @@
 #include "gtest/gtest.h"
 #include "tests_core_adapter.h"
 #include "tsengine/math.hpp"
+#include "tsengine/math_batch.hpp"
+#include "tsengine/ecs/ecs.h"
+#include "tsengine/job_system.h"
+#include "tsengine/event_bus.hpp"
+#include "core/mesh_processing.h"
+#include "core/cooked_mesh.h"
+#include "core/mapped_file.h"
+#include "core/draw_list.h"
+#include "core/draw_commands.h"
+#include "core/frustum_culling.h"
+#include "core/aabb_tree.h"
+#include "tsengine/ecs/components/transform_component.hpp"
+#include "tsengine/ecs/components/parent_component.hpp"
+#include "ecs/systems/transform_system.hpp"
+#include "ecs/systems/spatial_index_system.hpp"
+#include "tsengine/ecs/components/rigid_body_component.hpp"
 
+#include <atomic>
 #include <memory>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>
 
 TEST(DummyTests, Dummytest)
 {
@@ -130,6 +152,111 @@ TEST(MathTests, mat4InversionTest)
     ASSERT_EQ(ts::math::to_string(invertedMatrix), ts::math::to_string(expected));
 }
 
+TEST(MathTests, mat4SimdTest)
+{
+    std::mt19937 generator{};
+    std::uniform_real_distribution<float> distribution{-10.f, 10.f};
+    const auto randomMatrix = [&] {
+        ts::math::Mat4 matrix;
+        for (auto& column : matrix.data)
+        {
+            column = {distribution(generator), distribution(generator), distribution(generator), distribution(generator)};
+        }
+        return matrix;
+    };
+
+    const auto isBitEqual = [](const auto& lhs, const auto& rhs) {
+        return std::memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+    };
+
+    for (size_t i{}; i < 1000; ++i)
+    {
+        const auto lhs = randomMatrix();
+        const auto rhs = randomMatrix();
+        const auto vec = rhs.data[0];
+
+        ASSERT_TRUE(isBitEqual(lhs * rhs, ts::math::scalar::multiply(lhs, rhs)));
+        ASSERT_TRUE(isBitEqual(lhs * vec, ts::math::scalar::multiply(lhs, vec)));
+        ASSERT_TRUE(isBitEqual(ts::math::transpose(lhs), ts::math::scalar::transpose(lhs)));
+        ASSERT_TRUE(isBitEqual(ts::math::inverse(lhs), ts::math::scalar::inverse(lhs)));
+
+        const auto& otherVec = rhs.data[1];
+        ASSERT_TRUE(isBitEqual(vec + otherVec,
+            ts::math::Vec4{vec.x + otherVec.x, vec.y + otherVec.y, vec.z + otherVec.z, vec.w + otherVec.w}));
+        ASSERT_TRUE(isBitEqual(vec * otherVec.x,
+            ts::math::Vec4{vec.x * otherVec.x, vec.y * otherVec.x, vec.z * otherVec.x, vec.w * otherVec.x}));
+    }
+
+    // Constant evaluation takes the scalar code
+    static_assert((ts::math::Vec4{1.f} + ts::math::Vec4{2.f}) * 2.f == ts::math::Vec4{6.f});
+
+    ASSERT_THROW(ts::math::inverse(ts::math::Mat4{}), ts::Exception);
+}
+
+TEST(MathTests, batchTest)
+{
+    // Not a multiple of the SIMD width, so the remainder is covered too
+    static constexpr size_t count{103};
+
+    std::mt19937 generator{};
+    std::uniform_real_distribution<float> distribution{-10.f, 10.f};
+    const auto randomVec3 = [&] { return ts::math::Vec3{distribution(generator), distribution(generator), distribution(generator)}; };
+    const auto randomMatrix = [&] {
+        ts::math::Mat4 matrix;
+        for (auto& column : matrix.data)
+        {
+            column = {distribution(generator), distribution(generator), distribution(generator), distribution(generator)};
+        }
+        return matrix;
+    };
+
+    const auto isBitEqual = [](const auto& lhs, const auto& rhs) {
+        return std::memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+    };
+
+    // Vec3 has a padding
+    const auto isVec3BitEqual = [](const ts::math::Vec3& lhs, const ts::math::Vec3& rhs) {
+        return std::memcmp(&lhs, &rhs, 3 * sizeof(float)) == 0;
+    };
+
+    ts::math::Vec3Array points;
+    ts::math::Mat4Array lhsMatrices, rhsMatrices;
+    points.resize(count);
+    lhsMatrices.resize(count);
+    rhsMatrices.resize(count);
+    for (size_t i{}; i < count; ++i)
+    {
+        points.set(i, randomVec3());
+        lhsMatrices.set(i, randomMatrix());
+        rhsMatrices.set(i, randomMatrix());
+    }
+
+    const auto transformMatrix = randomMatrix();
+    ts::math::Vec3Array transformedPoints;
+    ts::math::transformPoints(transformMatrix, points, transformedPoints);
+
+    ts::math::Mat4Array multipliedMatrices;
+    ts::math::multiply(lhsMatrices, rhsMatrices, multipliedMatrices);
+
+    auto normalizedVectors = points;
+    ts::math::normalize(normalizedVectors);
+
+    ASSERT_EQ(transformedPoints.size(), count);
+    ASSERT_EQ(multipliedMatrices.size(), count);
+    for (size_t i{}; i < count; ++i)
+    {
+        const auto point = points.get(i);
+        const ts::math::Vec3 expectedPoint = transformMatrix * ts::math::Vec4{point.x, point.y, point.z, 1.f};
+        ASSERT_TRUE(isVec3BitEqual(transformedPoints.get(i), expectedPoint));
+        ASSERT_TRUE(isBitEqual(multipliedMatrices.get(i), lhsMatrices.get(i) * rhsMatrices.get(i)));
+        ASSERT_TRUE(isVec3BitEqual(normalizedVectors.get(i), ts::math::normalize(point)));
+    }
+
+    ts::math::Mat4Array shorterMatrices;
+    shorterMatrices.resize(count - 1);
+    ASSERT_THROW(ts::math::multiply(lhsMatrices, shorterMatrices, multipliedMatrices), ts::Exception);
+}
+
 TEST(MathTests, mat4rotationTest)
 {
     const auto matrix = ts::math::Mat4(1.f);
@@ -147,6 +274,1915 @@ TEST(MathTests, mat4rotationTest)
     ASSERT_TRUE(expected[0].x == result[0].x and expected[1].y == result[1].y and expected[2].z == result[2].z);
 }
 
+TEST(MathTests, quaternionTest)
+{
+    const auto isNear = [](const ts::math::Vec3& lhs, const ts::math::Vec3& rhs) {
+        return std::abs(lhs.x - rhs.x) < 1e-5f and std::abs(lhs.y - rhs.y) < 1e-5f and std::abs(lhs.z - rhs.z) < 1e-5f;
+    };
+
+    const ts::math::Vec3 vec{1.f, 2.f, 3.f};
+    const auto yRotation = ts::math::angleAxis(ts::math::radians(90.f), ts::math::Vec3{0.f, 1.f, 0.f});
+    ASSERT_TRUE(isNear(ts::math::rotate(yRotation, vec), ts::math::Vec3{3.f, 2.f, -1.f}));
+
+    const auto xRotation = ts::math::angleAxis(ts::math::radians(90.f), ts::math::Vec3{1.f, 0.f, 0.f});
+    const auto combinedRotation = yRotation * xRotation;
+    ASSERT_TRUE(isNear(ts::math::rotate(combinedRotation, vec), ts::math::rotate(yRotation, ts::math::rotate(xRotation, vec))));
+    ASSERT_TRUE(isNear(ts::math::rotate(ts::math::conjugate(combinedRotation) * combinedRotation, vec), vec));
+
+    const ts::math::Vec3 rotatedByMatrix = ts::math::Mat4{combinedRotation} * ts::math::Vec4{vec.x, vec.y, vec.z, 0.f};
+    ASSERT_TRUE(isNear(rotatedByMatrix, ts::math::rotate(combinedRotation, vec)));
+
+    const auto halfRotation = ts::math::angleAxis(ts::math::radians(45.f), ts::math::Vec3{0.f, 1.f, 0.f});
+    for (const auto interpolatedRotation : {ts::math::slerp({}, yRotation, 0.5f), ts::math::nlerp({}, yRotation, 0.5f)})
+    {
+        ASSERT_TRUE(isNear(ts::math::rotate(interpolatedRotation, vec), ts::math::rotate(halfRotation, vec)));
+    }
+
+    // The same rotation with the opposite sign takes the shorter path too
+    const ts::math::Quat negatedRotation{-yRotation.w, -yRotation.x, -yRotation.y, -yRotation.z};
+    ASSERT_TRUE(isNear(ts::math::rotate(ts::math::slerp({}, negatedRotation, 0.5f), vec), ts::math::rotate(halfRotation, vec)));
+
+    const ts::math::Vec3 translation{4.f, 5.f, 6.f};
+    const ts::math::Vec3 scale{2.f, 3.f, 4.f};
+    const ts::math::Vec3 transformed = ts::math::trs(translation, combinedRotation, scale) * ts::math::Vec4{vec.x, vec.y, vec.z, 1.f};
+    ASSERT_TRUE(isNear(transformed, ts::math::rotate(combinedRotation, ts::math::Vec3{2.f, 6.f, 12.f}) + translation));
+}
+
+TEST(EcsTests, archetypeStorageTest)
+{
+    ts::Registry registry{ts::StorageMode::ARCHETYPES};
+
+    static constexpr size_t entitiesNumber = 1000;
+    std::vector<ts::Entity> entities;
+    for (size_t i{}; i < entitiesNumber; ++i)
+    {
+        auto entity = registry.createEntity();
+        entity.addComponent<ts::TransformComponent>(ts::math::Vec3{static_cast<float>(i)});
+        if (i % 2 == 0)
+        {
+            entity.addComponent<ts::RigidBodyComponent>(static_cast<float>(i));
+        }
+        entities.push_back(entity);
+    }
+    registry.update();
+
+    entities.at(0).removeComponent<ts::RigidBodyComponent>();
+    entities.at(2).kill();
+    registry.update();
+
+    size_t iteratedNumber{};
+    registry.each<ts::TransformComponent, ts::RigidBodyComponent>(
+        [&](const ts::Entity entity, ts::TransformComponent& transform, ts::RigidBodyComponent& rigidBody) {
+            ASSERT_EQ(transform.getPosition().x, rigidBody.velocity);
+            ASSERT_EQ(static_cast<float>(entity.getId()), rigidBody.velocity);
+            iteratedNumber++;
+        });
+
+    ASSERT_EQ(entitiesNumber / 2 - 2, iteratedNumber);
+    ASSERT_FALSE(entities.at(0).hasComponent<ts::RigidBodyComponent>());
+    ASSERT_EQ(999.f, entities.at(999).getComponent<ts::TransformComponent>().getPosition().x);
+}
+
+TEST(EcsTests, sparseSetPoolTest)
+{
+    ts::Pool<ts::RigidBodyComponent> pool;
+
+    static constexpr ts::Id distantEntityId = 5000;
+    pool.set(1, ts::RigidBodyComponent{1.f});
+    pool.set(2, ts::RigidBodyComponent{2.f});
+    pool.set(distantEntityId, ts::RigidBodyComponent{3.f});
+    pool.set(2, ts::RigidBodyComponent{4.f});
+
+    ASSERT_EQ(3, pool.getSize());
+    ASSERT_EQ(4.f, pool.get(2).velocity);
+
+    pool.remove(1);
+
+    ASSERT_EQ(2, pool.getSize());
+    ASSERT_FALSE(pool.has(1));
+    ASSERT_TRUE(pool.has(distantEntityId));
+    ASSERT_EQ(3.f, pool.get(distantEntityId).velocity);
+    ASSERT_EQ(4.f, pool.get(2).velocity);
+
+    pool.removeEntityFromPool(1);
+    pool.removeEntityFromPool(distantEntityId);
+    pool.removeEntityFromPool(2);
+
+    ASSERT_TRUE(pool.isEmpty());
+}
+
+TEST(EcsTests, viewTest)
+{
+    for (const auto storageMode : {ts::StorageMode::POOLS, ts::StorageMode::ARCHETYPES})
+    {
+        ts::Registry registry{storageMode};
+
+        for (size_t i{}; i < 100; ++i)
+        {
+            auto entity = registry.createEntity();
+            entity.addComponent<ts::TransformComponent>(ts::math::Vec3{static_cast<float>(i)});
+            if (i % 10 == 0)
+            {
+                entity.addComponent<ts::RigidBodyComponent>(static_cast<float>(i));
+            }
+        }
+
+        size_t iteratedNumber{};
+        for (auto [transform, rigidBody] : registry.view<ts::TransformComponent, ts::RigidBodyComponent>())
+        {
+            ASSERT_EQ(transform.getPosition().x, rigidBody.velocity);
+            rigidBody.velocity = -1.f;
+            iteratedNumber++;
+        }
+        ASSERT_EQ(10, iteratedNumber);
+
+        auto transforms = registry.view<ts::TransformComponent>();
+        ASSERT_EQ(100, std::distance(transforms.begin(), transforms.end()));
+
+        for (auto it = transforms.begin(); it != transforms.end(); ++it)
+        {
+            if (it.getEntity().hasComponent<ts::RigidBodyComponent>())
+            {
+                ASSERT_EQ(-1.f, it.getEntity().getComponent<ts::RigidBodyComponent>().velocity);
+            }
+        }
+    }
+}
+
+struct WritingTransformSystem : public ts::System
+{
+    WritingTransformSystem()
+    {
+        requireComponent<ts::TransformComponent>();
+        writesComponent<ts::TransformComponent>();
+    }
+};
+
+struct ReadingTransformSystem : public ts::System
+{
+    ReadingTransformSystem()
+    {
+        requireComponent<ts::TransformComponent>();
+        readsComponent<ts::TransformComponent>();
+    }
+};
+
+struct WritingRigidBodySystem : public ts::System
+{
+    WritingRigidBodySystem()
+    {
+        requireComponent<ts::RigidBodyComponent>();
+        writesComponent<ts::RigidBodyComponent>();
+    }
+};
+
+struct TaggingSystem : public ts::System
+{
+    TaggingSystem()
+    {
+        requireComponent<ts::RigidBodyComponent>();
+        readsComponent<ts::RigidBodyComponent>();
+        runsExclusively();
+    }
+};
+
+TEST(EcsTests, systemsSchedulerTest)
+{
+    ts::Registry registry;
+    registry.addSystem<WritingTransformSystem>();
+    registry.addSystem<ReadingTransformSystem>();
+    registry.addSystem<WritingRigidBodySystem>();
+
+    ASSERT_TRUE(registry.getSystem<WritingTransformSystem>().conflictsWith(registry.getSystem<ReadingTransformSystem>()));
+    ASSERT_FALSE(registry.getSystem<WritingTransformSystem>().conflictsWith(registry.getSystem<WritingRigidBodySystem>()));
+    ASSERT_FALSE(registry.getSystem<ReadingTransformSystem>().conflictsWith(registry.getSystem<WritingRigidBodySystem>()));
+
+    // Exclusive system conflicts even with the ones touching other components
+    registry.addSystem<TaggingSystem>();
+    ASSERT_TRUE(registry.getSystem<TaggingSystem>().conflictsWith(registry.getSystem<ReadingTransformSystem>()));
+    ASSERT_TRUE(registry.getSystem<ReadingTransformSystem>().conflictsWith(registry.getSystem<TaggingSystem>()));
+
+    auto entity = registry.createEntity();
+    entity.addComponent<ts::TransformComponent>();
+    entity.addComponent<ts::RigidBodyComponent>();
+    registry.update();
+
+    std::atomic<size_t> executedNumber{};
+    float readPosition{};
+
+    registry.schedule<WritingTransformSystem>([&](WritingTransformSystem& system) {
+        for (const auto systemEntity : system.getSystemEntities())
+        {
+            systemEntity.getComponent<ts::TransformComponent>().setPosition(ts::math::Vec3{5.f});
+        }
+        executedNumber++;
+    });
+
+    registry.schedule<WritingRigidBodySystem>([&](WritingRigidBodySystem& system) {
+        for (const auto systemEntity : system.getSystemEntities())
+        {
+            systemEntity.getComponent<ts::RigidBodyComponent>().velocity = 3.f;
+        }
+        executedNumber++;
+    });
+
+    registry.schedule<ReadingTransformSystem>([&](ReadingTransformSystem& system) {
+        readPosition = system.getSystemEntities().at(0).getComponent<ts::TransformComponent>().getPosition().x;
+        executedNumber++;
+    });
+
+    registry.runScheduledSystems();
+
+    ASSERT_EQ(3, executedNumber);
+    ASSERT_EQ(5.f, readPosition);
+    ASSERT_EQ(3.f, entity.getComponent<ts::RigidBodyComponent>().velocity);
+}
+
+TEST(EcsTests, transformComponentTest)
+{
+    ts::TransformComponent transform{ts::math::Vec3{1.f, 2.f, 3.f}};
+    ts::TransformComponent otherTransform;
+    ASSERT_NE(transform.getVersion(), otherTransform.getVersion());
+
+    const auto translationMat = ts::math::translate(ts::math::Mat4{1.f}, transform.getPosition());
+    ASSERT_EQ(ts::math::to_string(transform.getModelMat()), ts::math::to_string(translationMat));
+
+    const auto version = transform.getVersion();
+    ASSERT_EQ(transform.getVersion(), version);
+
+    const auto rotation = ts::math::angleAxis(ts::math::radians(30.f), ts::math::Vec3{0.f, 0.f, 1.f});
+    transform.setRotation(rotation);
+    transform.setScale(ts::math::Vec3{2.f});
+    ASSERT_GT(transform.getVersion(), version);
+
+    const auto expected = ts::math::trs(transform.getPosition(), rotation, ts::math::Vec3{2.f});
+    ASSERT_EQ(ts::math::to_string(transform.getModelMat()), ts::math::to_string(expected));
+}
+
+TEST(EcsTests, transformHierarchyTest)
+{
+    ts::Registry registry;
+    registry.addSystem<ts::TransformSystem>();
+
+    // Children are created before their parents, so the system has to reorder them
+    auto grandchild = registry.createEntity();
+    auto child = registry.createEntity();
+    auto root = registry.createEntity();
+    auto otherRoot = registry.createEntity();
+    root.addComponent<ts::TransformComponent>(ts::math::Vec3{1.f, 0.f, 0.f});
+    child.addComponent<ts::TransformComponent>(
+        ts::math::Vec3{0.f, 2.f, 0.f},
+        ts::math::angleAxis(ts::math::radians(90.f), ts::math::Vec3{0.f, 0.f, 1.f}));
+    child.addComponent<ts::ParentComponent>(root);
+    grandchild.addComponent<ts::TransformComponent>(ts::math::Vec3{3.f, 0.f, 0.f});
+    grandchild.addComponent<ts::ParentComponent>(child);
+    otherRoot.addComponent<ts::TransformComponent>(ts::math::Vec3{0.f, 0.f, 4.f});
+    registry.update();
+
+    auto& system = registry.getSystem<ts::TransformSystem>();
+    system.update();
+
+    const auto isNear = [](const ts::math::Vec3& lhs, const ts::math::Vec3& rhs) {
+        return std::abs(lhs.x - rhs.x) < 1e-5f and std::abs(lhs.y - rhs.y) < 1e-5f and std::abs(lhs.z - rhs.z) < 1e-5f;
+    };
+
+    const auto& rootTransform = root.getComponent<ts::TransformComponent>();
+    const auto& childTransform = child.getComponent<ts::TransformComponent>();
+    auto& grandchildTransform = grandchild.getComponent<ts::TransformComponent>();
+    const auto& otherRootTransform = otherRoot.getComponent<ts::TransformComponent>();
+    ASSERT_TRUE(isNear(rootTransform.getWorldPosition(), ts::math::Vec3{1.f, 0.f, 0.f}));
+    ASSERT_TRUE(isNear(childTransform.getWorldPosition(), ts::math::Vec3{1.f, 2.f, 0.f}));
+    ASSERT_TRUE(isNear(grandchildTransform.getWorldPosition(), ts::math::Vec3{1.f, 5.f, 0.f}));
+    ASSERT_TRUE(isNear(otherRootTransform.getWorldPosition(), ts::math::Vec3{0.f, 0.f, 4.f}));
+
+    // Nothing has changed
+    const auto rootWorldVersion = rootTransform.getWorldVersion();
+    const auto childWorldVersion = childTransform.getWorldVersion();
+    const auto grandchildWorldVersion = grandchildTransform.getWorldVersion();
+    system.update();
+    ASSERT_EQ(rootWorldVersion, rootTransform.getWorldVersion());
+    ASSERT_EQ(childWorldVersion, childTransform.getWorldVersion());
+    ASSERT_EQ(grandchildWorldVersion, grandchildTransform.getWorldVersion());
+
+    // Only the subtree of the changed transform is recomputed
+    root.getComponent<ts::TransformComponent>().setPosition(ts::math::Vec3{-1.f, 0.f, 0.f});
+    grandchildTransform.setScale(ts::math::Vec3{2.f});
+    const auto otherRootWorldVersion = otherRootTransform.getWorldVersion();
+    system.update();
+    ASSERT_NE(rootWorldVersion, rootTransform.getWorldVersion());
+    ASSERT_NE(childWorldVersion, childTransform.getWorldVersion());
+    ASSERT_EQ(otherRootWorldVersion, otherRootTransform.getWorldVersion());
+    ASSERT_TRUE(isNear(grandchildTransform.getWorldPosition(), ts::math::Vec3{-1.f, 5.f, 0.f}));
+
+    // Reparenting
+    grandchild.getComponent<ts::ParentComponent>().setParent(otherRoot);
+    system.update();
+    ASSERT_TRUE(isNear(grandchildTransform.getWorldPosition(), ts::math::Vec3{3.f, 0.f, 4.f}));
+
+    // Removed parent makes it a root
+    grandchild.removeComponent<ts::ParentComponent>();
+    system.update();
+    ASSERT_TRUE(isNear(grandchildTransform.getWorldPosition(), ts::math::Vec3{3.f, 0.f, 0.f}));
+}
+
+TEST(JobSystemTests, parallelForTest)
+{
+    ts::JobSystem jobSystem{4};
+
+    std::vector<size_t> values(10'000);
+    jobSystem.parallelFor(0, values.size(), [&](const size_t i) { values[i] = i * 2; });
+
+    for (size_t i{}; i < values.size(); ++i)
+    {
+        ASSERT_EQ(i * 2, values[i]);
+    }
+}
+
+TEST(JobSystemTests, nestedJobsTest)
+{
+    for (const size_t threadsNumber : {1, 2, 8})
+    {
+        ts::JobSystem jobSystem{threadsNumber};
+
+        std::atomic<size_t> executedNumber{};
+        ts::JobCounter counter;
+        for (size_t i{}; i < 16; ++i)
+        {
+            jobSystem.run([&] {
+                jobSystem.parallelFor(0, 64, [&](size_t) { executedNumber++; });
+            }, &counter);
+        }
+        jobSystem.wait(counter);
+
+        ASSERT_EQ(16 * 64, executedNumber);
+    }
+}
+
+TEST(JobSystemTests, exceptionPropagationTest)
+{
+    ts::JobSystem jobSystem{2};
+
+    ts::JobCounter counter;
+    jobSystem.run([] { throw std::runtime_error{"job failure"}; }, &counter);
+    jobSystem.run([] {}, &counter);
+
+    ASSERT_THROW(jobSystem.wait(counter), std::runtime_error);
+    ASSERT_TRUE(counter.isDone());
+
+    // Without the workers the waiting thread executes the newest job first, the detached one
+    ts::JobSystem singleThreadJobSystem{1};
+    ts::JobCounter otherCounter;
+    singleThreadJobSystem.run([] {}, &otherCounter);
+    singleThreadJobSystem.run([] { throw std::runtime_error{"detached job failure"}; });
+
+    // Exception of a job without a counter doesn't fail the unrelated work, it's reported once on request
+    singleThreadJobSystem.wait(otherCounter);
+    singleThreadJobSystem.run([] {}, &otherCounter);
+    singleThreadJobSystem.wait(otherCounter);
+    ASSERT_THROW(singleThreadJobSystem.rethrowDetachedException(), std::runtime_error);
+    singleThreadJobSystem.rethrowDetachedException();
+}
+
+TEST(MeshProcessingTests, weldVerticesTest)
+{
+    using Vertex = ts::MeshComponent::Vertex;
+
+    // Two triangles sharing an edge, emitted as one vertex per index
+    const Vertex a{.position{0.f, 0.f, 0.f}, .normal{0.f, 0.f, 1.f}};
+    const Vertex b{.position{1.f, 0.f, 0.f}, .normal{0.f, 0.f, 1.f}};
+    const Vertex c{.position{0.f, 1.f, 0.f}, .normal{0.f, 0.f, 1.f}};
+    const Vertex d{.position{1.f, 1.f, 0.f}, .normal{0.f, 0.f, 1.f}};
+    const Vertex bWithOtherNormal{.position{1.f, 0.f, 0.f}, .normal{0.f, 1.f, 0.f}};
+
+    std::vector<Vertex> vertices{a, b, c, c, b, d, bWithOtherNormal};
+    std::vector<uint32_t> indices{0, 1, 2, 3, 4, 5, 6};
+    const auto originalVertices = vertices;
+
+    ts::weldVertices(vertices, indices);
+
+    ASSERT_EQ(5, vertices.size());
+    ASSERT_EQ(7, indices.size());
+    ASSERT_EQ(indices[1], indices[4]);
+    ASSERT_EQ(indices[2], indices[3]);
+    ASSERT_NE(indices[1], indices[6]);
+    for (size_t i{}; i < indices.size(); ++i)
+    {
+        ASSERT_TRUE(vertices[indices[i]].position == originalVertices[i].position);
+        ASSERT_TRUE(vertices[indices[i]].normal == originalVertices[i].normal);
+    }
+}
+
+TEST(MeshProcessingTests, vertexCacheOptimizationTest)
+{
+    // Grid of quads with the triangles shuffled, like in a badly exported mesh
+    static constexpr uint32_t gridSize{64};
+    static constexpr auto verticesCount = (gridSize + 1) * (gridSize + 1);
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y{}; y < gridSize; ++y)
+    {
+        for (uint32_t x{}; x < gridSize; ++x)
+        {
+            const auto corner = y * (gridSize + 1) + x;
+            triangles.push_back({corner, corner + 1, corner + gridSize + 1});
+            triangles.push_back({corner + 1, corner + gridSize + 2, corner + gridSize + 1});
+        }
+    }
+    std::ranges::shuffle(triangles, std::mt19937{});
+
+    std::vector<uint32_t> indices;
+    for (const auto& triangle : triangles)
+    {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+
+    const auto shuffledStatistics = ts::analyzeVertexCache(indices, verticesCount);
+    ts::optimizeVertexCache(indices, verticesCount);
+    const auto optimizedStatistics = ts::analyzeVertexCache(indices, verticesCount);
+
+    ASSERT_GT(shuffledStatistics.acmr, 2.f);
+    ASSERT_LT(optimizedStatistics.acmr, 1.f);
+    ASSERT_LT(optimizedStatistics.atvr, shuffledStatistics.atvr);
+    ASSERT_GE(optimizedStatistics.atvr, 1.f);
+
+    // The same triangles are kept, with the same winding
+    std::vector<std::array<uint32_t, 3>> optimizedTriangles;
+    for (size_t i{}; i < indices.size(); i += 3)
+    {
+        optimizedTriangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    std::ranges::sort(triangles);
+    std::ranges::sort(optimizedTriangles);
+    ASSERT_TRUE(triangles == optimizedTriangles);
+}
+
+TEST(MeshProcessingTests, vertexFetchOptimizationTest)
+{
+    using Vertex = ts::MeshComponent::Vertex;
+
+    std::vector<Vertex> vertices;
+    for (size_t i{}; i < 5; ++i)
+    {
+        vertices.push_back({.position{static_cast<float>(i)}});
+    }
+    std::vector<uint32_t> indices{4, 2, 0, 0, 2, 3};
+    const auto originalVertices = vertices;
+    const auto originalIndices = indices;
+
+    ts::optimizeVertexFetch(vertices, indices);
+
+    ASSERT_EQ(4, vertices.size());
+    ASSERT_TRUE((indices == std::vector<uint32_t>{0, 1, 2, 2, 1, 3}));
+    for (size_t i{}; i < indices.size(); ++i)
+    {
+        ASSERT_TRUE(vertices[indices[i]].position == originalVertices[originalIndices[i]].position);
+    }
+}
+
+TEST(MeshProcessingTests, packVerticesTest)
+{
+    using Vertex = ts::MeshComponent::Vertex;
+
+    std::vector<Vertex> vertices;
+    std::mt19937 generator{};
+    std::uniform_real_distribution<float> distribution{-10.f, 10.f};
+    for (size_t i{}; i < 1000; ++i)
+    {
+        const ts::math::Vec3 position{distribution(generator), distribution(generator) * 0.1f, distribution(generator) + 100.f};
+        const auto normal = ts::math::normalize(ts::math::Vec3{distribution(generator), distribution(generator), distribution(generator)});
+        vertices.push_back({.position = position, .normal = normal});
+    }
+    vertices.push_back({.position{0.f}, .normal{0.f, 0.f, -1.f}});
+
+    const auto packedVertices = ts::packVertices(vertices);
+    ASSERT_EQ(vertices.size(), packedVertices.vertices.size());
+
+    const auto& scale = packedVertices.positionScale;
+    const auto& bias = packedVertices.positionBias;
+    for (size_t i{}; i < vertices.size(); ++i)
+    {
+        const auto& packedVertex = packedVertices.vertices[i];
+        const auto decode = [](const int16_t value, const float axisScale, const float axisBias) {
+            return std::max(value / 32767.f, -1.f) * axisScale + axisBias;
+        };
+        ASSERT_NEAR(vertices[i].position.x, decode(packedVertex.position[0], scale.x, bias.x), scale.x / 32767.f);
+        ASSERT_NEAR(vertices[i].position.y, decode(packedVertex.position[1], scale.y, bias.y), scale.y / 32767.f);
+        ASSERT_NEAR(vertices[i].position.z, decode(packedVertex.position[2], scale.z, bias.z), scale.z / 32767.f);
+
+        const auto normal = ts::decodeOctahedral(packedVertex.normal);
+        const auto cosine = normal.x * vertices[i].normal.x + normal.y * vertices[i].normal.y + normal.z * vertices[i].normal.z;
+        ASSERT_GT(cosine, 0.99999f);
+    }
+
+    ASSERT_EQ(12, sizeof(ts::MeshComponent::PackedVertex));
+}
+
+namespace
+{
+// Unit sphere with the seam and pole vertices duplicated, like in an exported mesh. The duplicates are at exactly the same
+// positions, so they're welded into one closed surface.
+void makeTestSphere(
+    const uint32_t segments,
+    const uint32_t rings,
+    std::vector<ts::MeshComponent::Vertex>& vertices,
+    std::vector<uint32_t>& indices)
+{
+    for (uint32_t ring{}; ring <= rings; ++ring)
+    {
+        const auto theta = std::numbers::pi_v<float> * static_cast<float>(ring) / static_cast<float>(rings);
+        for (uint32_t segment{}; segment <= segments; ++segment)
+        {
+            const auto phi = 2.f * std::numbers::pi_v<float> * static_cast<float>(segment % segments) / static_cast<float>(segments);
+            auto position = ts::math::Vec3{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+            if ((ring == 0) || (ring == rings))
+            {
+                position = ts::math::Vec3{0.f, (ring == 0) ? 1.f : -1.f, 0.f};
+            }
+            vertices.push_back({.position = position, .normal = position});
+        }
+    }
+
+    for (uint32_t ring{}; ring < rings; ++ring)
+    {
+        for (uint32_t segment{}; segment < segments; ++segment)
+        {
+            const auto corner = ring * (segments + 1) + segment;
+            if (ring != 0)
+            {
+                indices.insert(indices.end(), {corner, corner + 1, corner + segments + 1});
+            }
+            if (ring != rings - 1)
+            {
+                indices.insert(indices.end(), {corner + 1, corner + segments + 2, corner + segments + 1});
+            }
+        }
+    }
+
+    ts::weldVertices(vertices, indices);
+}
+
+ts::math::Vec3 getTriangleNormal(const ts::math::Vec3& a, const ts::math::Vec3& b, const ts::math::Vec3& c)
+{
+    const auto ab = b + (a * -1.f);
+    const auto ac = c + (a * -1.f);
+    return {(ab.y * ac.z) - (ab.z * ac.y), (ab.z * ac.x) - (ab.x * ac.z), (ab.x * ac.y) - (ab.y * ac.x)};
+}
+
+float getTrianglesArea(const std::vector<ts::MeshComponent::Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    float area{};
+    for (size_t i{}; i < indices.size(); i += 3)
+    {
+        const auto normal = getTriangleNormal(
+            vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+        area += std::sqrt((normal.x * normal.x) + (normal.y * normal.y) + (normal.z * normal.z)) / 2.f;
+    }
+
+    return area;
+}
+} // namespace
+
+TEST(MeshProcessingTests, simplifyMeshTest)
+{
+    using Vertex = ts::MeshComponent::Vertex;
+
+    // Inside of a flat grid collapses without any error, its locked border keeps the area
+    static constexpr uint32_t gridSize{16};
+    std::vector<Vertex> gridVertices;
+    for (uint32_t y{}; y <= gridSize; ++y)
+    {
+        for (uint32_t x{}; x <= gridSize; ++x)
+        {
+            gridVertices.push_back({.position{static_cast<float>(x), static_cast<float>(y), 0.f}, .normal{0.f, 0.f, 1.f}});
+        }
+    }
+
+    std::vector<uint32_t> gridIndices;
+    for (uint32_t y{}; y < gridSize; ++y)
+    {
+        for (uint32_t x{}; x < gridSize; ++x)
+        {
+            const auto corner = y * (gridSize + 1) + x;
+            gridIndices.insert(gridIndices.end(), {corner, corner + 1, corner + gridSize + 1});
+            gridIndices.insert(gridIndices.end(), {corner + 1, corner + gridSize + 2, corner + gridSize + 1});
+        }
+    }
+
+    const auto gridError = ts::simplifyMesh(gridVertices, gridIndices, 0);
+    ASSERT_NEAR(gridError, 0.f, 1e-3f);
+    ASSERT_EQ(gridIndices.size() % 3, 0);
+    ASSERT_LT(gridIndices.size(), gridSize * gridSize * 6 / 2);
+    ASSERT_NEAR(getTrianglesArea(gridVertices, gridIndices), static_cast<float>(gridSize * gridSize), 1e-2f);
+
+    // Every triangle keeps facing the same side
+    for (size_t i{}; i < gridIndices.size(); i += 3)
+    {
+        const auto normal = getTriangleNormal(
+            gridVertices[gridIndices[i]].position, gridVertices[gridIndices[i + 1]].position, gridVertices[gridIndices[i + 2]].position);
+        ASSERT_GT(normal.z, 0.f);
+    }
+
+    // Curved surface has an error which stays small compared to its size
+    std::vector<Vertex> sphereVertices;
+    std::vector<uint32_t> sphereIndices;
+    makeTestSphere(48, 24, sphereVertices, sphereIndices);
+    const auto sphereIndicesCount = sphereIndices.size();
+    const auto sphereArea = getTrianglesArea(sphereVertices, sphereIndices);
+
+    const auto sphereError = ts::simplifyMesh(sphereVertices, sphereIndices, sphereIndicesCount / 4);
+    ASSERT_GT(sphereError, 0.f);
+    ASSERT_LT(sphereError, 0.05f);
+    ASSERT_LE(sphereIndices.size(), sphereIndicesCount / 4);
+    ASSERT_GT(sphereIndices.size(), 0);
+    ASSERT_TRUE(std::ranges::all_of(sphereIndices, [&](const uint32_t index) { return index < sphereVertices.size(); }));
+    ASSERT_GT(getTrianglesArea(sphereVertices, sphereIndices), 0.9f * sphereArea);
+}
+
+TEST(MeshProcessingTests, generateLodsTest)
+{
+    std::vector<ts::MeshComponent::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    makeTestSphere(64, 32, vertices, indices);
+
+    const auto lods = ts::generateLods(vertices, indices, ts::MeshComponent::maxLodsCount);
+    ASSERT_GE(lods.size(), 2);
+    ASSERT_LE(lods.size(), ts::MeshComponent::maxLodsCount);
+
+    // Every level has fewer triangles and a larger error than the previous one
+    auto previousIndicesCount = indices.size();
+    auto previousError = 0.f;
+    for (const auto& lod : lods)
+    {
+        ASSERT_EQ(lod.indices.size() % 3, 0);
+        ASSERT_LE(lod.indices.size(), previousIndicesCount * 3 / 4);
+        ASSERT_GT(lod.error, previousError);
+        ASSERT_TRUE(std::ranges::all_of(lod.indices, [&](const uint32_t index) { return index < vertices.size(); }));
+
+        previousIndicesCount = lod.indices.size();
+        previousError = lod.error;
+    }
+}
+
+TEST(MeshProcessingTests, cookedMeshTest)
+{
+    // The blobs are copied as they are, so any byte pattern has to survive the round trip
+    std::vector<ts::GpuVertex> vertices(3);
+    for (size_t i{}; i < vertices.size(); ++i)
+    {
+        std::ranges::fill(std::as_writable_bytes(std::span{&vertices[i], 1}), static_cast<std::byte>(i + 1));
+    }
+    const std::vector<uint32_t> indices{0, 1, 2, 2, 1, 0};
+
+    const ts::cooked_mesh::MeshView mesh{
+        .vertices = vertices,
+        .indices = indices,
+        .positionScale = {1.f, 2.f, 3.f},
+        .positionBias = {4.f, 5.f, 6.f},
+        .boundsMin = {-1.f, -2.f, -3.f},
+        .boundsMax = {7.f, 8.f, 9.f},
+        .lods = {{{.firstIndex = 3, .indexCount = 3, .error = 0.5f}}},
+        .lodsCount = 1,
+    };
+
+    const auto path = std::filesystem::temp_directory_path() / "tsengine_cooked_mesh_test.tsmesh";
+    static constexpr int64_t sourceWriteTime{42};
+    ASSERT_TRUE(ts::cooked_mesh::write(path, sourceWriteTime, mesh));
+
+    {
+        const ts::MappedFile file{path};
+        ASSERT_FALSE(ts::cooked_mesh::read(file, sourceWriteTime + 1).has_value());
+
+        const auto meshView = ts::cooked_mesh::read(file, sourceWriteTime);
+        ASSERT_TRUE(meshView.has_value());
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(meshView->vertices.data()) % ts::cooked_mesh::blobAlignment);
+        ASSERT_EQ(0, reinterpret_cast<uintptr_t>(meshView->indices.data()) % ts::cooked_mesh::blobAlignment);
+        ASSERT_EQ(vertices.size(), meshView->vertices.size());
+        ASSERT_EQ(0, memcmp(vertices.data(), meshView->vertices.data(), meshView->vertices.size_bytes()));
+        ASSERT_TRUE(std::ranges::equal(indices, meshView->indices));
+        ASSERT_TRUE(mesh.positionScale == meshView->positionScale);
+        ASSERT_TRUE(mesh.positionBias == meshView->positionBias);
+        ASSERT_TRUE(mesh.boundsMin == meshView->boundsMin);
+        ASSERT_TRUE(mesh.boundsMax == meshView->boundsMax);
+        ASSERT_EQ(mesh.lodsCount, meshView->lodsCount);
+        ASSERT_TRUE(mesh.lods == meshView->lods);
+        ASSERT_EQ(3, ts::cooked_mesh::getBaseIndicesCount(*meshView));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(MeshProcessingTests, corruptedCookedMeshTest)
+{
+    const std::vector<ts::GpuVertex> vertices(3);
+    const std::vector<uint32_t> indices{0, 1, 2};
+    const ts::cooked_mesh::MeshView mesh{.vertices = vertices, .indices = indices};
+
+    const auto path = std::filesystem::temp_directory_path() / "tsengine_corrupted_cooked_mesh_test.tsmesh";
+    static constexpr int64_t sourceWriteTime{42};
+    ASSERT_TRUE(ts::cooked_mesh::write(path, sourceWriteTime, mesh));
+
+    // Counts whose sizes wrap around to small numbers mustn't pass the bounds checks
+    const auto corruptCount = [&path](const size_t countOffset, const uint64_t count) {
+        std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(static_cast<std::streamoff>(countOffset));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    };
+
+    corruptCount(offsetof(ts::cooked_mesh::Header, indicesCount), (std::numeric_limits<uint64_t>::max() / sizeof(uint32_t)) + 2);
+    {
+        const ts::MappedFile file{path};
+        ASSERT_FALSE(ts::cooked_mesh::read(file, sourceWriteTime).has_value());
+    }
+
+    corruptCount(offsetof(ts::cooked_mesh::Header, indicesCount), indices.size());
+    corruptCount(offsetof(ts::cooked_mesh::Header, verticesCount), (std::numeric_limits<uint64_t>::max() / sizeof(ts::GpuVertex)) + 1);
+    {
+        const ts::MappedFile file{path};
+        ASSERT_FALSE(ts::cooked_mesh::read(file, sourceWriteTime).has_value());
+    }
+
+    // Indices past the vertices mustn't reach the GPU
+    corruptCount(offsetof(ts::cooked_mesh::Header, verticesCount), vertices.size() - 1);
+    {
+        const ts::MappedFile file{path};
+        ASSERT_FALSE(ts::cooked_mesh::read(file, sourceWriteTime).has_value());
+    }
+
+    corruptCount(offsetof(ts::cooked_mesh::Header, verticesCount), vertices.size());
+    {
+        const ts::MappedFile file{path};
+        ASSERT_TRUE(ts::cooked_mesh::read(file, sourceWriteTime).has_value());
+    }
+
+    // Cooked files are byte reproducible
+    const auto otherPath = std::filesystem::temp_directory_path() / "tsengine_reproducible_cooked_mesh_test.tsmesh";
+    ASSERT_TRUE(ts::cooked_mesh::write(path, sourceWriteTime, mesh));
+    ASSERT_TRUE(ts::cooked_mesh::write(otherPath, sourceWriteTime, mesh));
+    const auto readBytes = [](const std::filesystem::path& filePath) {
+        std::ifstream file{filePath, std::ios::binary};
+        return std::vector<char>{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    };
+    ASSERT_EQ(readBytes(path), readBytes(otherPath));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(otherPath);
+}
+
+TEST(DrawListTests, drawKeyTest)
+{
+    const auto key = ts::draw_key::make(-3, 2, 17, 300, 5.f);
+    ASSERT_EQ(ts::draw_key::getPipeline(key), 2);
+    ASSERT_EQ(ts::draw_key::getMaterial(key), 17);
+    ASSERT_EQ(ts::draw_key::getMesh(key), 300);
+
+    // Every field is less significant than the previous one
+    ASSERT_LT(ts::draw_key::make(-1, 9, 999, 999, 999.f), ts::draw_key::make(0, 0, 0, 0, 0.f));
+    ASSERT_LT(ts::draw_key::make(0, 1, 999, 999, 999.f), ts::draw_key::make(0, 2, 0, 0, 0.f));
+    ASSERT_LT(ts::draw_key::make(0, 1, 1, 999, 999.f), ts::draw_key::make(0, 1, 2, 0, 0.f));
+    ASSERT_LT(ts::draw_key::make(0, 1, 1, 1, 999.f), ts::draw_key::make(0, 1, 1, 2, 0.f));
+    ASSERT_LT(ts::draw_key::make(0, 1, 1, 1, 0.5f), ts::draw_key::make(0, 1, 1, 1, 2.f));
+}
+
+TEST(DrawListTests, radixSortTest)
+{
+    std::mt19937 generator{7};
+    std::uniform_int_distribution<int32_t> zDistribution{-2, 2};
+    std::uniform_int_distribution<uint32_t> smallDistribution{0, 3};
+    std::uniform_real_distribution<float> depthDistribution{0.f, 100.f};
+
+    ts::DrawList drawList;
+    std::vector<ts::DrawItem> expected;
+    for (uint32_t i{}; i < 1000; ++i)
+    {
+        const auto key = ts::draw_key::make(
+            zDistribution(generator),
+            smallDistribution(generator),
+            smallDistribution(generator),
+            smallDistribution(generator),
+            (i % 2 == 0) ? 1.f : depthDistribution(generator));
+
+        drawList.add(key, i);
+        expected.push_back({key, i});
+    }
+
+    drawList.sort();
+    std::ranges::stable_sort(expected, std::less{}, &ts::DrawItem::key);
+
+    const auto& items = drawList.getItems();
+    ASSERT_EQ(items.size(), expected.size());
+    for (size_t i{}; i < items.size(); ++i)
+    {
+        ASSERT_EQ(items[i].key, expected[i].key);
+        ASSERT_EQ(items[i].index, expected[i].index);
+    }
+}
+
+TEST(DrawListTests, batchesTest)
+{
+    ts::DrawList drawList;
+    // Meshes differing only by the depth are joined, these without a mesh never are
+    drawList.add(ts::draw_key::make(0, 1, 0, 0, 1.f), 0);
+    drawList.add(ts::draw_key::make(0, 1, 0, 0, 2.f), 1);
+    drawList.add(ts::draw_key::make(0, 2, 1, 1, 1.f), 2);
+    drawList.add(ts::draw_key::make(0, 2, 1, 1, 5.f), 3);
+    drawList.add(ts::draw_key::make(0, 2, 1, 1, 3.f), 4);
+    drawList.add(ts::draw_key::make(0, 2, 2, 1, 1.f), 5);
+    drawList.add(ts::draw_key::make(1, 2, 2, 1, 1.f), 6);
+
+    drawList.sort();
+    drawList.buildBatches();
+
+    const auto& batches = drawList.getBatches();
+    ASSERT_EQ(batches.size(), 5);
+    ASSERT_EQ(batches[0].itemsNumber, 1);
+    ASSERT_EQ(batches[1].itemsNumber, 1);
+    ASSERT_EQ(batches[2].firstItem, 2);
+    ASSERT_EQ(batches[2].itemsNumber, 3);
+    ASSERT_EQ(batches[3].itemsNumber, 1);
+    ASSERT_EQ(batches[4].firstItem, 6);
+}
+
+TEST(DrawListTests, drawStateTrackerTest)
+{
+    ts::DrawStateTracker tracker;
+    tracker.reset();
+
+    ASSERT_TRUE(tracker.shouldBindPipeline(1));
+    ASSERT_FALSE(tracker.shouldBindPipeline(1));
+    ASSERT_TRUE(tracker.shouldBindPipeline(2));
+
+    const auto& statistics = tracker.getStatistics();
+    ASSERT_EQ(statistics.pipelineBinds, 2);
+    ASSERT_EQ(statistics.pipelineBindsSkipped, 1);
+
+    tracker.reset();
+    ASSERT_TRUE(tracker.shouldBindPipeline(2));
+    ASSERT_EQ(tracker.getStatistics().pipelineBindsSkipped, 0);
+}
+
+TEST(DrawListTests, drawCommandBuilderTest)
+{
+    class Drawables : public ts::System
+    {
+    public:
+        Drawables() { requireComponent<ts::RendererComponentBase>(); }
+    };
+
+    class Meshes : public ts::System
+    {
+    public:
+        Meshes()
+        {
+            requireComponent<ts::MeshComponent>();
+            requireComponent<ts::TransformComponent>();
+        }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Drawables>();
+    registry.addSystem<Meshes>();
+    registry.addSystem<ts::TransformSystem>();
+
+    const auto addMesh = [&](const ts::math::Vec3& pos, const size_t firstIndex, const size_t indexCount) {
+        auto entity = registry.createEntity();
+        entity.addComponent<ts::TransformComponent>(pos);
+        entity.addComponent<ts::MeshComponent>();
+        auto& mesh = entity.getComponent<ts::MeshComponent>();
+        mesh.firstIndex = firstIndex;
+        mesh.indexCount = indexCount;
+        return entity;
+    };
+
+    using PbrComponent = ts::RendererComponent<ts::PipelineType::PBR>;
+    const auto gold = PbrComponent::Material::create(PbrComponent::Material::Type::GOLD);
+    std::vector<ts::Entity> spheres;
+    for (const auto distance : {3.f, 1.f, 2.f})
+    {
+        spheres.push_back(addMesh(ts::math::Vec3{distance, 0.f, 0.f}, 0, 36));
+        spheres.back().addComponent<PbrComponent>(gold);
+    }
+
+    auto village = addMesh(ts::math::Vec3{5.f, 0.f, 0.f}, 36, 12);
+    village.addComponent<ts::RendererComponent<ts::PipelineType::NORMAL_LIGHTING>>();
+
+    auto light = registry.createEntity();
+    light.addComponent<ts::TransformComponent>();
+    light.addComponent<ts::RendererComponent<ts::PipelineType::LIGHT>>();
+
+    auto grid = registry.createEntity();
+    grid.addComponent<ts::TransformComponent>();
+    grid.addComponent<ts::RendererComponent<ts::PipelineType::GRID>>();
+
+    registry.update();
+    registry.getSystem<ts::TransformSystem>().update();
+
+    const auto& meshes = registry.getSystem<Meshes>();
+    ts::DrawCommandBuilder builder;
+    builder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
+    builder.build(registry.getSystem<Drawables>().getSystemEntities(), ts::math::Vec3{0.f});
+
+    // Meshes of every pipeline are drawn with one indirect call, the light and the grid are drawn directly
+    const auto& batches = builder.getDrawList().getBatches();
+    ASSERT_EQ(batches.size(), 4);
+
+    const auto& groups = builder.getIndirectGroups();
+    ASSERT_EQ(groups.size(), 2);
+    ASSERT_EQ(groups[0].pipeline, static_cast<uint32_t>(ts::PipelineType::NORMAL_LIGHTING));
+    ASSERT_EQ(groups[0].firstBatch, 0);
+    ASSERT_EQ(groups[1].pipeline, static_cast<uint32_t>(ts::PipelineType::PBR));
+    ASSERT_EQ(groups[1].firstBatch, 1);
+
+    const auto& commands = builder.getIndirectCommands();
+    ASSERT_EQ(commands.size(), 2);
+    ASSERT_EQ(commands[0], (ts::DrawIndexedIndirectCommand{12, 1, 36, 0, 0}));
+    ASSERT_EQ(commands[1], (ts::DrawIndexedIndirectCommand{36, 3, 0, 0, 1}));
+
+    // Instances of the spheres are ordered by their distance to the camera
+    const auto& instanceObjects = builder.getInstanceObjects();
+    ASSERT_EQ(instanceObjects.at(commands[0].firstInstance), builder.getObjectIndex(village));
+    ASSERT_EQ(instanceObjects.at(commands[1].firstInstance + 0), builder.getObjectIndex(spheres[1]));
+    ASSERT_EQ(instanceObjects.at(commands[1].firstInstance + 1), builder.getObjectIndex(spheres[2]));
+    ASSERT_EQ(instanceObjects.at(commands[1].firstInstance + 2), builder.getObjectIndex(spheres[0]));
+}
+
+TEST(DrawListTests, drawCommandBuilderDepthTest)
+{
+    class Drawables : public ts::System
+    {
+    public:
+        Drawables() { requireComponent<ts::RendererComponentBase>(); }
+    };
+
+    class Meshes : public ts::System
+    {
+    public:
+        Meshes()
+        {
+            requireComponent<ts::MeshComponent>();
+            requireComponent<ts::TransformComponent>();
+        }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Drawables>();
+    registry.addSystem<Meshes>();
+    registry.addSystem<ts::TransformSystem>();
+
+    using PbrComponent = ts::RendererComponent<ts::PipelineType::PBR>;
+    std::vector<ts::Entity> spheres;
+    for (const auto distance : {1.f, 3.f, 2.f})
+    {
+        auto sphere = registry.createEntity();
+        sphere.addComponent<ts::TransformComponent>(ts::math::Vec3{distance, 0.f, 0.f});
+        sphere.addComponent<ts::MeshComponent>();
+        sphere.getComponent<ts::MeshComponent>().indexCount = 36;
+        sphere.addComponent<PbrComponent>();
+        spheres.push_back(sphere);
+    }
+
+    // Grid is drawn without any transform, like the one of the engine
+    auto grid = registry.createEntity();
+    grid.addComponent<ts::RendererComponent<ts::PipelineType::GRID>>();
+    registry.update();
+    registry.getSystem<ts::TransformSystem>().update();
+
+    const auto& meshes = registry.getSystem<Meshes>();
+    ts::DrawCommandBuilder builder;
+    builder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
+    builder.build(registry.getSystem<Drawables>().getSystemEntities(), ts::math::Vec3{4.f, 0.f, 0.f});
+
+    ASSERT_EQ(builder.getDrawList().getBatches().size(), 2);
+
+    // Instances are ordered from the eye away from the origin
+    const auto& commands = builder.getIndirectCommands();
+    ASSERT_EQ(commands.size(), 1);
+    const auto& instanceObjects = builder.getInstanceObjects();
+    ASSERT_EQ(instanceObjects.at(commands[0].firstInstance + 0), builder.getObjectIndex(spheres[1]));
+    ASSERT_EQ(instanceObjects.at(commands[0].firstInstance + 1), builder.getObjectIndex(spheres[2]));
+    ASSERT_EQ(instanceObjects.at(commands[0].firstInstance + 2), builder.getObjectIndex(spheres[0]));
+}
+
+TEST(DrawListTests, drawCommandBuilderMaterialsTest)
+{
+    static constexpr size_t spheresNumber{5'000};
+
+    class Meshes : public ts::System
+    {
+    public:
+        Meshes()
+        {
+            requireComponent<ts::MeshComponent>();
+            requireComponent<ts::TransformComponent>();
+        }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Meshes>();
+
+    // More materials than the key has room for
+    using PbrComponent = ts::RendererComponent<ts::PipelineType::PBR>;
+    for (size_t i{}; i < spheresNumber; ++i)
+    {
+        auto sphere = registry.createEntity();
+        sphere.addComponent<ts::TransformComponent>(ts::math::Vec3{static_cast<float>(i), 0.f, 0.f});
+        sphere.addComponent<ts::MeshComponent>();
+        sphere.getComponent<ts::MeshComponent>().indexCount = 36;
+        sphere.addComponent<PbrComponent>(PbrComponent::Material{
+            .color = ts::math::Vec3{static_cast<float>(i), 0.f, 0.f}, .roughness = 0.5f, .metallic = 1.f});
+    }
+    registry.update();
+
+    const auto& meshes = registry.getSystem<Meshes>();
+    ts::DrawCommandBuilder builder;
+    builder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
+    builder.build(meshes.getSystemEntities(), ts::math::Vec3{0.f});
+
+    // Materials are a part of the per object data, the ones past the field of the key share the last command
+    const auto& commands = builder.getIndirectCommands();
+    ASSERT_EQ(commands.size(), (1u << ts::draw_key::materialBits) - 1);
+    ASSERT_EQ(commands.back().instanceCount, spheresNumber - commands.size() + 1);
+
+    // Ids are numbered anew by the next build
+    const auto gold = PbrComponent::Material::create(PbrComponent::Material::Type::GOLD);
+    for (auto sphere : meshes.getSystemEntities())
+    {
+        sphere.getComponent<PbrComponent>().material = gold;
+    }
+    builder.build(meshes.getSystemEntities(), ts::math::Vec3{0.f});
+    ASSERT_TRUE(std::ranges::all_of(builder.getDrawList().getItems(),
+        [](const ts::DrawItem& item) { return ts::draw_key::getMaterial(item.key) == 1; }));
+}
+
+TEST(DrawListTests, lodSelectionTest)
+{
+    ts::MeshComponent mesh;
+    mesh.firstIndex = 0;
+    mesh.indexCount = 600;
+    mesh.boundsMin = ts::math::Vec3{-1.f};
+    mesh.boundsMax = ts::math::Vec3{1.f};
+    mesh.lods[0] = {.firstIndex = 600, .indexCount = 300, .error = 0.01f};
+    mesh.lods[1] = {.firstIndex = 900, .indexCount = 150, .error = 0.1f};
+    mesh.lodsCount = 2;
+
+    const std::array eyePositions{ts::math::Vec3{-0.03f, 0.f, 0.f}, ts::math::Vec3{0.03f, 0.f, 0.f}};
+    const ts::LodSelection selection{.eyePositions = eyePositions, .pixelsPerUnit = 1000.f};
+    const auto selectAt = [&](const float distance, const float scale = 1.f) {
+        const auto worldMat = ts::math::translate(ts::math::Mat4{1.f}, ts::math::Vec3{0.f, 0.f, -distance}) *
+            ts::math::scale(ts::math::Mat4{1.f}, ts::math::Vec3{scale});
+        return ts::lod::select(mesh, worldMat, selection);
+    };
+
+    // Errors cover one pixel at the distances of 10 and 100 from the closest point of the bounds
+    const auto radius = std::sqrt(3.f);
+    ASSERT_EQ(0, selectAt(radius / 2.f));
+    ASSERT_EQ(0, selectAt(radius + 5.f));
+    ASSERT_EQ(1, selectAt(radius + 20.f));
+    ASSERT_EQ(2, selectAt(radius + 200.f));
+    // Larger scale makes the errors larger too
+    ASSERT_EQ(1, selectAt(radius * 10.f + 200.f, 10.f));
+
+    // The closest eye decides
+    const std::array farEyes{ts::math::Vec3{0.f, 0.f, 500.f}, ts::math::Vec3{0.f}};
+    ASSERT_EQ(1, ts::lod::select(mesh, ts::math::translate(ts::math::Mat4{1.f}, ts::math::Vec3{0.f, 0.f, -20.f - radius}),
+        {.eyePositions = farEyes, .pixelsPerUnit = 1000.f}));
+
+    ts::MeshComponent meshWithoutLods;
+    meshWithoutLods.indexCount = 600;
+    ASSERT_EQ(0, ts::lod::select(meshWithoutLods, ts::math::Mat4{1.f}, selection));
+}
+
+TEST(DrawListTests, drawCommandBuilderLodTest)
+{
+    class Drawables : public ts::System
+    {
+    public:
+        Drawables() { requireComponent<ts::RendererComponentBase>(); }
+    };
+
+    class Meshes : public ts::System
+    {
+    public:
+        Meshes()
+        {
+            requireComponent<ts::MeshComponent>();
+            requireComponent<ts::TransformComponent>();
+        }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Drawables>();
+    registry.addSystem<Meshes>();
+    registry.addSystem<ts::TransformSystem>();
+
+    using PbrComponent = ts::RendererComponent<ts::PipelineType::PBR>;
+    const auto gold = PbrComponent::Material::create(PbrComponent::Material::Type::GOLD);
+    std::vector<ts::Entity> spheres;
+    for (const auto distance : {2.f, 50.f, 60.f, 500.f})
+    {
+        auto entity = registry.createEntity();
+        entity.addComponent<ts::TransformComponent>(ts::math::Vec3{0.f, 0.f, -distance});
+        entity.addComponent<ts::MeshComponent>();
+        entity.addComponent<PbrComponent>(gold);
+        auto& mesh = entity.getComponent<ts::MeshComponent>();
+        mesh.indexCount = 600;
+        mesh.boundsMin = ts::math::Vec3{-1.f};
+        mesh.boundsMax = ts::math::Vec3{1.f};
+        mesh.lods[0] = {.firstIndex = 600, .indexCount = 300, .error = 0.01f};
+        mesh.lods[1] = {.firstIndex = 900, .indexCount = 150, .error = 0.1f};
+        mesh.lodsCount = 2;
+        spheres.push_back(entity);
+    }
+
+    registry.update();
+    registry.getSystem<ts::TransformSystem>().update();
+
+    const auto& meshes = registry.getSystem<Meshes>();
+    ts::DrawCommandBuilder builder;
+    builder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
+
+    // Without the selection all of them are drawn with the base level as one batch
+    const auto& drawables = registry.getSystem<Drawables>().getSystemEntities();
+    builder.build(drawables, ts::math::Vec3{0.f});
+    ASSERT_EQ(builder.getIndirectCommands().size(), 1);
+    ASSERT_EQ(builder.getTrianglesNumber(), 4 * 200);
+
+    // Every level is a separate batch with its own range of indices
+    const std::array eyePositions{ts::math::Vec3{0.f}};
+    builder.build(drawables, ts::math::Vec3{0.f}, {}, ts::LodSelection{.eyePositions = eyePositions, .pixelsPerUnit = 1000.f});
+
+    const auto& commands = builder.getIndirectCommands();
+    ASSERT_EQ(commands.size(), 3);
+    ASSERT_EQ(commands[0], (ts::DrawIndexedIndirectCommand{600, 1, 0, 0, 0}));
+    ASSERT_EQ(commands[1], (ts::DrawIndexedIndirectCommand{300, 2, 600, 0, 1}));
+    ASSERT_EQ(commands[2], (ts::DrawIndexedIndirectCommand{150, 1, 900, 0, 3}));
+    ASSERT_EQ(builder.getTrianglesNumber(), 200 + 2 * 100 + 50);
+
+    const auto& instanceObjects = builder.getInstanceObjects();
+    ASSERT_EQ(instanceObjects.at(commands[0].firstInstance), builder.getObjectIndex(spheres[0]));
+    ASSERT_EQ(instanceObjects.at(commands[2].firstInstance), builder.getObjectIndex(spheres[3]));
+}
+
+TEST(DrawListTests, recordingRangesTest)
+{
+    class Drawables : public ts::System
+    {
+    public:
+        Drawables() { requireComponent<ts::RendererComponentBase>(); }
+    };
+
+    class Meshes : public ts::System
+    {
+    public:
+        Meshes()
+        {
+            requireComponent<ts::MeshComponent>();
+            requireComponent<ts::TransformComponent>();
+        }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Drawables>();
+    registry.addSystem<Meshes>();
+    registry.addSystem<ts::TransformSystem>();
+
+    // Every mesh is different, so each of them is a batch with its own indirect command
+    constexpr size_t meshesPerPipeline{10};
+    for (size_t i{}; i < meshesPerPipeline * 2; ++i)
+    {
+        auto entity = registry.createEntity();
+        entity.addComponent<ts::TransformComponent>();
+        entity.addComponent<ts::MeshComponent>();
+        entity.getComponent<ts::MeshComponent>().firstIndex = i * 3;
+        entity.getComponent<ts::MeshComponent>().indexCount = 3;
+        if (i < meshesPerPipeline)
+        {
+            entity.addComponent<ts::RendererComponent<ts::PipelineType::NORMAL_LIGHTING>>();
+        }
+        else
+        {
+            entity.addComponent<ts::RendererComponent<ts::PipelineType::PBR>>();
+        }
+    }
+
+    auto grid = registry.createEntity();
+    grid.addComponent<ts::TransformComponent>();
+    grid.addComponent<ts::RendererComponent<ts::PipelineType::GRID>>();
+
+    registry.update();
+    registry.getSystem<ts::TransformSystem>().update();
+
+    const auto& meshes = registry.getSystem<Meshes>();
+    ts::DrawCommandBuilder builder;
+    builder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
+    builder.build(registry.getSystem<Drawables>().getSystemEntities(), ts::math::Vec3{0.f});
+
+    const auto batchesNumber = builder.getDrawList().getBatches().size();
+    ASSERT_EQ(batchesNumber, meshesPerPipeline * 2 + 1);
+    ASSERT_EQ(builder.getIndirectGroups().size(), 2);
+
+    builder.splitRecording(4, 1);
+    const auto& ranges = builder.getRecordingRanges();
+    const auto& groups = builder.getRecordingGroups();
+    ASSERT_EQ(ranges.size(), 4);
+
+    // Ranges cover all the batches in order and the cut groups cover all the commands once
+    uint32_t nextBatch{};
+    uint32_t nextCommand{};
+    for (const auto& range : ranges)
+    {
+        ASSERT_EQ(range.firstBatch, nextBatch);
+        ASSERT_GT(range.batchesNumber, 0);
+        nextBatch += range.batchesNumber;
+
+        for (uint32_t i{}; i < range.indirectGroupsNumber; ++i)
+        {
+            const auto& group = groups.at(range.firstIndirectGroup + i);
+            ASSERT_GE(group.firstBatch, range.firstBatch);
+            ASSERT_LE(group.firstBatch + group.commandsNumber, range.firstBatch + range.batchesNumber);
+            ASSERT_EQ(group.firstCommand, nextCommand);
+            nextCommand += group.commandsNumber;
+
+            const auto& command = builder.getIndirectCommands().at(group.firstCommand);
+            const auto& item = builder.getDrawList().getItems().at(builder.getDrawList().getBatches().at(group.firstBatch).firstItem);
+            ASSERT_EQ(command.firstInstance, builder.getDrawList().getBatches().at(group.firstBatch).firstItem);
+            ASSERT_EQ(ts::draw_key::getPipeline(item.key), group.pipeline);
+        }
+    }
+    ASSERT_EQ(nextBatch, batchesNumber);
+    ASSERT_EQ(nextCommand, builder.getIndirectCommands().size());
+    ASSERT_GT(groups.size(), builder.getIndirectGroups().size());
+
+    // Too few batches to be worth splitting are recorded at once
+    builder.splitRecording(4, batchesNumber + 1);
+    ASSERT_EQ(builder.getRecordingRanges().size(), 1);
+    ASSERT_EQ(builder.getRecordingGroups().size(), builder.getIndirectGroups().size());
+
+    builder.build({}, ts::math::Vec3{0.f});
+    builder.splitRecording(4, 1);
+    ASSERT_TRUE(builder.getRecordingRanges().empty());
+}
+
+namespace
+{
+// Same layout as the projection made for the headset eyes, the clip depth is in [-w, w]
+ts::math::Mat4 makeTestProjection(const float l, const float r, const float d, const float u, const float nearClip, const float farClip)
+{
+    const auto w = r - l;
+    const auto h = d - u;
+
+    return {
+        2.f / w    , 0.f        , 0.f                                                      , 0.f  ,
+        0.f        , 2.f / h    , 0.f                                                      , 0.f  ,
+        (r + l) / w, (u + d) / h, -(farClip + nearClip) / (farClip - nearClip)             , -1.f ,
+        0.f        , 0.f        , -(farClip * (nearClip + nearClip)) / (farClip - nearClip), 0.f  ,
+    };
+}
+} // namespace
+
+TEST(CullingTests, frustumTest)
+{
+    // Looks down the -z with the 90 degrees field of view
+    const auto frustum = ts::frustum::make(makeTestProjection(-1.f, 1.f, -1.f, 1.f, 0.1f, 100.f));
+    const ts::math::Vec3 smallExtent{0.5f};
+
+    ASSERT_TRUE(ts::frustum::isBoxVisible(frustum, {0.f, 0.f, -5.f}, smallExtent));
+    ASSERT_FALSE(ts::frustum::isBoxVisible(frustum, {0.f, 0.f, 5.f}, smallExtent));
+    ASSERT_FALSE(ts::frustum::isBoxVisible(frustum, {20.f, 0.f, -5.f}, smallExtent));
+    ASSERT_FALSE(ts::frustum::isBoxVisible(frustum, {0.f, -20.f, -5.f}, smallExtent));
+    ASSERT_FALSE(ts::frustum::isBoxVisible(frustum, {0.f, 0.f, -200.f}, smallExtent));
+
+    // Box crossing a plane is visible
+    ASSERT_TRUE(ts::frustum::isBoxVisible(frustum, {5.4f, 0.f, -5.f}, smallExtent));
+    ASSERT_TRUE(ts::frustum::isBoxVisible(frustum, {0.f, 0.f, 5.f}, ts::math::Vec3{10.f}));
+}
+
+TEST(CullingTests, stereoFrustumTest)
+{
+    // Parallel eyes, every one sees a bit more on its outer side
+    constexpr float halfIpd{0.032f};
+    const auto projection = makeTestProjection(-1.f, 1.f, -1.f, 1.f, 0.1f, 100.f);
+    const std::array eyeViewProjs{
+        projection * ts::math::translate(ts::math::Mat4{1.f}, ts::math::Vec3{halfIpd, 0.f, 0.f}),
+        projection * ts::math::translate(ts::math::Mat4{1.f}, ts::math::Vec3{-halfIpd, 0.f, 0.f}),
+    };
+
+    const auto leftFrustum = ts::frustum::make(eyeViewProjs[0]);
+    const auto rightFrustum = ts::frustum::make(eyeViewProjs[1]);
+    const auto frustum = ts::frustum::makeConservative(eyeViewProjs);
+
+    // Every side is bounded by one of the eyes
+    for (const auto& plane : frustum.planes)
+    {
+        ASSERT_NE(ts::math::Vec3(plane), ts::math::Vec3{0.f});
+    }
+
+    // Boxes seen by only one eye aren't culled
+    const ts::math::Vec3 pointExtent{0.001f};
+    const ts::math::Vec3 leftOnly{-10.f - halfIpd * 0.5f, 0.f, -10.f};
+    const ts::math::Vec3 rightOnly{10.f + halfIpd * 0.5f, 0.f, -10.f};
+    ASSERT_TRUE(ts::frustum::isBoxVisible(leftFrustum, leftOnly, pointExtent));
+    ASSERT_FALSE(ts::frustum::isBoxVisible(rightFrustum, leftOnly, pointExtent));
+    ASSERT_TRUE(ts::frustum::isBoxVisible(frustum, leftOnly, pointExtent));
+    ASSERT_FALSE(ts::frustum::isBoxVisible(leftFrustum, rightOnly, pointExtent));
+    ASSERT_TRUE(ts::frustum::isBoxVisible(rightFrustum, rightOnly, pointExtent));
+    ASSERT_TRUE(ts::frustum::isBoxVisible(frustum, rightOnly, pointExtent));
+
+    // Random boxes seen by any eye are never culled
+    std::mt19937 generator{11};
+    std::uniform_real_distribution<float> positionDistribution{-150.f, 150.f};
+    for (size_t i{}; i < 10'000; ++i)
+    {
+        const ts::math::Vec3 center{positionDistribution(generator), positionDistribution(generator), positionDistribution(generator)};
+        if (ts::frustum::isBoxVisible(leftFrustum, center, pointExtent) || ts::frustum::isBoxVisible(rightFrustum, center, pointExtent))
+        {
+            ASSERT_TRUE(ts::frustum::isBoxVisible(frustum, center, pointExtent));
+        }
+    }
+
+    ASSERT_FALSE(ts::frustum::isBoxVisible(frustum, {0.f, 0.f, 10.f}, pointExtent));
+}
+
+TEST(CullingTests, frustumCullerTest)
+{
+    class Drawables : public ts::System
+    {
+    public:
+        Drawables() { requireComponent<ts::RendererComponentBase>(); }
+    };
+
+    class Meshes : public ts::System
+    {
+    public:
+        Meshes()
+        {
+            requireComponent<ts::MeshComponent>();
+            requireComponent<ts::TransformComponent>();
+        }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Drawables>();
+    registry.addSystem<Meshes>();
+    registry.addSystem<ts::TransformSystem>();
+
+    constexpr ts::math::Vec3 scale{2.f};
+    constexpr ts::math::Vec3 boundsMin{-0.5f, -1.f, 0.f};
+    constexpr ts::math::Vec3 boundsMax{0.5f, 1.f, 1.f};
+
+    // Not a multiple of the SIMD width, so the last block is partially used
+    std::mt19937 generator{5};
+    std::uniform_real_distribution<float> positionDistribution{-60.f, 60.f};
+    std::vector<ts::math::Vec3> positions;
+    for (size_t i{}; i < 1'003; ++i)
+    {
+        positions.push_back({positionDistribution(generator), positionDistribution(generator), positionDistribution(generator)});
+
+        auto entity = registry.createEntity();
+        entity.addComponent<ts::TransformComponent>(positions.back(), ts::math::Quat{}, scale);
+        entity.addComponent<ts::MeshComponent>();
+        entity.getComponent<ts::MeshComponent>().boundsMin = boundsMin;
+        entity.getComponent<ts::MeshComponent>().boundsMax = boundsMax;
+        entity.addComponent<ts::RendererComponent<ts::PipelineType::NORMAL_LIGHTING>>();
+    }
+
+    // Entities without a mesh are never culled
+    auto grid = registry.createEntity();
+    grid.addComponent<ts::TransformComponent>(ts::math::Vec3{0.f, 0.f, 1000.f});
+    grid.addComponent<ts::RendererComponent<ts::PipelineType::GRID>>();
+
+    registry.update();
+    registry.getSystem<ts::TransformSystem>().update();
+
+    const auto frustum = ts::frustum::make(makeTestProjection(-1.f, 1.f, -1.f, 1.f, 0.1f, 100.f));
+    const auto& drawables = registry.getSystem<Drawables>();
+    const auto& entities = drawables.getSystemEntities();
+
+    ts::FrustumCuller culler;
+    culler.cull(frustum, entities, drawables.getEntitiesVersion());
+
+    const auto& visibility = culler.getVisibility();
+    ASSERT_EQ(visibility.size(), entities.size());
+
+    size_t visibleNumber{};
+    for (size_t i{}; i < entities.size(); ++i)
+    {
+        if (!entities[i].hasComponent<ts::MeshComponent>())
+        {
+            ASSERT_EQ(visibility[i], 1);
+            ++visibleNumber;
+            continue;
+        }
+
+        const auto& position = entities[i].getComponent<ts::TransformComponent>().getPosition();
+        const ts::math::Vec3 center{
+            position.x + scale.x * (boundsMin.x + boundsMax.x) / 2.f,
+            position.y + scale.y * (boundsMin.y + boundsMax.y) / 2.f,
+            position.z + scale.z * (boundsMin.z + boundsMax.z) / 2.f};
+        const ts::math::Vec3 extent{
+            scale.x * (boundsMax.x - boundsMin.x) / 2.f,
+            scale.y * (boundsMax.y - boundsMin.y) / 2.f,
+            scale.z * (boundsMax.z - boundsMin.z) / 2.f};
+        ASSERT_EQ(visibility[i] == 1, ts::frustum::isBoxVisible(frustum, center, extent));
+        visibleNumber += visibility[i];
+    }
+
+    const auto& statistics = culler.getStatistics();
+    ASSERT_EQ(statistics.visible, visibleNumber);
+    ASSERT_EQ(statistics.visible + statistics.culled, entities.size());
+    ASSERT_GT(statistics.visible, 1);
+    ASSERT_GT(statistics.culled, 0);
+
+    // Moved entity is packed again
+    const auto movedIndex = static_cast<size_t>(std::distance(visibility.begin(), std::ranges::find(visibility, uint8_t{1})));
+    ASSERT_TRUE(entities[movedIndex].hasComponent<ts::MeshComponent>());
+    entities[movedIndex].getComponent<ts::TransformComponent>().setPosition(ts::math::Vec3{0.f, 0.f, 50.f});
+    registry.getSystem<ts::TransformSystem>().update();
+    culler.cull(frustum, entities, drawables.getEntitiesVersion());
+    ASSERT_EQ(culler.getVisibility()[movedIndex], 0);
+    ASSERT_EQ(culler.getStatistics().visible, visibleNumber - 1);
+
+    // Only the visible entities are drawn
+    const auto& meshes = registry.getSystem<Meshes>();
+    ts::DrawCommandBuilder builder;
+    builder.setMeshEntities(meshes.getSystemEntities(), meshes.getEntitiesVersion());
+    builder.build(entities, ts::math::Vec3{0.f}, culler.getVisibility());
+    ASSERT_EQ(builder.getDrawList().getItems().size(), culler.getStatistics().visible);
+}
+
+namespace
+{
+std::vector<ts::Aabb> makeTestBoxes(const size_t boxesNumber, const unsigned seed)
+{
+    std::mt19937 generator{seed};
+    std::uniform_real_distribution<float> positionDistribution{-50.f, 50.f};
+    std::uniform_real_distribution<float> sizeDistribution{0.1f, 3.f};
+
+    std::vector<ts::Aabb> boxes;
+    for (size_t i{}; i < boxesNumber; ++i)
+    {
+        const ts::math::Vec3 min{positionDistribution(generator), positionDistribution(generator), positionDistribution(generator)};
+        boxes.push_back({min, {min.x + sizeDistribution(generator), min.y + sizeDistribution(generator), min.z + sizeDistribution(generator)}});
+    }
+
+    return boxes;
+}
+
+// Compares the queries of the tree with testing every fat box of the proxies
+void checkTreeQueries(const ts::AabbTree& tree, const std::vector<uint32_t>& proxies)
+{
+    ASSERT_TRUE(tree.isValid());
+    ASSERT_EQ(tree.getProxiesNumber(), proxies.size());
+
+    const auto sortedQuery = [](auto&& query) {
+        std::vector<uint32_t> result;
+        query([&result](const uint32_t proxy) { result.push_back(proxy); });
+        std::ranges::sort(result);
+        return result;
+    };
+
+    const ts::math::Vec3 sphereCenter{5.f, -3.f, 10.f};
+    constexpr float sphereRadius{20.f};
+    const auto sphereResult = sortedQuery([&](auto&& func) { tree.querySphere(sphereCenter, sphereRadius, func); });
+    const auto sphereExpected = sortedQuery([&](auto&& func) {
+        for (const auto proxy : proxies)
+        {
+            if (ts::aabb::overlapsSphere(tree.getFatBounds(proxy), sphereCenter, sphereRadius))
+            {
+                func(proxy);
+            }
+        }
+    });
+    ASSERT_FALSE(sphereExpected.empty());
+    ASSERT_EQ(sphereResult, sphereExpected);
+
+    const auto frustum = ts::frustum::make(makeTestProjection(-1.f, 1.f, -1.f, 1.f, 0.1f, 40.f));
+    const auto frustumResult = sortedQuery([&](auto&& func) { tree.queryFrustum(frustum, func); });
+    const auto frustumExpected = sortedQuery([&](auto&& func) {
+        for (const auto proxy : proxies)
+        {
+            const auto& box = tree.getFatBounds(proxy);
+            const ts::math::Vec3 center{(box.min.x + box.max.x) / 2.f, (box.min.y + box.max.y) / 2.f, (box.min.z + box.max.z) / 2.f};
+            const ts::math::Vec3 extent{(box.max.x - box.min.x) / 2.f, (box.max.y - box.min.y) / 2.f, (box.max.z - box.min.z) / 2.f};
+            if (ts::frustum::isBoxVisible(frustum, center, extent))
+            {
+                func(proxy);
+            }
+        }
+    });
+    ASSERT_FALSE(frustumExpected.empty());
+    ASSERT_LT(frustumExpected.size(), proxies.size());
+    ASSERT_EQ(frustumResult, frustumExpected);
+
+    // Aimed at one of the boxes, so at least it is hit
+    const auto& aimedBox = tree.getFatBounds(proxies.back());
+    const ts::math::Vec3 rayOrigin{-80.f, 10.f, -5.f};
+    const ts::math::Vec3 toAimedBox{
+        ((aimedBox.min.x + aimedBox.max.x) / 2.f) - rayOrigin.x,
+        ((aimedBox.min.y + aimedBox.max.y) / 2.f) - rayOrigin.y,
+        ((aimedBox.min.z + aimedBox.max.z) / 2.f) - rayOrigin.z};
+    const ts::Ray ray{rayOrigin, ts::math::normalize(toAimedBox)};
+    constexpr float maxDistance{200.f};
+    const ts::math::Vec3 invDirection{1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z};
+    auto closestDistance = std::numeric_limits<float>::infinity();
+    for (const auto proxy : proxies)
+    {
+        closestDistance = std::min(closestDistance, ts::aabb::intersectRay(tree.getFatBounds(proxy), ray.origin, invDirection, maxDistance));
+    }
+
+    auto closestHit = std::numeric_limits<float>::infinity();
+    tree.raycast(ray, maxDistance, [&](const uint32_t, const float distance) {
+        closestHit = std::min(closestHit, distance);
+        return distance;
+    });
+    ASSERT_LT(closestDistance, maxDistance);
+    ASSERT_FLOAT_EQ(closestHit, closestDistance);
+}
+} // namespace
+
+TEST(SpatialIndexTests, aabbTreeIncrementalTest)
+{
+    auto boxes = makeTestBoxes(2'000, 7);
+
+    ts::AabbTree tree;
+    std::vector<uint32_t> proxies;
+    for (uint32_t i{}; i < boxes.size(); ++i)
+    {
+        proxies.push_back(tree.createProxy(boxes[i], i));
+    }
+    checkTreeQueries(tree, proxies);
+
+    // The rotations keep the tree close to the logarithmic height
+    ASSERT_LT(tree.getHeight(), 40);
+
+    // Small moves stay inside of the fat boxes, large ones reinsert the proxies
+    size_t reinsertedNumber{};
+    for (size_t i{}; i < proxies.size(); i += 3)
+    {
+        const auto offset = (i % 2 == 0) ? 0.05f : 20.f;
+        boxes[i].min.x += offset;
+        boxes[i].max.x += offset;
+        reinsertedNumber += tree.moveProxy(proxies[i], boxes[i]);
+        ASSERT_TRUE(ts::aabb::contains(tree.getFatBounds(proxies[i]), boxes[i]));
+    }
+    ASSERT_GT(reinsertedNumber, 0);
+    ASSERT_LT(reinsertedNumber, (proxies.size() + 2) / 3);
+    checkTreeQueries(tree, proxies);
+
+    // Freed nodes are reused
+    for (size_t i{}; i < proxies.size(); i += 2)
+    {
+        tree.destroyProxy(proxies[i]);
+    }
+    std::erase_if(proxies, [&](const uint32_t proxy) { return tree.getUserData(proxy) % 2 == 0; });
+    for (uint32_t i{}; i < 500; ++i)
+    {
+        proxies.push_back(tree.createProxy(boxes[2 * i], 2 * i));
+    }
+    checkTreeQueries(tree, proxies);
+}
+
+TEST(SpatialIndexTests, aabbTreeBuildTest)
+{
+    auto boxes = makeTestBoxes(3'001, 11);
+    std::vector<uint32_t> userData(boxes.size());
+    std::iota(userData.begin(), userData.end(), 0);
+
+    ts::AabbTree tree;
+    tree.build(boxes, userData);
+    std::vector<uint32_t> proxies(userData);
+    checkTreeQueries(tree, proxies);
+    ASSERT_LE(tree.getHeight(), 13);
+    ASSERT_EQ(tree.getUserData(123), 123);
+
+    // Refit after the bounds of all the proxies changed
+    for (uint32_t i{}; i < boxes.size(); ++i)
+    {
+        boxes[i].min.y += 4.f;
+        boxes[i].max.y += 4.f;
+        tree.setProxyBounds(i, boxes[i]);
+    }
+    tree.refit();
+    checkTreeQueries(tree, proxies);
+
+    // Proxies moved after the build are inserted as usual
+    tree.moveProxy(7, {{100.f, 100.f, 100.f}, {101.f, 101.f, 101.f}});
+    checkTreeQueries(tree, proxies);
+}
+
+TEST(SpatialIndexTests, spatialIndexSystemTest)
+{
+    class Drawables : public ts::System
+    {
+    public:
+        Drawables() { requireComponent<ts::RendererComponentBase>(); }
+    };
+
+    ts::Registry registry;
+    registry.addSystem<Drawables>();
+    registry.addSystem<ts::TransformSystem>();
+    registry.addSystem<ts::SpatialIndexSystem>();
+
+    std::mt19937 generator{3};
+    std::uniform_real_distribution<float> positionDistribution{-60.f, 60.f};
+    for (size_t i{}; i < 1'000; ++i)
+    {
+        auto entity = registry.createEntity();
+        entity.addComponent<ts::TransformComponent>(
+            ts::math::Vec3{positionDistribution(generator), positionDistribution(generator), positionDistribution(generator)});
+        entity.addComponent<ts::MeshComponent>();
+        entity.getComponent<ts::MeshComponent>().boundsMin = ts::math::Vec3{-0.5f};
+        entity.getComponent<ts::MeshComponent>().boundsMax = ts::math::Vec3{0.5f};
+        entity.addComponent<ts::RendererComponent<ts::PipelineType::NORMAL_LIGHTING>>();
+    }
+
+    auto grid = registry.createEntity();
+    grid.addComponent<ts::TransformComponent>();
+    grid.addComponent<ts::RendererComponent<ts::PipelineType::GRID>>();
+
+    auto target = registry.createEntity();
+    target.addComponent<ts::TransformComponent>(ts::math::Vec3{200.f, 0.f, 0.f});
+    target.addComponent<ts::MeshComponent>();
+    target.getComponent<ts::MeshComponent>().boundsMin = ts::math::Vec3{-1.f};
+    target.getComponent<ts::MeshComponent>().boundsMax = ts::math::Vec3{1.f};
+    target.addComponent<ts::RendererComponent<ts::PipelineType::NORMAL_LIGHTING>>();
+
+    registry.update();
+    registry.getSystem<ts::TransformSystem>().update();
+    auto& spatialIndex = registry.getSystem<ts::SpatialIndexSystem>();
+    spatialIndex.update();
+    ASSERT_TRUE(spatialIndex.getTree().isValid());
+    ASSERT_EQ(spatialIndex.getTree().getProxiesNumber(), 1'001);
+
+    // The target is found only at its current place
+    const auto findsTarget = [&](const ts::math::Vec3& center) {
+        auto isFound = false;
+        spatialIndex.querySphere(center, 1.f, [&](const ts::Entity entity) { isFound = isFound || (entity == target); });
+        return isFound;
+    };
+    ASSERT_TRUE(findsTarget({200.f, 0.f, 0.f}));
+
+    target.getComponent<ts::TransformComponent>().setPosition(ts::math::Vec3{0.f, 300.f, 0.f});
+    registry.getSystem<ts::TransformSystem>().update();
+    spatialIndex.update();
+    ASSERT_FALSE(findsTarget({200.f, 0.f, 0.f}));
+    ASSERT_TRUE(findsTarget({0.f, 300.f, 0.f}));
+
+    const auto hit = spatialIndex.raycast({{0.f, 320.f, 0.f}, {0.f, -1.f, 0.f}}, 100.f);
+    ASSERT_TRUE(hit.has_value());
+    ASSERT_EQ(hit->entity, target);
+    ASSERT_FLOAT_EQ(hit->distance, 19.f);
+    ASSERT_FALSE(spatialIndex.raycast({{0.f, 320.f, 0.f}, {0.f, 1.f, 0.f}}, 100.f).has_value());
+
+    // Culling with the tree keeps everything the linear one does, the fat boxes can only add a few more
+    const auto frustum = ts::frustum::make(makeTestProjection(-1.f, 1.f, -1.f, 1.f, 0.1f, 100.f));
+    const auto& drawables = registry.getSystem<Drawables>();
+    ts::FrustumCuller linearCuller, treeCuller;
+    linearCuller.cull(frustum, drawables.getSystemEntities(), drawables.getEntitiesVersion());
+    treeCuller.cull(frustum, drawables.getSystemEntities(), drawables.getEntitiesVersion(), spatialIndex.getTree());
+
+    const auto& linearVisibility = linearCuller.getVisibility();
+    const auto& treeVisibility = treeCuller.getVisibility();
+    ASSERT_EQ(treeVisibility.size(), linearVisibility.size());
+    for (size_t i{}; i < linearVisibility.size(); ++i)
+    {
+        ASSERT_GE(treeVisibility[i], linearVisibility[i]);
+    }
+    ASSERT_GE(treeCuller.getStatistics().visible, linearCuller.getStatistics().visible);
+    ASSERT_LT(treeCuller.getStatistics().visible, linearCuller.getStatistics().visible + 20);
+    ASSERT_EQ(treeCuller.getStatistics().visible + treeCuller.getStatistics().culled, linearVisibility.size());
+}
+
+namespace
+{
+struct DamageEvent : ts::Event
+{
+    // Events are also constructed by the workers queuing them
+    inline static std::atomic<size_t> constructionsNumber{};
+
+    DamageEvent(const uint32_t amount_) : amount{amount_} { constructionsNumber++; }
+
+    uint32_t amount;
+};
+
+struct UnusedEvent : ts::Event
+{
+};
+
+// Keeps the owner alive until the event is destroyed
+struct HeldEvent : ts::Event
+{
+    HeldEvent(std::shared_ptr<int> holder_) : holder{std::move(holder_)} {}
+
+    std::shared_ptr<int> holder;
+};
+
+struct DamageListener
+{
+    void onDamage(DamageEvent& event)
+    {
+        eventsNumber++;
+        damage += event.amount;
+    }
+
+    size_t eventsNumber{};
+    uint64_t damage{};
+};
+
+// Queues a smaller event for every received one, which has to reach the next sync point
+struct ChainListener
+{
+    void onDamage(DamageEvent& event)
+    {
+        if (event.amount > 1)
+        {
+            pBus->queueEvent<DamageEvent>(event.amount / 2);
+        }
+    }
+
+    ts::EventBus* pBus;
+};
+} // namespace
+
+TEST(EventBusTests, emitTest)
+{
+    ts::EventBus bus;
+    DamageListener first, second;
+    bus.subscribeToEvent(&first, &DamageListener::onDamage);
+    bus.subscribeToEvent(&second, &DamageListener::onDamage);
+
+    // One event is shared by all the handlers
+    DamageEvent::constructionsNumber.store(0);
+    bus.emitEvent<DamageEvent>(5u);
+    ASSERT_EQ(DamageEvent::constructionsNumber.load(), 1);
+    ASSERT_EQ(first.damage, 5);
+    ASSERT_EQ(second.damage, 5);
+
+    // Nobody subscribed to it, which isn't an error
+    bus.emitEvent<UnusedEvent>();
+    ASSERT_NE(ts::EventType<DamageEvent>::getId(), ts::EventType<UnusedEvent>::getId());
+}
+
+TEST(EventBusTests, queuedEventsTest)
+{
+    static constexpr size_t eventsNumber{10'000};
+
+    ts::EventBus bus{eventsNumber * 64};
+    DamageListener listener;
+    ChainListener chain{.pBus = &bus};
+    bus.subscribeToEvent(&listener, &DamageListener::onDamage);
+    bus.subscribeToEvent(&chain, &ChainListener::onDamage);
+
+    // Workers queue the events concurrently, nothing is handled before the sync point
+    ts::JobSystem jobSystem{4};
+    jobSystem.parallelFor(0, eventsNumber, [&](const size_t i) {
+        ASSERT_TRUE(bus.queueEvent<DamageEvent>(static_cast<uint32_t>(i % 3)));
+    });
+    ASSERT_EQ(listener.eventsNumber, 0);
+
+    bus.dispatchQueuedEvents();
+    ASSERT_EQ(listener.eventsNumber, eventsNumber);
+    ASSERT_EQ(listener.damage, (eventsNumber / 3) * 3 + ((eventsNumber % 3 == 2) ? 1 : 0));
+
+    // Events of amount 2 queued one of amount 1 during the dispatch
+    bus.dispatchQueuedEvents();
+    ASSERT_EQ(listener.eventsNumber, eventsNumber + eventsNumber / 3);
+    bus.dispatchQueuedEvents();
+    ASSERT_EQ(listener.eventsNumber, eventsNumber + eventsNumber / 3);
+}
+
+TEST(EventBusTests, queuedEventsLifetimeTest)
+{
+    const auto holder = std::make_shared<int>();
+    {
+        ts::EventBus bus{1024};
+
+        // Full arena drops the events without constructing them
+        size_t queuedEventsNumber{};
+        while (bus.queueEvent<HeldEvent>(holder))
+        {
+            queuedEventsNumber++;
+        }
+        ASSERT_GT(queuedEventsNumber, 0);
+        ASSERT_EQ(holder.use_count(), queuedEventsNumber + 1);
+
+        // Events are destroyed after the dispatch even without any handler
+        bus.dispatchQueuedEvents();
+        ASSERT_EQ(holder.use_count(), 1);
+
+        ASSERT_TRUE(bus.queueEvent<HeldEvent>(holder));
+        ASSERT_EQ(holder.use_count(), 2);
+    }
+
+    // Bus destroys the events left in its arenas
+    ASSERT_EQ(holder.use_count(), 1);
+}
+
+TEST(LoggerTests, asyncLoggerTest)
+{
+    static constexpr size_t threadsNumber{4};
+    static constexpr size_t messagesNumber{2'000};
+
+    // Messages of the other tests aren't captured
+    ts::logger::flush();
+    std::ostringstream output;
+    auto* const pConsoleBuffer = std::cout.rdbuf(output.rdbuf());
+    ts::logger::setOverflowPolicy(ts::logger::OverflowPolicy::BLOCK);
+
+    std::vector<std::thread> threads;
+    for (size_t thread{}; thread < threadsNumber; ++thread)
+    {
+        threads.emplace_back([thread] {
+            for (size_t i{}; i < messagesNumber; ++i)
+            {
+                TS_LOG(std::format("logger test {} {}", thread, i).c_str());
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ts::logger::flush();
+    std::cout.rdbuf(pConsoleBuffer);
+
+    // Blocking queue loses nothing and keeps the order of every thread
+    std::array<size_t, threadsNumber> nextIndices{};
+    std::istringstream lines{output.str()};
+    for (std::string line; std::getline(lines, line);)
+    {
+        const auto messageStart = line.find("logger test ");
+        ASSERT_NE(messageStart, std::string::npos);
+
+        size_t thread{}, index{};
+        std::istringstream{line.substr(messageStart + std::string_view{"logger test "}.size())} >> thread >> index;
+        ASSERT_LT(thread, threadsNumber);
+        ASSERT_EQ(index, nextIndices[thread]++);
+    }
+    ASSERT_TRUE(std::ranges::all_of(nextIndices, [](const size_t nextIndex) { return nextIndex == messagesNumber; }));
+}
+
+TEST(LoggerTests, droppingLoggerTest)
+{
+    static constexpr size_t threadsNumber{4};
+    static constexpr size_t messagesNumber{2'000};
+    static constexpr size_t warningInterval{10};
+
+    ts::logger::flush();
+    std::ostringstream output;
+    auto* const pConsoleBuffer = std::cout.rdbuf(output.rdbuf());
+    ts::logger::setOverflowPolicy(ts::logger::OverflowPolicy::DROP);
+
+    std::vector<std::thread> threads;
+    for (size_t thread{}; thread < threadsNumber; ++thread)
+    {
+        threads.emplace_back([] {
+            for (size_t i{}; i < messagesNumber; ++i)
+            {
+                if (i % warningInterval == 0)
+                {
+                    TS_WARN("dropping logger warning");
+                }
+                else
+                {
+                    TS_LOG("dropping logger info");
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ts::logger::flush();
+    std::cout.rdbuf(pConsoleBuffer);
+    ts::logger::setOverflowPolicy(ts::logger::OverflowPolicy::BLOCK);
+
+    // Warnings are never dropped and every dropped info is reported
+    size_t warningsNumber{}, infosNumber{}, droppedNumber{};
+    std::istringstream lines{output.str()};
+    for (std::string line; std::getline(lines, line);)
+    {
+        if (line.find("dropping logger warning") != std::string::npos)
+        {
+            warningsNumber++;
+        }
+        else if (line.find("dropping logger info") != std::string::npos)
+        {
+            infosNumber++;
+        }
+        else if (const auto droppedEnd = line.find(" messages were dropped"); droppedEnd != std::string::npos)
+        {
+            // Number directly follows the end of the formatting
+            const auto droppedStart = line.find_last_not_of("0123456789", droppedEnd - 1) + 1;
+            droppedNumber += std::stoull(line.substr(droppedStart, droppedEnd - droppedStart));
+        }
+    }
+    ASSERT_EQ(warningsNumber, threadsNumber * messagesNumber / warningInterval);
+    ASSERT_EQ(infosNumber + droppedNumber, threadsNumber * (messagesNumber - messagesNumber / warningInterval));
+}
+
 class TestGame final : public ts::TesterEngine
 {
     static constexpr std::chrono::steady_clock::duration renderingDuration{3s};
@@ -69,7 +69,7 @@ void Game::loadLvL()
 
 bool Game::tick(const float dt)
 {
-    ts::getMainReg().getSystem<ExampleSystem>().update();
+    ts::getMainReg().schedule<ExampleSystem>([](ExampleSystem& system) { system.update(); });
 
     return true;
 }
@@ -16,6 +16,12 @@ public:
     ExampleSystem()
     {
         requireComponent<ts::TransformComponent>();
+
+        readsComponent<EchoComponent>();
+        writesComponent<ts::TransformComponent>();
+        writesComponent<ExampleComponent>();
+        // Tags and groups of the entities are read too
+        runsExclusively();
     }
 
     void update()
@@ -52,7 +58,7 @@ public:
                         exampleComponent.endPos,
                         elapsedTime / floatSpheresMovementDuration);
 
-                    entity.getComponent<ts::TransformComponent>().pos = newPos;
+                    entity.getComponent<ts::TransformComponent>().setPosition(newPos);
 
                     if (elapsedTime >= floatSpheresMovementDuration)
                     {